@@ -0,0 +1,286 @@
+#include "anim_cache.h"
+#include "frame_store.h"
+#include <LittleFS.h>
+#include <rom/crc.h>
+
+#define CACHE_DIR "/anim"
+#define CACHE_MAGIC 0x32434E41 // "ANC2"
+#define CACHE_MAX_ENTRIES 16
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t lastUse;      // offset 4: se reescribe en cada uso (LRU)
+    int32_t animId;
+    AnimCacheInfo info;
+    uint32_t payloadBytes;
+    uint32_t crc;          // de todo lo que sigue a la cabecera
+};
+
+// Indice en RAM de lo que hay en flash. Solo desde el core 1 (setup y loop)
+struct CacheEntry {
+    int animId;
+    uint32_t bytes;
+    uint32_t lastUse;
+};
+static CacheEntry entries[CACHE_MAX_ENTRIES];
+static uint8_t entryCount = 0;
+static uint32_t useCounter = 0;
+static bool cacheReady = false;
+
+// Guardado en curso
+static File storeFile;
+static const uint8_t* storeBuffer = nullptr;
+static int storeAnimId = 0;
+static AnimCacheInfo storeInfo;
+static uint8_t storeSlot = 0;
+static uint32_t storeBytes = 0;
+static uint32_t storeCrc = 0;
+static unsigned long storeStart = 0;
+
+static void cachePath(char* out, size_t len, int animId, const char* ext) {
+    snprintf(out, len, CACHE_DIR "/%d.%s", animId, ext);
+}
+
+static int findEntry(int animId) {
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (entries[i].animId == animId) return i;
+    }
+    return -1;
+}
+
+static void removeEntry(int i) {
+    char path[32];
+    cachePath(path, sizeof(path), entries[i].animId, "bin");
+    LittleFS.remove(path);
+    entries[i] = entries[--entryCount];
+}
+
+static uint32_t cacheBytes() {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < entryCount; i++) total += entries[i].bytes;
+    return total;
+}
+
+static uint16_t paletteBytes(const AnimCacheInfo& info) {
+    return info.indexBits ? (2u << info.indexBits) : 0;
+}
+
+static bool readHeader(File& f, int animId, CacheHeader* h) {
+    return f.read((uint8_t*)h, sizeof(*h)) == sizeof(*h) &&
+           h->magic == CACHE_MAGIC && h->animId == animId;
+}
+
+void animCacheInit() {
+    if (ANIM_CACHE_BUDGET == 0) return;
+    if (!LittleFS.begin(true)) {
+        LOG("[Cache] No se pudo montar LittleFS: cache de animaciones desactivada");
+        return;
+    }
+    LittleFS.mkdir(CACHE_DIR);
+
+    // Reconstruir el indice; lo que no es una entrada valida (un .tmp de un
+    // corte a medias, una cabecera de otra version) se borra despues de recorrer
+    entryCount = 0;
+    useCounter = 0;
+    String stale[4];
+    uint8_t staleCount = 0;
+    File dir = LittleFS.open(CACHE_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        String name = f.name();
+        CacheHeader h;
+        bool ok = name.endsWith(".bin") && entryCount < CACHE_MAX_ENTRIES &&
+                  f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && h.magic == CACHE_MAGIC;
+        if (ok) {
+            entries[entryCount++] = {(int)h.animId, (uint32_t)f.size(), h.lastUse};
+            if (h.lastUse > useCounter) useCounter = h.lastUse;
+        } else if (staleCount < 4) {
+            stale[staleCount++] = String(CACHE_DIR "/") + name;
+        }
+        f.close();
+    }
+    dir.close();
+    for (uint8_t i = 0; i < staleCount; i++) LittleFS.remove(stale[i].c_str());
+
+    cacheReady = true;
+    LOGF("[Cache] %d animaciones (%u/%u bytes; LittleFS %u/%u)",
+         entryCount, (unsigned)cacheBytes(), (unsigned)ANIM_CACHE_BUDGET,
+         (unsigned)LittleFS.usedBytes(), (unsigned)LittleFS.totalBytes());
+}
+
+bool animCacheContains(int animId) {
+    if (!cacheReady || animId <= 0) return false;
+    char path[32];
+    cachePath(path, sizeof(path), animId, "bin");
+    return LittleFS.exists(path);
+}
+
+bool animCacheLookup(int animId, AnimCacheInfo* info) {
+    if (!cacheReady || findEntry(animId) < 0) return false;
+    char path[32];
+    cachePath(path, sizeof(path), animId, "bin");
+    File f = LittleFS.open(path, "r");
+    if (!f) return false;
+    CacheHeader h;
+    bool ok = readHeader(f, animId, &h);
+    f.close();
+    if (ok) *info = h.info;
+    return ok;
+}
+
+bool animCacheRead(int animId, uint8_t* buffer, const AnimCacheInfo& info) {
+    int entry = findEntry(animId);
+    if (!cacheReady || entry < 0) return false;
+    char path[32];
+    cachePath(path, sizeof(path), animId, "bin");
+    File f = LittleFS.open(path, "r");
+    if (!f) return false;
+
+    CacheHeader h;
+    bool ok = readHeader(f, animId, &h);
+    uint32_t crc = 0;
+    for (uint8_t slot = 0; ok && slot < info.frameCount; slot++) {
+        uint8_t lenBytes[4];
+        ok = f.read(lenBytes, 4) == 4;
+        uint16_t stored = lenBytes[0] | (lenBytes[1] << 8);
+        uint16_t raw = lenBytes[2] | (lenBytes[3] << 8);
+        uint8_t* dst = ok ? frameStoreAppend(buffer, slot, stored, raw) : nullptr;
+        ok = dst && f.read(dst, stored) == stored;
+        if (!ok) break;
+        crc = crc32_le(crc, lenBytes, 4);
+        crc = crc32_le(crc, dst, stored);
+    }
+    if (ok && info.indexBits) {
+        uint8_t* palette = (uint8_t*)frameStorePalette(buffer);
+        ok = f.read(palette, paletteBytes(info)) == paletteBytes(info);
+        crc = crc32_le(crc, palette, paletteBytes(info));
+    }
+    f.close();
+
+    if (!ok || crc != h.crc) {
+        LOGF("[Cache] Animacion %d corrupta (crc %08x != %08x): se borra", animId, (unsigned)crc, (unsigned)h.crc);
+        removeEntry(entry);
+        return false;
+    }
+
+    // LRU: solo se reescriben los 4 bytes de lastUse
+    uint32_t lastUse = ++useCounter;
+    entries[entry].lastUse = lastUse;
+    File w = LittleFS.open(path, "r+");
+    if (w) {
+        w.seek(offsetof(CacheHeader, lastUse));
+        w.write((const uint8_t*)&lastUse, sizeof(lastUse));
+        w.close();
+    }
+    return true;
+}
+
+void animCacheStoreBegin(int animId, const uint8_t* buffer, const AnimCacheInfo& info) {
+    if (!cacheReady) return;
+    animCacheStoreAbort(); // un guardado anterior a medias
+
+    uint32_t bytes = sizeof(CacheHeader) + paletteBytes(info);
+    for (uint8_t i = 0; i < info.frameCount; i++) {
+        uint16_t stored, raw;
+        frameStoreStored(buffer, i, &stored, &raw);
+        bytes += 4 + stored;
+    }
+    if (bytes > ANIM_CACHE_BUDGET) {
+        LOGF("[Cache] Animacion %d no cabe (%u bytes, presupuesto %u)", animId, (unsigned)bytes, (unsigned)ANIM_CACHE_BUDGET);
+        return;
+    }
+
+    int existing = findEntry(animId);
+    if (existing >= 0) removeEntry(existing);
+
+    // Expulsar por LRU hasta que quepa en el presupuesto (y en la particion)
+    while (entryCount > 0 &&
+           (cacheBytes() + bytes > ANIM_CACHE_BUDGET || entryCount >= CACHE_MAX_ENTRIES ||
+            LittleFS.totalBytes() - LittleFS.usedBytes() < bytes + 8192)) {
+        uint8_t oldest = 0;
+        for (uint8_t i = 1; i < entryCount; i++) {
+            if (entries[i].lastUse < entries[oldest].lastUse) oldest = i;
+        }
+        LOGF("[Cache] Expulsada animacion %d (%u bytes, LRU)", entries[oldest].animId, (unsigned)entries[oldest].bytes);
+        removeEntry(oldest);
+    }
+
+    char path[32];
+    cachePath(path, sizeof(path), animId, "tmp");
+    storeFile = LittleFS.open(path, "w");
+    if (!storeFile) {
+        LOGF("[Cache] No se pudo crear %s", path);
+        return;
+    }
+    // Cabecera provisional: la definitiva (con el crc) se escribe al acabar
+    CacheHeader h = {};
+    storeFile.write((const uint8_t*)&h, sizeof(h));
+
+    storeBuffer = buffer;
+    storeAnimId = animId;
+    storeInfo = info;
+    storeSlot = 0;
+    storeBytes = bytes;
+    storeCrc = 0;
+    storeStart = millis();
+}
+
+static void storeFailed() {
+    char path[32];
+    cachePath(path, sizeof(path), storeAnimId, "tmp");
+    storeFile.close();
+    LittleFS.remove(path);
+    storeBuffer = nullptr;
+}
+
+void animCacheStoreStep() {
+    if (!storeBuffer) return;
+
+    if (storeSlot < storeInfo.frameCount) {
+        uint16_t len, raw;
+        const uint8_t* slot = frameStoreStored(storeBuffer, storeSlot, &len, &raw);
+        uint8_t lenBytes[4] = {(uint8_t)(len & 0xFF), (uint8_t)(len >> 8), (uint8_t)(raw & 0xFF), (uint8_t)(raw >> 8)};
+        if (storeFile.write(lenBytes, 4) != 4 || storeFile.write(slot, len) != len) {
+            LOGF("[Cache] Error escribiendo animacion %d (slot %d): flash llena?", storeAnimId, storeSlot);
+            storeFailed();
+            return;
+        }
+        storeCrc = crc32_le(storeCrc, lenBytes, 4);
+        storeCrc = crc32_le(storeCrc, slot, len);
+        storeSlot++;
+        return;
+    }
+
+    if (storeInfo.indexBits) {
+        const uint8_t* palette = (const uint8_t*)frameStorePalette((uint8_t*)storeBuffer);
+        if (storeFile.write(palette, paletteBytes(storeInfo)) != paletteBytes(storeInfo)) {
+            LOGF("[Cache] Error escribiendo la paleta de la animacion %d", storeAnimId);
+            storeFailed();
+            return;
+        }
+        storeCrc = crc32_le(storeCrc, palette, paletteBytes(storeInfo));
+    }
+
+    CacheHeader h = {CACHE_MAGIC, ++useCounter, storeAnimId, storeInfo, storeBytes - (uint32_t)sizeof(CacheHeader), storeCrc};
+    storeFile.seek(0);
+    storeFile.write((const uint8_t*)&h, sizeof(h));
+    storeFile.close();
+
+    char tmp[32], path[32];
+    cachePath(tmp, sizeof(tmp), storeAnimId, "tmp");
+    cachePath(path, sizeof(path), storeAnimId, "bin");
+    storeBuffer = nullptr;
+    if (!LittleFS.rename(tmp, path)) {
+        LittleFS.remove(tmp);
+        LOGF("[Cache] No se pudo renombrar %s", tmp);
+        return;
+    }
+    entries[entryCount++] = {storeAnimId, storeBytes, h.lastUse};
+    LOGF("[Cache] Animacion %d guardada (%u bytes, %d frames, %lums)",
+         storeAnimId, (unsigned)storeBytes, storeInfo.frameCount, millis() - storeStart);
+}
+
+void animCacheStoreAbort() {
+    if (!storeBuffer) return;
+    LOGF("[Cache] Guardado de la animacion %d abortado", storeAnimId);
+    storeFailed();
+}
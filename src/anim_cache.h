@@ -0,0 +1,57 @@
+#ifndef ANIM_CACHE_H
+#define ANIM_CACHE_H
+
+#include "globals.h"
+
+// Cache de animaciones completas en la particion de datos de flash (LittleFS,
+// 128KB con min_spiffs.csv), por animationId. La rotacion de fotos vuelve a
+// las mismas animaciones: con cache se reproducen sin pedir ningun frame.
+//
+// Un fichero por animacion, /anim/<id>.bin:
+//   [cabecera: layout del buffer, deltas, lastUse, crc32 de lo que sigue]
+//   [por slot: bytes guardados u16 + bytes del slot u16 + los bytes tal como
+//    estan en el buffer (frame_store.h: comprimidos en v2, un delta ocupa
+//    menos que el slot)]
+//   [paleta, si es indexada]
+// Se escribe como .tmp y se renombra al acabar: un corte a medias no deja un
+// fichero valido. Al leerlo se comprueba el crc. Si no cabe en el presupuesto
+// se borran los de lastUse mas antiguo (LRU).
+
+// Bytes de flash para la cache. -DANIM_CACHE_BUDGET=0 la desactiva
+#ifndef ANIM_CACHE_BUDGET
+#define ANIM_CACHE_BUDGET (96 * 1024)
+#endif
+
+// Layout de una animacion guardada (lo necesario para reservar su buffer)
+struct AnimCacheInfo {
+    uint8_t frameCount;
+    uint8_t frameWidth;
+    uint8_t indexBits;
+    uint8_t frameStep;
+    uint16_t slotSize;
+    uint16_t frameInterval;
+    FrameBitset deltaBitmap;
+};
+
+// Montar la particion (formateandola si hace falta) y leer el indice. En setup()
+void animCacheInit();
+
+// ¿Hay fichero para esta animacion? Barato: para streamPhotoResponse (core 0)
+bool animCacheContains(int animId);
+
+// Cabecera de la animacion: layout para reservar el buffer. false si no esta
+bool animCacheLookup(int animId, AnimCacheInfo* info);
+
+// Lee slots y paleta en buffer (recien preparado con frameStoreInit y el
+// layout de animCacheLookup) y marca el uso para el LRU. Si el crc no cuadra
+// borra el fichero y devuelve false.
+bool animCacheRead(int animId, uint8_t* buffer, const AnimCacheInfo& info);
+
+// Guardado incremental de un buffer recien descargado: animCacheStoreStep()
+// escribe un slot por llamada (desde el loop) para no parar el video mientras
+// se escribe la flash. buffer debe seguir vivo hasta acabar o abortar.
+void animCacheStoreBegin(int animId, const uint8_t* buffer, const AnimCacheInfo& info);
+void animCacheStoreStep();
+void animCacheStoreAbort(); // el buffer se va a liberar
+
+#endif
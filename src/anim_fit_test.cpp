@@ -0,0 +1,90 @@
+#include <Arduino.h>
+#include "frame_store.h"
+#include "frame_indexed.h"
+
+// Cuantos frames de animacion caben en v1 (sin PSRAM) con el heap partido:
+// reserva bloques de tamanos variados hasta casi agotar el heap, suelta uno
+// de cada dos y va soltando el resto poco a poco. En cada paso da el bloque
+// libre mas grande y lo que devuelve frameStoreFramesThatFit para RGB565, 8 y
+// 4 bits, y comprueba que ese buffer se puede reservar de verdad dejando el
+// margen: pio run -e test-anim-fit -t upload
+
+#define TEST_LOG(fmt, ...) Serial.printf("[%lu] " fmt "\n", millis(), ##__VA_ARGS__); Serial.flush()
+
+#define FRAG_MAX_BLOCKS 160
+#define FRAG_MIN_FREE (16 * 1024) // lo que se deja libre al partir el heap
+
+static void* blocks[FRAG_MAX_BLOCKS];
+static int blockCount = 0;
+static int fails = 0;
+
+// Bloques de 1 a 6KB hasta dejar FRAG_MIN_FREE; luego fuera los impares, asi
+// que el hueco libre mas grande lo limita el tamano de los bloques
+static void fragmentHeap() {
+    while (blockCount < FRAG_MAX_BLOCKS && ESP.getFreeHeap() > FRAG_MIN_FREE + 6144) {
+        void* p = malloc(1024 + esp_random() % 5120);
+        if (!p) break;
+        blocks[blockCount++] = p;
+    }
+    for (int i = 1; i < blockCount; i += 2) {
+        free(blocks[i]);
+        blocks[i] = nullptr;
+    }
+}
+
+// Frames de un formato y prueba de que el buffer cabe con el margen de 8KB
+static uint8_t checkFit(size_t maxBlock, uint16_t slotSize, uint8_t indexBits) {
+    uint8_t frames = frameStoreFramesThatFit(maxBlock, slotSize, indexBits);
+    if (frames == 0) return 0;
+    size_t bytes = frameStoreBytes(frames, slotSize, indexBits);
+    if (bytes + 8192 > maxBlock) {
+        TEST_LOG("  %d bits: %d frames = %u bytes, no deja el margen en %u", indexBits ? indexBits : 16, frames,
+                 (unsigned)bytes, (unsigned)maxBlock);
+        fails++;
+    }
+    void* buf = malloc(bytes);
+    if (!buf) {
+        TEST_LOG("  %d bits: %d frames = %u bytes, malloc fallo", indexBits ? indexBits : 16, frames, (unsigned)bytes);
+        fails++;
+    }
+    free(buf);
+    return frames;
+}
+
+static void report(const char* step) {
+    size_t maxBlock = ESP.getMaxAllocHeap();
+    uint8_t rgb = checkFit(maxBlock, ANIM_FRAME_SIZE_32, 0);
+    uint8_t idx8 = checkFit(maxBlock, frameIndexedSize(32, 8), 8);
+    uint8_t idx4 = checkFit(maxBlock, frameIndexedSize(32, 4), 4);
+    TEST_LOG("%-12s libre %6u, bloque max %6u: RGB565 %2d, 8 bits %2d, 4 bits %2d frames", step,
+             (unsigned)ESP.getFreeHeap(), (unsigned)maxBlock, rgb, idx8, idx4);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(3000);
+
+    TEST_LOG("==== ANIM FIT TEST ====");
+    report("inicio");
+    fragmentHeap();
+    report("partido");
+
+    // Soltar los bloques que quedan de cuatro en cuatro: los huecos se juntan
+    // y el bloque maximo crece
+    char step[16];
+    int freed = 0;
+    for (int i = 0; i < blockCount; i += 2) {
+        free(blocks[i]);
+        blocks[i] = nullptr;
+        if (++freed % 4 == 0 || i + 2 >= blockCount) {
+            snprintf(step, sizeof(step), "-%d bloques", freed);
+            report(step);
+        }
+    }
+    TEST_LOG("Margen y reserva: %s (%d fallos)", fails == 0 ? "OK" : "FALLO", fails);
+    TEST_LOG("==== FIN ====");
+}
+
+void loop() {
+    delay(1000);
+}
@@ -0,0 +1,152 @@
+#include "anim_window.h"
+
+#define WIN_INITIAL 4          // frames en vuelo al empezar
+#define WIN_RTO_INITIAL 1000   // ms, hasta la primera muestra de RTT
+#define WIN_RTO_MIN 250
+#define WIN_RTO_MAX 5000
+
+// Ventana en octavos de frame: +1/cwnd por frame en congestion avoidance
+static uint16_t cwnd8 = WIN_INITIAL * 8;
+static uint16_t ssthresh8 = MAX_ANIM_FRAMES * 8;
+
+static uint8_t winSlots = 0;
+static FrameBitset seen;          // llegadas ya contabilizadas
+static FrameBitset outstanding;   // pedidos sin respuesta ni vencer
+static FrameBitset resent;        // pedidos mas de una vez (Karn: sin muestra de RTT)
+static unsigned long sentAt[MAX_ANIM_FRAMES];
+
+static long srtt = 0;             // ms; 0 = sin muestras
+static long rttvar = 0;
+static unsigned long rto = WIN_RTO_INITIAL;
+static unsigned long lastCut = 0; // ultimo recorte de la ventana
+static uint16_t losses = 0;
+static unsigned long beganAt = 0;
+
+// Bits de la palabra w de un bitset que caen dentro de la ventana
+static inline uint64_t windowMask(int w) {
+    int base = w * 64;
+    if (base >= winSlots) return 0;
+    return winSlots - base >= 64 ? ~0ULL : (1ULL << (winSlots - base)) - 1;
+}
+
+void animWindowBegin(uint8_t slots, unsigned long now) {
+    winSlots = slots;
+    bitsetResize(seen, slots);
+    bitsetResize(outstanding, slots);
+    bitsetResize(resent, slots);
+    memset(sentAt, 0, sizeof(sentAt));
+    cwnd8 = WIN_INITIAL * 8;
+    ssthresh8 = MAX_ANIM_FRAMES * 8;
+    srtt = 0;
+    rttvar = 0;
+    rto = WIN_RTO_INITIAL;
+    lastCut = now;
+    losses = 0;
+    beganAt = now;
+}
+
+static void sampleRtt(long r) {
+    if (srtt == 0) {
+        srtt = r;
+        rttvar = r / 2;
+    } else {
+        long err = srtt > r ? srtt - r : r - srtt;
+        rttvar = (3 * rttvar + err) / 4;
+        srtt = (7 * srtt + r) / 8;
+    }
+    rto = constrain((unsigned long)(srtt + 4 * rttvar), (unsigned long)WIN_RTO_MIN, (unsigned long)WIN_RTO_MAX);
+}
+
+void animWindowUpdate(const FrameBitset& received, unsigned long now) {
+    for (int w = 0; w < FRAME_BITSET_WORDS; w++) {
+        uint64_t arrived = received.w[w] & ~seen.w[w] & windowMask(w);
+        seen.w[w] |= arrived;
+
+        while (arrived) {
+            uint8_t slot = w * 64 + __builtin_ctzll(arrived);
+            arrived &= arrived - 1;
+            if (bitsetTest(outstanding, slot) && !bitsetTest(resent, slot)) sampleRtt(now - sentAt[slot]);
+            bitsetReset(outstanding, slot);
+
+            if (cwnd8 < ssthresh8) cwnd8 += 8;            // slow start: +1 frame
+            else cwnd8 += max(1, 64 / max((int)cwnd8, 8)); // +1 frame por ventana
+            if (cwnd8 > MAX_ANIM_FRAMES * 8) cwnd8 = MAX_ANIM_FRAMES * 8;
+        }
+    }
+
+    // Pedidos vencidos: vuelven a la cola de huecos y la ventana se parte por
+    // la mitad (una vez por RTT: una rafaga de perdidas cuenta como una)
+    bool expired = false;
+    for (uint16_t slot = bitsetNextSet(outstanding, 0); slot < winSlots;
+         slot = bitsetNextSet(outstanding, slot + 1)) {
+        if (now - sentAt[slot] < rto) continue;
+        bitsetReset(outstanding, slot);
+        losses++;
+        expired = true;
+    }
+    if (expired && now - lastCut >= (unsigned long)max(srtt, (long)WIN_RTO_MIN)) {
+        ssthresh8 = cwnd8 / 2 > 2 * 8 ? cwnd8 / 2 : 2 * 8;
+        cwnd8 = ssthresh8;
+        rto = min(rto * 2, (unsigned long)WIN_RTO_MAX); // backoff hasta la siguiente muestra
+        lastCut = now;
+    }
+}
+
+// Hueco: ni recibido ni pedido
+static inline bool isGap(const FrameBitset& received, uint8_t slot) {
+    return !bitsetTest(received, slot) && !bitsetTest(outstanding, slot);
+}
+
+bool animWindowNext(const FrameBitset& received, uint8_t maxRun, uint8_t minRun, uint8_t* first, uint8_t* last) {
+    int gaps = 0;
+    int slot = -1;
+    for (int w = 0; w < FRAME_BITSET_WORDS; w++) {
+        uint64_t word = ~(received.w[w] | outstanding.w[w]) & windowMask(w);
+        if (word && slot < 0) slot = w * 64 + __builtin_ctzll(word);
+        gaps += __builtin_popcountll(word);
+    }
+    if (!gaps) return false;
+
+    int room = cwnd8 / 8 - bitsetCount(outstanding);
+    int need = min((int)minRun, gaps);
+    if (room < max(need, 1)) return false;
+
+    uint8_t end = slot;
+    int limit = min(room, (int)maxRun);
+    while (end + 1 < winSlots && end + 1 - slot < limit && isGap(received, end + 1)) end++;
+    *first = slot;
+    *last = end;
+    return true;
+}
+
+void animWindowSent(uint8_t first, uint8_t last, unsigned long now) {
+    for (uint16_t slot = first; slot <= last; slot++) {
+        if (sentAt[slot]) bitsetSet(resent, slot);
+        sentAt[slot] = now;
+        bitsetSet(outstanding, slot);
+    }
+}
+
+unsigned long animWindowRto() {
+    return rto;
+}
+
+uint8_t animWindowInFlight() {
+    return bitsetCount(outstanding);
+}
+
+float animWindowCwnd() {
+    return cwnd8 / 8.0f;
+}
+
+unsigned long animWindowSrtt() {
+    return srtt;
+}
+
+uint16_t animWindowLosses() {
+    return losses;
+}
+
+unsigned long animWindowElapsed(unsigned long now) {
+    return now - beganAt;
+}
@@ -0,0 +1,40 @@
+#ifndef ANIM_WINDOW_H
+#define ANIM_WINDOW_H
+
+#include "globals.h"
+
+// Control de flujo de la descarga de frames, al estilo TCP: como mucho
+// cwnd frames pedidos sin respuesta. La ventana crece con cada frame que
+// llega (slow start hasta ssthresh, despues +1 por RTT) y se parte por la
+// mitad cuando un pedido vence su RTO (como mucho una vez por RTT). El RTO
+// sale del RTT medido (RFC 6298, sin muestras de reenvios) y cada frame
+// vencido se vuelve a pedir suelto.
+//
+// Solo la logica: el loop principal (updateAnimationDownload) publica los
+// pedidos. Estado del core 1.
+
+// Nueva descarga de slots frames
+void animWindowBegin(uint8_t slots, unsigned long now);
+
+// Frames recibidos (bitmap de slots): muestras de RTT, crecimiento de la
+// ventana y vencimiento de los pedidos sin respuesta
+void animWindowUpdate(const FrameBitset& received, unsigned long now);
+
+// Siguiente tramo [*first, *last] a pedir (el hueco mas bajo, hasta maxRun
+// slots) si cabe en la ventana. Con minRun > 1 espera a que quepa un tramo de
+// ese tamano (peticiones de rango) salvo que quede menos por pedir.
+bool animWindowNext(const FrameBitset& received, uint8_t maxRun, uint8_t minRun, uint8_t* first, uint8_t* last);
+
+// El tramo se ha publicado
+void animWindowSent(uint8_t first, uint8_t last, unsigned long now);
+
+unsigned long animWindowRto();
+uint8_t animWindowInFlight();
+
+// [Diag]
+float animWindowCwnd();
+unsigned long animWindowSrtt();
+uint16_t animWindowLosses();
+unsigned long animWindowElapsed(unsigned long now);
+
+#endif
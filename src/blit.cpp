@@ -0,0 +1,156 @@
+#include "blit.h"
+#include "frame_delta.h"
+
+// Tramos libres de overlay por fila. Los overlays son unos pocos rectangulos
+// (titulo, autor, reloj, Dev), asi que 6 tramos sobran; una fila mas
+// fragmentada se marca y se pinta con el camino pixel a pixel de siempre.
+#define BLIT_MAX_SPANS 6
+#define BLIT_ROW_FRAGMENTED 0xFF
+
+struct RowSpans {
+    uint8_t count; // tramos validos, o BLIT_ROW_FRAGMENTED
+    uint8_t x0[BLIT_MAX_SPANS];
+    uint8_t len[BLIT_MAX_SPANS];
+};
+
+static RowSpans rowSpans[PANEL_RES_Y];
+
+static void rebuildOverlaySpans() {
+    for (int y = 0; y < PANEL_RES_Y; y++) {
+        RowSpans &rs = rowSpans[y];
+        rs.count = 0;
+
+        // Fila sin overlay (el caso normal): un unico tramo completo
+        bool empty = true;
+        for (int i = 0; i < 8; i++) {
+            if (overlayMask[y][i]) { empty = false; break; }
+        }
+        if (empty) {
+            rs.count = 1;
+            rs.x0[0] = 0;
+            rs.len[0] = PANEL_RES_X;
+            continue;
+        }
+
+        int x = 0;
+        while (x < PANEL_RES_X) {
+            while (x < PANEL_RES_X && overlayMaskGet(x, y)) x++;
+            int start = x;
+            while (x < PANEL_RES_X && !overlayMaskGet(x, y)) x++;
+            if (x == start) break;
+            if (rs.count == BLIT_MAX_SPANS) {
+                rs.count = BLIT_ROW_FRAGMENTED;
+                break;
+            }
+            rs.x0[rs.count] = start;
+            rs.len[rs.count] = x - start;
+            rs.count++;
+        }
+    }
+    overlaySpansDirty = false;
+}
+
+static inline uint16_t be565(const uint8_t* p) {
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+// Emite [x0, x0+len) en las filas y..y+h-1 agrupando pixeles consecutivos del
+// mismo color: una llamada por racha en vez de una por pixel
+template <typename PixelAt>
+static void emitRuns(PixelAt px, int x0, int len, int y, int h) {
+    int x = x0;
+    int end = x0 + len;
+    while (x < end) {
+        uint16_t color = px(x);
+        int run = 1;
+        while (x + run < end && px(x + run) == color) run++;
+        if (h > 1) {
+            dma_display->fillRect(x, y, run, h, color);
+        } else if (run > 1) {
+            dma_display->drawFastHLine(x, y, run, color);
+        } else {
+            dma_display->drawPixel(x, y, color);
+        }
+        x += run;
+    }
+}
+
+static bool sameSpans(const RowSpans &a, const RowSpans &b) {
+    if (a.count != b.count || a.count == BLIT_ROW_FRAGMENTED) return false;
+    for (uint8_t i = 0; i < a.count; i++) {
+        if (a.x0[i] != b.x0[i] || a.len[i] != b.len[i]) return false;
+    }
+    return true;
+}
+
+// [x0, x1) de una fila de panel (h filas iguales) respetando sus tramos
+// libres de overlay
+template <typename PixelAt>
+static void blitPanelRow(PixelAt px, int y, int h, int x0, int x1) {
+    const RowSpans &rs = rowSpans[y];
+    if (rs.count == BLIT_ROW_FRAGMENTED) {
+        for (int row = y; row < y + h; row++) {
+            for (int x = x0; x < x1; x++) {
+                if (!overlayMaskGet(x, row)) dma_display->drawPixel(x, row, px(x));
+            }
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < rs.count; i++) {
+        int s0 = max((int)rs.x0[i], x0);
+        int s1 = min(rs.x0[i] + rs.len[i], x1);
+        if (s0 < s1) emitRuns(px, s0, s1 - s0, y, h);
+    }
+}
+
+void blitAnimationFrame(const uint8_t* frame, uint8_t width) {
+    blitAnimationTiles(frame, width, FRAME_ALL_TILES);
+}
+
+void blitAnimationTiles(const uint8_t* frame, uint8_t width, uint64_t tiles) {
+    if (overlaySpansDirty) {
+        // Un overlay se ha movido o quitado: lo que tapaba se pinto con la
+        // base, asi que este frame va entero
+        rebuildOverlaySpans();
+        tiles = FRAME_ALL_TILES;
+    }
+
+    const int tilePx = PANEL_RES_X / FRAME_TILES_X;
+    for (int ty = 0; ty < FRAME_TILES_X; ty++) {
+        uint8_t bits = tiles >> (ty * FRAME_TILES_X);
+        int tx = 0;
+        while (bits) {
+            // Tiles contiguos de la fila de tiles como un solo tramo
+            while (!(bits & 1)) { bits >>= 1; tx++; }
+            int tx0 = tx;
+            while (bits & 1) { bits >>= 1; tx++; }
+            int x0 = tx0 * tilePx, x1 = tx * tilePx;
+
+            if (width == 64) {
+                for (int y = ty * tilePx; y < (ty + 1) * tilePx; y++) {
+                    const uint8_t* row = frame + y * 64 * 2;
+                    blitPanelRow([row](int x) { return be565(row + x * 2); }, y, 1, x0, x1);
+                }
+                continue;
+            }
+
+            // 32x32 escalado x2: si las dos filas de panel tienen los mismos
+            // tramos (lo normal), cada racha sale como un fillRect de 2 filas
+            for (int y = ty * tilePx / 2; y < (ty + 1) * tilePx / 2; y++) {
+                const uint8_t* row = frame + y * 32 * 2;
+                auto px = [row](int x) { return be565(row + (x >> 1) * 2); };
+                int py = y * 2;
+                if (sameSpans(rowSpans[py], rowSpans[py + 1])) {
+                    blitPanelRow(px, py, 2, x0, x1);
+                } else {
+                    blitPanelRow(px, py, 1, x0, x1);
+                    blitPanelRow(px, py + 1, 1, x0, x1);
+                }
+            }
+        }
+    }
+}
+
+void blitRow565(int y, int x0, int len, const uint16_t* src) {
+    emitRuns([src](int x) { return src[x]; }, x0, len, y, 1);
+}
@@ -0,0 +1,22 @@
+#ifndef BLIT_H
+#define BLIT_H
+
+#include "globals.h"
+
+// Volcado de frames/filas al panel por tramos (spans) en vez de pixel a pixel.
+// La overlayMask se precalcula como tramos libres por fila (se recalcula sola
+// cuando la mascara cambia) y dentro de cada tramo los pixeles consecutivos
+// del mismo color salen en una sola llamada (drawFastHLine/fillRect).
+
+// Frame de animacion RGB565 big-endian (64x64, o 32x32 escalado x2),
+// respetando la overlayMask
+void blitAnimationFrame(const uint8_t* frame, uint8_t width);
+
+// Solo los tiles de la mascara (frame_delta.h): lo que cambio desde el frame
+// anterior. Si la overlayMask ha cambiado pinta el frame entero.
+void blitAnimationTiles(const uint8_t* frame, uint8_t width, uint64_t tiles);
+
+// Tramo [x0, x0+len) de la fila y desde un buffer RGB565 nativo. Sin mascara.
+void blitRow565(int y, int x0, int len, const uint16_t* src);
+
+#endif
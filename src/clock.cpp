@@ -1,9 +1,19 @@
 #include "clock.h"
+#include "compositor.h"
+#include "text_strip.h"
 #include <Fonts/FreeSans12pt7b.h>
-#include <Fonts/Picopixel.h>
+
+// Badges de reloj y Dev, rasterizados al cambiar y compuestos por el compositor
+static TextStrip clockStrip;
+static int clockTextX, clockTextY;
+#ifdef DEV_MODE
+static TextStrip devStrip;
+static int devTextX, devTextY;
+#endif
 
 void showTime()
 {
+    compositorReset(); // pantalla completa: los overlays anteriores desaparecen
     dma_display->clearScreen();
     // Añadir offset local para mostrar (UTC+2 para España)
     int localHours = (timeClient.getHours() + 2) % 24;
@@ -17,36 +27,36 @@ void showTime()
     LOGF("Hora: %s", currentTime.c_str());
 }
 
-void showDevOverlay() {
 #ifdef DEV_MODE
-    dma_display->setFont(&Picopixel);
-    dma_display->setTextSize(1);
+static uint16_t devLayerPixel(int x, int y) {
+    return textStripGet(devStrip, x - devTextX, y - devTextY) ? dma_display->color565(255, 50, 50) : myBLACK; // Rojo
+}
+#endif
 
-    int16_t x1, y1;
-    uint16_t w, h;
-    dma_display->getTextBounds("Dev", 0, 0, &x1, &y1, &w, &h);
+void showDevOverlay() {
+#ifdef DEV_MODE
+    textStripRender(devStrip, "Dev");
 
-    int xPos = 2;       // 2px margen izquierdo
-    int yPos = h;        // texto 1px más arriba
+    int xPos = 2;              // 2px margen izquierdo
+    int yPos = devStrip.h;     // texto 1px más arriba
+    devTextX = xPos + devStrip.x1;
+    devTextY = yPos + devStrip.y1;
 
-    dma_display->fillRect(0, 0, w + 4, h + 2, myBLACK);
-    dma_display->setTextColor(dma_display->color565(255, 50, 50)); // Rojo
-    dma_display->setCursor(xPos, yPos);
-    dma_display->print("Dev");
+    LayerRect box = {0, 0, (int16_t)(devStrip.w + 4), (int16_t)(devStrip.h + 2)};
+    compositorSetLayer(LAYER_DEV, &box, 1, devLayerPixel);
+    compositorFlush();
 #endif
 }
 
 void hideClockOverlay() {
-    // Restaurar píxeles originales de la foto en la zona del reloj
-    // Usamos un área generosa en la esquina superior derecha
-    int rectX = PANEL_RES_X - 30;
-    int rectW = 30;
-    int rectH = 8;
-    for (int y = 0; y < rectH; y++) {
-        for (int x = rectX; x < PANEL_RES_X; x++) {
-            dma_display->drawPixel(x, y, screenBuffer[y][x]);
-        }
-    }
+    // La foto (o el frame de video, en el siguiente tick) vuelve a verse bajo
+    // la caja del reloj
+    compositorClearLayer(LAYER_CLOCK);
+    compositorFlush();
+}
+
+static uint16_t clockLayerPixel(int x, int y) {
+    return textStripGet(clockStrip, x - clockTextX, y - clockTextY) ? myWHITE : myBLACK;
 }
 
 void showClockOverlay() {
@@ -59,23 +69,18 @@ void showClockOverlay() {
     int localHour = localTotalMinutes / 60;
     int localMinute = localTotalMinutes % 60;
 
-    String timeStr = String(localHour < 10 ? "0" : "") + String(localHour) + ":" +
-                     String(localMinute < 10 ? "0" : "") + String(localMinute);
+    char timeStr[6];
+    snprintf(timeStr, sizeof(timeStr), "%02d:%02d", localHour, localMinute);
+    textStripRender(clockStrip, timeStr);
 
-    dma_display->setFont(&Picopixel);
-    dma_display->setTextSize(1);
-
-    // Medir texto para posicionar a la derecha
-    int16_t x1, y1;
-    uint16_t w, h;
-    dma_display->getTextBounds(timeStr, 0, 0, &x1, &y1, &w, &h);
-
-    int xPos = PANEL_RES_X - w - 2;  // 2px margen derecho
-    int yPos = h;                      // texto 1px más arriba
+    // Posicionar a la derecha
+    int xPos = PANEL_RES_X - clockStrip.w - 2;  // 2px margen derecho
+    int yPos = clockStrip.h;                     // texto 1px más arriba
+    clockTextX = xPos + clockStrip.x1;
+    clockTextY = yPos + clockStrip.y1;
 
     // Fondo negro para legibilidad
-    dma_display->fillRect(xPos - 1, 0, w + 3, h + 2, myBLACK);
-    dma_display->setTextColor(myWHITE);
-    dma_display->setCursor(xPos, yPos);
-    dma_display->print(timeStr);
+    LayerRect box = {(int16_t)(xPos - 1), 0, (int16_t)(clockStrip.w + 3), (int16_t)(clockStrip.h + 2)};
+    compositorSetLayer(LAYER_CLOCK, &box, 1, clockLayerPixel);
+    compositorFlush();
 }
@@ -0,0 +1,23 @@
+#ifndef COLOR_PIPELINE_H
+#define COLOR_PIPELINE_H
+
+#include "globals.h"
+#include "pixel_kernels.h"
+
+// Conversion 888 -> 565 de fotos y frames: gamma por tabla + dither ordenado
+// 4x4 (Bayer). Truncar a 5/6 bits deja escalones visibles en los degradados;
+// el dither reparte el error entre pixeles vecinos con un patron fijo, asi que
+// una foto estatica no parpadea. Corre una vez por foto/frame recibido (core 0),
+// nunca por paso de fundido.
+
+// Gamma sobre el 888 del backend, tabla fija en flash. El driver HUB75 trata
+// cada valor como luminosidad CIE1931 (L*) al pintar, pero las fotos vienen
+// en sRGB: la tabla pasa de una curva a la otra.
+extern const uint8_t colorGammaLut[256];
+
+// Pixel de foto 888 del backend: gamma + dither (pkDither565)
+static inline uint16_t photoPixelTo565(uint8_t r, uint8_t g, uint8_t b, int x, int y) {
+    return pkDither565(colorGammaLut[r], colorGammaLut[g], colorGammaLut[b], x, y);
+}
+
+#endif
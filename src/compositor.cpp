@@ -0,0 +1,136 @@
+#include "compositor.h"
+
+// Rectangulos de dano pendientes. Los que se solapan se funden; si se llena,
+// el ultimo absorbe al nuevo (peor caso: se recompone algo de mas)
+#define MAX_DAMAGE_RECTS 8
+
+struct LayerState {
+    LayerRect rects[LAYER_MAX_RECTS];
+    uint8_t count;
+    LayerPixelFn pixel;
+};
+
+static LayerState layers[LAYER_COUNT] = {};
+static LayerRect damage[MAX_DAMAGE_RECTS];
+static uint8_t damageCount = 0;
+
+static bool rectContains(const LayerRect &r, int x, int y) {
+    return x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h;
+}
+
+static bool rectsTouch(const LayerRect &a, const LayerRect &b) {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+static void rectUnion(LayerRect &a, const LayerRect &b) {
+    int x0 = min(a.x, b.x), y0 = min(a.y, b.y);
+    int x1 = max(a.x + a.w, b.x + b.w), y1 = max(a.y + a.h, b.y + b.h);
+    a.x = x0;
+    a.y = y0;
+    a.w = x1 - x0;
+    a.h = y1 - y0;
+}
+
+static void rebuildOverlayMask() {
+    overlayMaskClear();
+    for (int l = 0; l < LAYER_COUNT; l++) {
+        for (uint8_t i = 0; i < layers[l].count; i++) {
+            const LayerRect &r = layers[l].rects[i];
+            for (int y = max(0, (int)r.y); y < min(PANEL_RES_Y, r.y + r.h); y++) {
+                for (int x = max(0, (int)r.x); x < min(PANEL_RES_X, r.x + r.w); x++) {
+                    overlayMaskSet(x, y);
+                }
+            }
+        }
+    }
+}
+
+void compositorDamage(int x, int y, int w, int h) {
+    int x0 = max(x, 0), y0 = max(y, 0);
+    int x1 = min(x + w, PANEL_RES_X), y1 = min(y + h, PANEL_RES_Y);
+    if (x0 >= x1 || y0 >= y1) return;
+    LayerRect r = {(int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+
+    for (uint8_t i = 0; i < damageCount; i++) {
+        if (rectsTouch(damage[i], r)) {
+            rectUnion(damage[i], r);
+            return;
+        }
+    }
+    if (damageCount < MAX_DAMAGE_RECTS) {
+        damage[damageCount++] = r;
+    } else {
+        rectUnion(damage[MAX_DAMAGE_RECTS - 1], r);
+    }
+}
+
+void compositorSetLayer(Layer layer, const LayerRect *rects, uint8_t count, LayerPixelFn pixel) {
+    LayerState &ls = layers[layer];
+    if (count > LAYER_MAX_RECTS) count = LAYER_MAX_RECTS;
+
+    bool moved = ls.count != count;
+    for (uint8_t i = 0; i < ls.count; i++) {
+        const LayerRect &r = ls.rects[i];
+        if (!moved && memcmp(&r, &rects[i], sizeof(LayerRect)) != 0) moved = true;
+        compositorDamage(r.x, r.y, r.w, r.h);
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        ls.rects[i] = rects[i];
+        compositorDamage(rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+    }
+    ls.count = count;
+    ls.pixel = pixel;
+
+    if (moved) rebuildOverlayMask();
+}
+
+void compositorClearLayer(Layer layer) {
+    compositorSetLayer(layer, nullptr, 0, nullptr);
+}
+
+void compositorReset() {
+    for (int l = 0; l < LAYER_COUNT; l++) {
+        layers[l].count = 0;
+        layers[l].pixel = nullptr;
+    }
+    damageCount = 0;
+    rebuildOverlayMask();
+}
+
+bool compositorLayerVisible(Layer layer) {
+    return layers[layer].count > 0;
+}
+
+// Color final de (x, y): la capa mas alta que lo cubre, o la base
+static uint16_t composePixel(int x, int y) {
+    for (int l = LAYER_COUNT - 1; l >= 0; l--) {
+        const LayerState &ls = layers[l];
+        for (uint8_t i = 0; i < ls.count; i++) {
+            if (rectContains(ls.rects[i], x, y)) return ls.pixel(x, y);
+        }
+    }
+    return screenBuffer[y][x];
+}
+
+void compositorFlush() {
+    for (uint8_t i = 0; i < damageCount; i++) {
+        const LayerRect &r = damage[i];
+        for (int y = r.y; y < r.y + r.h; y++) {
+            // Por rachas del mismo color, como el blit de frames
+            int x = r.x;
+            int end = r.x + r.w;
+            while (x < end) {
+                uint16_t color = composePixel(x, y);
+                int run = 1;
+                while (x + run < end && composePixel(x + run, y) == color) run++;
+                if (run > 1) {
+                    dma_display->drawFastHLine(x, y, run, color);
+                } else {
+                    dma_display->drawPixel(x, y, color);
+                }
+                x += run;
+            }
+        }
+    }
+    damageCount = 0;
+}
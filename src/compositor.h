@@ -0,0 +1,41 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include "globals.h"
+
+// Compositor de overlays sobre la foto/video. Capas en orden (de abajo a
+// arriba): base (screenBuffer, o el frame de video), texto (titulo/autor),
+// reloj y badge Dev. Cada capa de overlay es un par de rectangulos opacos con
+// una funcion que da el color de cada pixel. Los cambios se acumulan como
+// rectangulos de dano y compositorFlush() solo re-emite esos pixeles, ya
+// resueltos con la capa superior que los cubre. La overlayMask que usa el
+// blit de video se deriva de los rectangulos de las capas.
+
+enum Layer : uint8_t {
+    LAYER_TEXT,
+    LAYER_CLOCK,
+    LAYER_DEV,
+    LAYER_COUNT
+};
+
+#define LAYER_MAX_RECTS 2
+
+struct LayerRect {
+    int16_t x, y, w, h;
+};
+
+// Color de la capa en (x, y); solo se llama dentro de sus rectangulos
+typedef uint16_t (*LayerPixelFn)(int x, int y);
+
+// Sustituye los rectangulos/contenido de una capa (dana los viejos y los nuevos)
+void compositorSetLayer(Layer layer, const LayerRect *rects, uint8_t count, LayerPixelFn pixel);
+void compositorClearLayer(Layer layer);
+// Olvida todas las capas sin repintar: quien llama va a pintar la pantalla entera
+void compositorReset();
+bool compositorLayerVisible(Layer layer);
+
+// Marca una zona para recomponer (p.ej. el contenido de una capa cambio)
+void compositorDamage(int x, int y, int w, int h);
+void compositorFlush();
+
+#endif
@@ -0,0 +1,155 @@
+#include <Arduino.h>
+#include "mqtt_topics.h"
+
+// Comprueba el despacho de topics de respuesta (mqtt_topics.h) con la tabla
+// de produccion (mqtt_routes.cpp) y mide su coste por mensaje frente a la
+// cadena de String/endsWith de antes: pio run -e test-dispatch -t upload
+
+#define LOG(fmt, ...) Serial.printf("[%lu] " fmt "\n", millis(), ##__VA_ARGS__); Serial.flush()
+
+#define BENCH_ITERS 20000
+
+// Los handlers de mqtt_handlers.h que enlaza la tabla: cada uno deja su
+// nombre en hit para ver a quien se despacho
+static const char* hit = nullptr;
+void streamAnimationDeltaResponse(uint32_t) { hit = "streamAnimationDeltaResponse"; }
+void streamAnimationFrameResponse(uint32_t) { hit = "streamAnimationFrameResponse"; }
+void streamAnimationFramesResponse(uint32_t) { hit = "streamAnimationFramesResponse"; }
+void handleAnimationPaletteResponse(byte*, unsigned int) { hit = "handleAnimationPaletteResponse"; }
+void handleConfigResponse(byte*, unsigned int) { hit = "handleConfigResponse"; }
+void streamCoverResponse(uint32_t) { hit = "streamCoverResponse"; }
+void handleOtaResponse(byte*, unsigned int) { hit = "handleOtaResponse"; }
+void streamPhotoResponse(uint32_t) { hit = "streamPhotoResponse"; }
+void handleRegisterResponse(byte*, unsigned int) { hit = "handleRegisterResponse"; }
+void handleSongResponse(byte*, unsigned int) { hit = "handleSongResponse"; }
+
+// Lo que publica el backend en frame/<id>/response/... y quien lo atiende.
+// stream: se lee del socket (mqttStreamHandler), si no llega a mqttCallback
+struct ExpectedRoute {
+    const char* suffix;
+    const char* handler;
+    bool stream;
+};
+
+static const ExpectedRoute expected[] = {
+    {"photo", "streamPhotoResponse", true},
+    {"cover", "streamCoverResponse", true},
+    {"animation/frame", "streamAnimationFrameResponse", true},
+    {"animation/frames", "streamAnimationFramesResponse", true},
+    {"animation/delta", "streamAnimationDeltaResponse", true},
+    {"song", "handleSongResponse", false},
+    {"ota", "handleOtaResponse", false},
+    {"config", "handleConfigResponse", false},
+    {"register", "handleRegisterResponse", false},
+    {"animation/palette", "handleAnimationPaletteResponse", false},
+};
+#define EXPECTED_COUNT (sizeof(expected) / sizeof(expected[0]))
+
+static const MqttRoute* routes = nullptr;
+static size_t routeCount = 0;
+
+static byte payload[1] = {0};
+
+static void dispatchTable(const char* topic) {
+    const char* suffix = mqttResponseSuffix(topic);
+    if (!suffix) return;
+    const MqttRoute* route = mqttRouteFind(routes, routeCount, suffix);
+    if (!route) return;
+    if (route->stream) route->stream(0);
+    else route->message(payload, 0);
+}
+
+// Lo que hacian mqttStreamHandler + mqttCallback antes
+static void dispatchString(const char* topic) {
+    String topicStr = String(topic);
+    if (topicStr.indexOf("/response/") == -1) return;
+    if (topicStr.endsWith("/response/photo")) streamPhotoResponse(0);
+    else if (topicStr.endsWith("/response/cover")) streamCoverResponse(0);
+    else if (topicStr.endsWith("/response/animation/frame")) streamAnimationFrameResponse(0);
+    else if (topicStr.endsWith("/response/animation/frames")) streamAnimationFramesResponse(0);
+    else if (topicStr.endsWith("/response/animation/delta")) streamAnimationDeltaResponse(0);
+    else if (topicStr.endsWith("/response/song")) handleSongResponse(payload, 0);
+    else if (topicStr.endsWith("/response/ota")) handleOtaResponse(payload, 0);
+    else if (topicStr.endsWith("/response/config")) handleConfigResponse(payload, 0);
+    else if (topicStr.endsWith("/response/register")) handleRegisterResponse(payload, 0);
+    else if (topicStr.endsWith("/response/animation/palette")) handleAnimationPaletteResponse(payload, 0);
+}
+
+static int checkDispatch() {
+    int fails = 0;
+    for (size_t i = 1; i < routeCount; i++) {
+        if (strcmp(routes[i - 1].suffix, routes[i].suffix) >= 0) {
+            LOG("Tabla desordenada en %s", routes[i].suffix);
+            fails++;
+        }
+    }
+    if (routeCount != EXPECTED_COUNT) {
+        LOG("La tabla tiene %u rutas (esperadas %u)", (unsigned)routeCount, (unsigned)EXPECTED_COUNT);
+        fails++;
+    }
+    char topic[96];
+    for (const ExpectedRoute& e : expected) {
+        snprintf(topic, sizeof(topic), "frame/42/response/%s", e.suffix);
+        const MqttRoute* route = mqttRouteFind(routes, routeCount, e.suffix);
+        hit = nullptr;
+        dispatchTable(topic);
+        if (!hit || strcmp(hit, e.handler) != 0 || !route || (route->stream != nullptr) != e.stream) {
+            LOG("%s -> %s%s (esperado %s)", topic, hit ? hit : "nadie",
+                route && route->stream ? " en streaming" : "", e.handler);
+            fails++;
+        }
+    }
+    // Ni comandos, ni respuestas de otro frame, ni sufijos parecidos
+    const char* ignored[] = {"frame/42", "frame/4/response/song", "frame/421/response/song",
+                             "frame/42/response/", "frame/42/response/animation",
+                             "frame/42/response/animation/framesx", "frame/42/response/songs"};
+    for (const char* t : ignored) {
+        hit = nullptr;
+        dispatchTable(t);
+        if (hit) {
+            LOG("%s despachado a %s", t, hit);
+            fails++;
+        }
+    }
+    return fails;
+}
+
+// Ciclos medios por mensaje de dispatch sobre topic
+static uint32_t benchCycles(void (*dispatch)(const char*), const char* topic) {
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ITERS; i++) dispatch(topic);
+    return (ESP.getCycleCount() - start) / BENCH_ITERS;
+}
+
+static void benchDispatch() {
+    const char* topics[] = {"frame/42/response/animation/frame", "frame/42/response/animation/delta",
+                            "frame/42/response/photo", "frame/42/response/song", "frame/42"};
+    uint32_t mhz = getCpuFrequencyMhz();
+    for (const char* t : topics) {
+        uint32_t heap = ESP.getFreeHeap();
+        uint32_t before = benchCycles(dispatchString, t);
+        uint32_t after = benchCycles(dispatchTable, t);
+        LOG("%-36s String %5u ciclos (%4u ns), tabla %4u ciclos (%4u ns), heap %d",
+            t, (unsigned)before, (unsigned)(before * 1000 / mhz), (unsigned)after,
+            (unsigned)(after * 1000 / mhz), (int)(ESP.getFreeHeap() - heap));
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(3000);
+
+    LOG("==== DISPATCH TEST ====");
+    LOG("CPU freq: %d MHz", getCpuFrequencyMhz());
+
+    mqttTopicsSetPrefix("frame/42/response/");
+    routes = mqttResponseRoutes(&routeCount);
+    int fails = checkDispatch();
+    LOG("Despacho: %s (%d fallos)", fails == 0 ? "OK" : "FALLO", fails);
+    benchDispatch();
+    LOG("==== FIN ====");
+}
+
+void loop() {
+    delay(1000);
+}
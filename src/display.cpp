@@ -1,6 +1,7 @@
 #include "display.h"
 #include "messages.h"
 #include "net_task.h"
+#include "mqtt_rx.h"
 #include <ArduinoOTA.h>
 #include <Adafruit_GFX.h>
 #include <Fonts/Picopixel.h>
@@ -22,7 +23,7 @@ void wait(int ms)
     while (millis() - startTime < ms)
     {
         esp_task_wdt_reset();
-        if (!netTaskRunning) mqttClient.loop(); // con tarea de red, el bombeo va en core 0
+        if (!netTaskRunning) mqttRxLoop(); // con tarea de red, el bombeo va en core 0
         ArduinoOTA.handle();
         yield();
     }
@@ -48,6 +49,7 @@ void showLoadingMsg(String msg)
     // Dibujar el texto centrado
     dma_display->setCursor(x, 55);
     dma_display->print(msg);
+    panelPresent(); // pantallas de arranque: sin loop() que presente
 }
 
 void drawPixelWithBuffer(int x, int y, uint16_t color) {
@@ -61,56 +63,6 @@ void rgb565ToRgb(uint16_t rgb565, uint8_t &r, uint8_t &g, uint8_t &b) {
     b = (rgb565 & 0x1F) << 3;
 }
 
-void fadeOut()
-{
-    const int steps = 20;
-    for (int step = 0; step <= steps; step++)
-    {
-        for (int y = 0; y < PANEL_RES_Y; y++)
-        {
-            for (int x = 0; x < PANEL_RES_X; x++)
-            {
-                uint16_t color = screenBuffer[y][x];
-                uint8_t r = ((color >> 11) & 0x1F) << 3;
-                uint8_t g = ((color >> 5) & 0x3F) << 2;
-                uint8_t b = (color & 0x1F) << 3;
-
-                r = r * (steps - step) / steps;
-                g = g * (steps - step) / steps;
-                b = b * (steps - step) / steps;
-
-                dma_display->drawPixel(x, y, dma_display->color565(r, g, b));
-            }
-        }
-        delay(30);
-    }
-}
-
-void fadeIn()
-{
-    const int steps = 20;
-    for (int step = 0; step <= steps; step++)
-    {
-        for (int y = 0; y < PANEL_RES_Y; y++)
-        {
-            for (int x = 0; x < PANEL_RES_X; x++)
-            {
-                uint16_t color = screenBuffer[y][x];
-                uint8_t r = ((color >> 11) & 0x1F) << 3;
-                uint8_t g = ((color >> 5) & 0x3F) << 2;
-                uint8_t b = (color & 0x1F) << 3;
-
-                r = r * step / steps;
-                g = g * step / steps;
-                b = b * step / steps;
-
-                dma_display->drawPixel(x, y, dma_display->color565(r, g, b));
-            }
-        }
-        delay(30);
-    }
-}
-
 void pushUpAnimation(int y, JsonArray &data)
 {
     unsigned long startTime = millis();
@@ -144,6 +96,7 @@ void drawLogo()
             drawPixelWithBuffer(x, y, dma_display->color565(r, g, b));
         }
     }
+    panelPresent();
 }
 
 // Texto "Actualizando" + "XX%" renderizado en Picopixel sobre un canvas
@@ -188,7 +141,9 @@ void showPercetage(int percentage)
         int ty = y - OTA_TEXT_TOP;
         for (int x = 0; x < PANEL_RES_X; x++)
         {
-            bool isText = ty >= 0 && ty < 16 &&
+            // Sin bitmap (malloc fallido en la inicializacion estatica del
+            // canvas) la pantalla sale sin texto
+            bool isText = textBuf && ty >= 0 && ty < 16 &&
                           (textBuf[ty * rowBytes + x / 8] & (0x80 >> (x & 7)));
             uint16_t color;
             if (isText)
@@ -214,6 +169,7 @@ void showPercetage(int percentage)
             drawPixelWithBuffer(x, y, color);
         }
     }
+    panelPresent(); // la OTA no vuelve a loop() hasta el reinicio
 }
 
 void showUpdateMessage()
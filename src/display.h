@@ -7,8 +7,7 @@ void wait(int ms);
 void showLoadingMsg(String msg);
 void drawPixelWithBuffer(int x, int y, uint16_t color);
 void rgb565ToRgb(uint16_t rgb565, uint8_t &r, uint8_t &g, uint8_t &b);
-void fadeOut();
-void fadeIn();
+
 void pushUpAnimation(int y, JsonArray &data);
 void drawLogo();
 void showPercetage(int percentage);
@@ -0,0 +1,89 @@
+#ifndef FRAME_BITSET_H
+#define FRAME_BITSET_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Bitset de slots de una animacion (frames recibidos, deltas, pedidos en
+// vuelo). Sustituye a los uint64_t que limitaban las animaciones a 64 frames:
+// tamano logico por animacion (size, fijado con bitsetResize) sobre palabras
+// de 64 bits hasta MAX_ANIM_FRAMES, sin heap. Los bits >= size siempre a 0.
+//
+// Incluido desde globals.h tras definir MAX_ANIM_FRAMES. Sin sincronizacion:
+// los compartidos entre cores van bajo animBufLock(), como antes los bitmaps.
+
+#define FRAME_BITSET_WORDS ((MAX_ANIM_FRAMES + 63) / 64)
+
+struct FrameBitset {
+    uint16_t size;
+    uint64_t w[FRAME_BITSET_WORDS];
+};
+
+// Vacio, de size bits
+static inline void bitsetResize(FrameBitset& b, uint16_t size) {
+    b.size = size > MAX_ANIM_FRAMES ? MAX_ANIM_FRAMES : size;
+    memset(b.w, 0, sizeof(b.w));
+}
+
+// Recorta a size bits conservando los de debajo
+static inline void bitsetTruncate(FrameBitset& b, uint16_t size) {
+    if (size >= b.size) return;
+    b.size = size;
+    for (int i = 0; i < FRAME_BITSET_WORDS; i++) {
+        int base = i * 64;
+        if (base >= size) b.w[i] = 0;
+        else if (size - base < 64) b.w[i] &= (1ULL << (size - base)) - 1;
+    }
+}
+
+// Los size bits a 1
+static inline void bitsetFill(FrameBitset& b, uint16_t size) {
+    memset(b.w, 0xFF, sizeof(b.w));
+    b.size = FRAME_BITSET_WORDS * 64;
+    bitsetTruncate(b, size > MAX_ANIM_FRAMES ? MAX_ANIM_FRAMES : size);
+}
+
+static inline bool bitsetTest(const FrameBitset& b, uint16_t i) {
+    return i < b.size && (b.w[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void bitsetSet(FrameBitset& b, uint16_t i) {
+    if (i < b.size) b.w[i / 64] |= 1ULL << (i % 64);
+}
+
+static inline void bitsetReset(FrameBitset& b, uint16_t i) {
+    if (i < b.size) b.w[i / 64] &= ~(1ULL << (i % 64));
+}
+
+static inline uint16_t bitsetCount(const FrameBitset& b) {
+    uint16_t n = 0;
+    for (int i = 0; i < FRAME_BITSET_WORDS; i++) n += __builtin_popcountll(b.w[i]);
+    return n;
+}
+
+// Bits a 1 seguidos desde el 0 (frames reproducibles en orden)
+static inline uint16_t bitsetPrefix(const FrameBitset& b) {
+    for (int i = 0; i < FRAME_BITSET_WORDS; i++) {
+        if (~b.w[i]) {
+            uint16_t n = i * 64 + __builtin_ctzll(~b.w[i]);
+            return n < b.size ? n : b.size;
+        }
+    }
+    return b.size;
+}
+
+// Primer bit a 1 desde from; b.size si no hay
+static inline uint16_t bitsetNextSet(const FrameBitset& b, uint16_t from) {
+    if (from >= b.size) return b.size;
+    for (int i = from / 64; i < FRAME_BITSET_WORDS; i++) {
+        uint64_t word = b.w[i];
+        if (i == from / 64) word &= ~0ULL << (from % 64);
+        if (word) {
+            uint16_t n = i * 64 + __builtin_ctzll(word);
+            return n < b.size ? n : b.size;
+        }
+    }
+    return b.size;
+}
+
+#endif
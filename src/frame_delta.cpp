@@ -0,0 +1,105 @@
+#include "frame_delta.h"
+#include "pixel_kernels.h"
+
+// Tile de 8x8 tal como llega del backend (frames de 64 px)
+#define WIRE_TILE 8
+#define WIRE_TILE_BYTES FRAME_WIRE_TILE_BYTES
+
+static uint64_t readMask(const uint8_t* p) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 8; i++) mask = (mask << 8) | p[i];
+    return mask;
+}
+
+static void writeMask(uint8_t* p, uint64_t mask) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = mask & 0xFF;
+        mask >>= 8;
+    }
+}
+
+// Copia un tile contiguo (side x side) a su sitio en un frame de width px
+static void tileToFrame(uint8_t* frame, const uint8_t* tile, int t, int side, int width) {
+    uint8_t* dst = frame + ((t / FRAME_TILES_X) * side * width + (t % FRAME_TILES_X) * side) * 2;
+    for (int row = 0; row < side; row++) {
+        memcpy(dst + row * width * 2, tile + row * side * 2, side * 2);
+    }
+}
+
+bool frameDeltaBegin(FrameDeltaWriter* w, uint8_t* slot, const uint8_t* mask, size_t len, uint8_t width) {
+    if (len < FRAME_DELTA_HEADER) return false;
+    uint64_t m = readMask(mask);
+    if (len != FRAME_DELTA_HEADER + (size_t)__builtin_popcountll(m) * WIRE_TILE_BYTES) return false;
+
+    w->slot = slot;
+    w->dst = slot + FRAME_DELTA_HEADER;
+    w->pending = m;
+    w->width = width;
+    // Todos los tiles: no cabe como delta en el slot, pero es un frame completo
+    w->isDelta = m != FRAME_ALL_TILES;
+    if (w->isDelta) writeMask(slot, m);
+    return true;
+}
+
+void frameDeltaTile(FrameDeltaWriter* w, const uint8_t* tile) {
+    if (!w->pending) return;
+    int t = __builtin_ctzll(w->pending);
+    w->pending &= w->pending - 1;
+
+    int side = w->width / FRAME_TILES_X;
+    uint8_t scaled[WIRE_TILE_BYTES / 4];
+    if (side != WIRE_TILE) {
+        // v1: mismo escalado 2x2 + dither que los frames completos (el
+        // origen del tile es multiplo de 4, asi que el patron coincide)
+        pkDownscale2x565(scaled, tile, WIRE_TILE, WIRE_TILE);
+        tile = scaled;
+    }
+    if (w->isDelta) {
+        memcpy(w->dst, tile, side * side * 2);
+        w->dst += side * side * 2;
+    } else {
+        tileToFrame(w->slot, tile, t, side, w->width);
+    }
+}
+
+uint16_t frameDeltaBytes(const uint8_t* slot, uint8_t width) {
+    int side = width / FRAME_TILES_X;
+    return FRAME_DELTA_HEADER + __builtin_popcountll(readMask(slot)) * side * side * 2;
+}
+
+uint64_t frameApply(uint8_t* frame, const uint8_t* slot, bool isDelta, uint8_t width) {
+    int side = width / FRAME_TILES_X;
+    int rowBytes = side * 2;
+    uint64_t changed = 0;
+
+    if (isDelta) {
+        uint64_t mask = readMask(slot);
+        const uint8_t* tile = slot + FRAME_DELTA_HEADER;
+        for (int t = 0; t < FRAME_TILE_COUNT; t++) {
+            if (!(mask & (1ULL << t))) continue;
+            tileToFrame(frame, tile, t, side, width);
+            tile += side * rowBytes;
+        }
+        return mask;
+    }
+
+    // Frame completo (o backend sin deltas): comparar tile a tile con lo que
+    // hay en pantalla y copiar solo lo distinto
+    for (int t = 0; t < FRAME_TILE_COUNT; t++) {
+        size_t offset = ((t / FRAME_TILES_X) * side * width + (t % FRAME_TILES_X) * side) * 2;
+        for (int row = 0; row < side; row++) {
+            size_t o = offset + row * width * 2;
+            if (memcmp(frame + o, slot + o, rowBytes) != 0) {
+                changed |= 1ULL << t;
+                break;
+            }
+        }
+        if (changed & (1ULL << t)) {
+            for (int row = 0; row < side; row++) {
+                size_t o = offset + row * width * 2;
+                memcpy(frame + o, slot + o, rowBytes);
+            }
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,49 @@
+#ifndef FRAME_DELTA_H
+#define FRAME_DELTA_H
+
+#include "globals.h"
+
+// Frames delta de animacion. El panel se divide en 8x8 tiles de 8x8 pixeles;
+// un delta trae solo los tiles que cambian respecto al frame anterior:
+//   [8 bytes: mascara de tiles, big-endian, bit ty*8+tx]
+//   [por cada bit a 1, en orden: tile 8x8 RGB565 big-endian, fila a fila]
+// Llega por /response/animation/delta (mismo header de 4 bytes que los frames
+// completos) cuando el request lleva "deltaFrom": el frame de backend contra
+// el que se calcula (el del slot anterior). El slot 0 siempre es completo.
+//
+// El slot guarda el delta tal cual (escalado a 4x4 por tile en v1). Al
+// reproducir, cada frame se aplica sobre el frame en pantalla y solo se pintan
+// los tiles que cambian; los frames completos tambien se comparan tile a tile.
+
+#define FRAME_TILES_X 8
+#define FRAME_TILE_COUNT (FRAME_TILES_X * FRAME_TILES_X)
+#define FRAME_ALL_TILES 0xFFFFFFFFFFFFFFFFULL
+#define FRAME_DELTA_HEADER 8
+
+// Un delta se guarda en el slot (animFrameSize bytes, frames de width px) a
+// medida que llega del socket (mqtt_rx.h): frameDeltaBegin con la mascara y la
+// longitud total del delta, y frameDeltaTile con cada tile del cable en orden.
+// Si trae todos los tiles se reconstruye como frame completo (no cabria como
+// delta) e isDelta queda a false.
+struct FrameDeltaWriter {
+    uint8_t* slot;
+    uint8_t* dst;     // donde va el siguiente tile (delta compactado)
+    uint64_t pending; // tiles por llegar
+    uint8_t width;
+    bool isDelta;
+};
+
+#define FRAME_WIRE_TILE_BYTES (8 * 8 * 2)
+
+// false si el delta esta mal formado (la longitud no cuadra con la mascara)
+bool frameDeltaBegin(FrameDeltaWriter* w, uint8_t* slot, const uint8_t* mask, size_t len, uint8_t width);
+void frameDeltaTile(FrameDeltaWriter* w, const uint8_t* tile);
+
+// Bytes que ocupa un delta guardado (mascara + tiles)
+uint16_t frameDeltaBytes(const uint8_t* slot, uint8_t width);
+
+// Aplica el slot (completo o delta) sobre frame, el frame en pantalla, y
+// devuelve la mascara de tiles que han cambiado
+uint64_t frameApply(uint8_t* frame, const uint8_t* slot, bool isDelta, uint8_t width);
+
+#endif
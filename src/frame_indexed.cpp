@@ -0,0 +1,34 @@
+#include "frame_indexed.h"
+#include "frame_delta.h"
+
+static inline uint8_t indexAt(const uint8_t* slot, int i, uint8_t bits) {
+    if (bits == 8) return slot[i];
+    uint8_t b = slot[i >> 1];
+    return (i & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+uint64_t frameApplyIndexed(uint8_t* frame, const uint8_t* slot, const uint16_t* palette,
+                           uint8_t bits, uint8_t width) {
+    int side = width / FRAME_TILES_X;
+    uint64_t changed = 0;
+
+    // Tile a tile, como los frames completos: solo se escribe (y se marca)
+    // lo que difiere del frame en pantalla
+    for (int t = 0; t < FRAME_TILE_COUNT; t++) {
+        int x0 = (t % FRAME_TILES_X) * side;
+        int y0 = (t / FRAME_TILES_X) * side;
+        for (int y = y0; y < y0 + side; y++) {
+            for (int x = x0; x < x0 + side; x++) {
+                int i = y * width + x;
+                uint16_t c = palette[indexAt(slot, i, bits)];
+                uint8_t* p = frame + i * 2;
+                if (p[0] != (c >> 8) || p[1] != (c & 0xFF)) {
+                    p[0] = c >> 8;
+                    p[1] = c & 0xFF;
+                    changed |= 1ULL << t;
+                }
+            }
+        }
+    }
+    return changed;
+}
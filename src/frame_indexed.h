@@ -0,0 +1,28 @@
+#ifndef FRAME_INDEXED_H
+#define FRAME_INDEXED_H
+
+#include "globals.h"
+
+// Frames indexados para v1 (sin PSRAM): una paleta RGB565 por animacion y un
+// indice de 8 o 4 bits por pixel, a 1/2 o 1/4 de lo que ocupa el frame RGB565.
+// Solo si el backend la ofrece ("palette":true en la respuesta de la foto):
+//   request/animation/palette  {"animationId":N,"bits":B}
+//   /response/animation/palette  [animationId u16][2^B colores RGB565 big-endian]
+//   request/animation/frame    {...,"width":32,"bits":B}
+//   /response/animation/frame  [header de 4 bytes][indices, fila a fila;
+//                               con 4 bits, el pixel par en el nibble alto]
+// La paleta se guarda en el buffer de la animacion (frameStorePalette) y el
+// frame se expande con ella al pintarlo.
+
+#define ANIM_PALETTE_MAX 256
+
+static inline uint16_t frameIndexedSize(uint8_t width, uint8_t bits) {
+    return (uint16_t)width * width * bits / 8;
+}
+
+// Como frameApply() para un slot indexado: expande sobre frame (RGB565
+// big-endian, el frame en pantalla) y devuelve los tiles que cambian
+uint64_t frameApplyIndexed(uint8_t* frame, const uint8_t* slot, const uint16_t* palette,
+                           uint8_t bits, uint8_t width);
+
+#endif
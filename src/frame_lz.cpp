@@ -0,0 +1,141 @@
+#include "frame_lz.h"
+#include <string.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5 // el bloque acaba siempre en literales
+#define LZ_MF_LIMIT 12     // ningun match empieza en los ultimos 12 bytes
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 12
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Longitud >= 15: el resto en bytes de 255 y uno final
+static inline uint8_t* writeLength(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// Una secuencia: literales [anchor, anchor + lit) y, si matchLen > 0, el match
+static uint8_t* writeSequence(uint8_t* op, uint8_t* oend, const uint8_t* anchor, size_t lit,
+                              size_t offset, size_t matchLen) {
+    size_t need = 1 + lit + lit / 255 + 1 + (matchLen ? 2 + matchLen / 255 + 1 : 0);
+    if (need > (size_t)(oend - op)) return nullptr;
+
+    uint8_t* token = op++;
+    *token = (lit >= 15 ? 15 : lit) << 4;
+    if (lit >= 15) op = writeLength(op, lit - 15);
+    memcpy(op, anchor, lit);
+    op += lit;
+    if (!matchLen) return op;
+
+    *op++ = offset & 0xFF;
+    *op++ = offset >> 8;
+    size_t m = matchLen - LZ_MIN_MATCH;
+    *token |= m >= 15 ? 15 : m;
+    if (m >= 15) op = writeLength(op, m - 15);
+    return op;
+}
+
+size_t lzCompress(const uint8_t* src, size_t len, uint8_t* dst, size_t cap) {
+    static uint16_t table[1 << LZ_HASH_BITS]; // posicion de la ultima aparicion de cada hash
+    if (len > LZ_MAX_OFFSET) return 0;
+
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* end = src + len;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + cap;
+
+    if (len > LZ_MF_LIMIT) {
+        const uint8_t* mfLimit = end - LZ_MF_LIMIT;
+        const uint8_t* matchLimit = end - LZ_LAST_LITERALS;
+        memset(table, 0, sizeof(table));
+
+        while (ip <= mfLimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash4(seq);
+            const uint8_t* ref = src + table[h];
+            table[h] = ip - src;
+            if (ref >= ip || read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+
+            const uint8_t* mp = ip + LZ_MIN_MATCH;
+            const uint8_t* rp = ref + LZ_MIN_MATCH;
+            while (mp < matchLimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            op = writeSequence(op, oend, anchor, ip - anchor, ip - ref, mp - ip);
+            if (!op) return 0;
+            ip = anchor = mp;
+            // Posicion justo antes del siguiente intento: mejora el ratio en
+            // los tramos repetidos casi gratis
+            if (ip <= mfLimit) table[hash4(read32(ip - 2))] = ip - 2 - src;
+        }
+    }
+
+    op = writeSequence(op, oend, anchor, end - anchor, 0, 0);
+    return op ? op - dst : 0;
+}
+
+// Longitud extendida (token a 15): suma bytes hasta uno < 255
+static inline bool readLength(const uint8_t** ip, const uint8_t* iend, size_t* len) {
+    uint8_t b;
+    do {
+        if (*ip >= iend) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+bool lzDecompress(const uint8_t* src, size_t len, uint8_t* dst, size_t outLen) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + len;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + outLen;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !readLength(&ip, iend, &lit)) return false;
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op)) return false;
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+        if (ip == iend) break; // la ultima secuencia no lleva match
+
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return false;
+        size_t matchLen = token & 15;
+        if (matchLen == 15 && !readLength(&ip, iend, &matchLen)) return false;
+        matchLen += LZ_MIN_MATCH;
+        if (matchLen > (size_t)(oend - op)) return false;
+
+        const uint8_t* ref = op - offset;
+        if (offset >= matchLen) {
+            memcpy(op, ref, matchLen);
+            op += matchLen;
+        } else {
+            // Solapado (repeticion de un patron corto): byte a byte
+            while (matchLen--) *op++ = *ref++;
+        }
+    }
+    return op == oend;
+}
@@ -0,0 +1,24 @@
+#ifndef FRAME_LZ_H
+#define FRAME_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compresion LZ4 (formato de bloque: secuencias token + literales + offset
+// u16 + longitud de match, sin cabecera de frame) para guardar los frames de
+// animacion en PSRAM (frame_store.h). Compresor voraz con tabla hash de una
+// entrada: lejos del ratio de lz4 -9 pero ~1ms por frame de 8KB, y los frames
+// de pixel art y los deltas se comprimen bien. Bloques de menos de 64KB.
+//
+// lzCompress usa una tabla estatica de 8KB: solo desde la tarea de red.
+// lzDecompress no tiene estado y valida la entrada (nunca escribe ni lee
+// fuera de los buffers, aunque el bloque este corrupto).
+
+// Comprime src en dst (cap bytes). 0 si no cabe en cap
+size_t lzCompress(const uint8_t* src, size_t len, uint8_t* dst, size_t cap);
+
+// Descomprime un bloque en dst, que debe quedar exactamente con outLen bytes.
+// false si el bloque esta mal formado
+bool lzDecompress(const uint8_t* src, size_t len, uint8_t* dst, size_t outLen);
+
+#endif
@@ -0,0 +1,87 @@
+#include "frame_slab.h"
+
+static uint8_t* slabBase = nullptr;
+static uint8_t slabBlocks = 0;
+static uint32_t slabUsed = 0; // bit i = bloque i prestado
+static uint32_t handouts = 0;
+static uint32_t failures = 0;
+static portMUX_TYPE slabMux = portMUX_INITIALIZER_UNLOCKED;
+
+void frameSlabInit() {
+    if (!hasPsram || ANIM_SLAB_BLOCKS == 0 || slabBase) return;
+    slabBase = (uint8_t*)ps_malloc((size_t)ANIM_SLAB_BLOCKS * FRAME_SLAB_BLOCK);
+    if (!slabBase) {
+        LOGF("[Slab] No se pudieron reservar %d bloques de %d bytes: buffers en heap",
+             ANIM_SLAB_BLOCKS, FRAME_SLAB_BLOCK);
+        return;
+    }
+    slabBlocks = ANIM_SLAB_BLOCKS;
+    LOGF("[Slab] %d bloques de %d bytes en PSRAM (libre: %d)",
+         slabBlocks, FRAME_SLAB_BLOCK, ESP.getFreePsram());
+}
+
+// Bloque de p; -1 si no es del slab, -2 si cae dentro pero no al inicio
+static int blockOf(const uint8_t* p) {
+    if (!slabBase || p < slabBase || p >= slabBase + (size_t)slabBlocks * FRAME_SLAB_BLOCK) return -1;
+    size_t offset = p - slabBase;
+    return offset % FRAME_SLAB_BLOCK == 0 ? (int)(offset / FRAME_SLAB_BLOCK) : -2;
+}
+
+uint8_t* frameSlabAlloc(size_t bytes) {
+    if (!slabBase) return (uint8_t*)(hasPsram ? ps_malloc(bytes) : malloc(bytes));
+
+    int block = -1;
+    portENTER_CRITICAL(&slabMux); // lo piden los dos cores a la vez
+    uint32_t idle = ~slabUsed & ((1u << slabBlocks) - 1);
+    if (bytes <= FRAME_SLAB_BLOCK && idle) {
+        block = __builtin_ctz(idle);
+        slabUsed |= 1u << block;
+        handouts++;
+    } else {
+        failures++;
+    }
+    portEXIT_CRITICAL(&slabMux);
+    if (block >= 0) return slabBase + (size_t)block * FRAME_SLAB_BLOCK;
+    if (bytes > FRAME_SLAB_BLOCK) {
+        LOGF("[Slab] %d bytes no caben en un bloque (%d)", bytes, FRAME_SLAB_BLOCK);
+    } else {
+        LOGF("[Slab] Sin bloques libres para %d bytes", bytes);
+    }
+    return nullptr;
+}
+
+void frameSlabFree(uint8_t* p) {
+    if (!p) return;
+    int block = blockOf(p);
+    if (block == -1) {
+        free(p);
+        return;
+    }
+    bool wasUsed = false;
+    if (block >= 0) {
+        portENTER_CRITICAL(&slabMux);
+        wasUsed = slabUsed & (1u << block);
+        slabUsed &= ~(1u << block);
+        portEXIT_CRITICAL(&slabMux);
+    }
+    if (!wasUsed) {
+        LOGF("[Slab] free invalido de %p (bloque %d, prestados 0x%x)", p, block, (unsigned)slabUsed);
+        Serial.flush();
+        abort(); // coredump en el free malo, no en el siguiente que use el bloque
+    }
+}
+
+uint8_t frameSlabFreeBlocks() {
+    portENTER_CRITICAL(&slabMux);
+    uint8_t n = slabBlocks - __builtin_popcount(slabUsed);
+    portEXIT_CRITICAL(&slabMux);
+    return n;
+}
+
+uint32_t frameSlabHandouts() {
+    return handouts;
+}
+
+uint32_t frameSlabFailures() {
+    return failures;
+}
@@ -0,0 +1,49 @@
+#ifndef FRAME_SLAB_H
+#define FRAME_SLAB_H
+
+#include "globals.h"
+#include "frame_store.h"
+
+// Bloques fijos de PSRAM para los buffers de animacion (animBuffer y
+// playBuffer), reservados una sola vez al arrancar. Cada bloque cabe el
+// buffer mas grande que pide frame_store (su tope con compresion; si no,
+// MAX_ANIM_FRAMES frames RGB565 + el frame en pantalla + paleta): descarga y
+// reproduccion se pasan el bloque (el swap es copiar el puntero) y el heap no
+// se toca con cada animacion. Con 2 bloques caben la descarga y la
+// reproduccion a la vez. Un pedido mayor que un bloque, o sin bloques libres,
+// falla (nullptr) y se cuenta: la descarga se abandona como con un malloc
+// fallido, sin ir al heap.
+//
+// Sin PSRAM (v1) no hay bloques: 64KB fijos no caben en el heap, y ahi el
+// tamano del buffer ya se ajusta al bloque libre mas grande. Todo va al heap
+// como antes; tambien si los bloques no se pudieron reservar.
+//
+// Alloc/free se llaman desde los dos cores (releaseDownloadBuffer corre en la
+// tarea de red): seccion critica propia.
+
+#ifndef ANIM_SLAB_BLOCKS
+#define ANIM_SLAB_BLOCKS 2 // -DANIM_SLAB_BLOCKS=0 vuelve al heap
+#endif
+
+#if FRAME_STORE_LZ
+#define FRAME_SLAB_BLOCK ANIM_STORE_BYTES // el tope de frameStoreBytes
+#else
+#define FRAME_SLAB_BLOCK (FRAME_STORE_HEADER(MAX_ANIM_FRAMES) + (MAX_ANIM_FRAMES + 1) * ANIM_FRAME_SIZE_64 + 512)
+#endif
+
+// Reservar los bloques (en setup(), antes de la primera animacion)
+void frameSlabInit();
+
+// Un bloque libre si bytes cabe; si no, nullptr. Sin bloques, ps_malloc/malloc
+uint8_t* frameSlabAlloc(size_t bytes);
+
+// Devuelve el bloque (o free() si vino del heap). Un puntero en mitad de un
+// bloque o un bloque que ya estaba libre es corrupcion: abort() con el log
+void frameSlabFree(uint8_t* p);
+
+// [Diag] bloques libres / prestados desde el arranque / pedidos fallidos
+uint8_t frameSlabFreeBlocks();
+uint32_t frameSlabHandouts();
+uint32_t frameSlabFailures();
+
+#endif
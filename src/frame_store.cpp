@@ -0,0 +1,195 @@
+#include "frame_store.h"
+#include "frame_lz.h"
+
+struct StoreHeader {
+    uint32_t arenaOffset;
+    uint32_t arenaSize;
+    uint32_t arenaUsed;
+    uint32_t rawBytes;
+    uint32_t decodes;
+    uint32_t decodeUs;
+    uint32_t decodeMaxUs;
+    uint16_t slotSize;
+    uint8_t frames;
+    uint8_t indexBits;
+    int16_t decoded;      // slot en el area de descompresion; -1 ninguno
+    uint8_t storedFrames;
+    uint16_t serial;      // distinto en cada frameStoreInit
+    uint8_t reserved[2];
+};
+static_assert(sizeof(StoreHeader) + 8 == FRAME_STORE_HEADER(1), "FRAME_STORE_HEADER");
+
+struct StoreSlot {
+    uint32_t offset; // en la arena
+    uint16_t stored; // bytes en la arena (== raw: sin comprimir)
+    uint16_t raw;    // bytes del slot; 0 = vacio
+};
+
+static inline StoreHeader* header(uint8_t* buf) {
+    return (StoreHeader*)buf;
+}
+
+static inline const StoreHeader* header(const uint8_t* buf) {
+    return (const StoreHeader*)buf;
+}
+
+static inline StoreSlot* table(uint8_t* buf) {
+    return (StoreSlot*)(buf + sizeof(StoreHeader));
+}
+
+static inline const StoreSlot* table(const uint8_t* buf) {
+    return (const StoreSlot*)(buf + sizeof(StoreHeader));
+}
+
+static inline size_t paletteBytes(uint8_t indexBits) {
+    return indexBits ? (2u << indexBits) : 0;
+}
+
+// Lo que va antes de la arena
+static size_t prefixBytes(uint8_t frames, uint16_t slotSize, uint8_t indexBits) {
+    return FRAME_STORE_HEADER(frames) + animFrameSize + paletteBytes(indexBits) +
+           (FRAME_STORE_LZ ? 2 * (size_t)slotSize : 0);
+}
+
+static inline uint8_t* decodeArea(uint8_t* buf) {
+    const StoreHeader* h = header(buf);
+    return buf + FRAME_STORE_HEADER(h->frames) + animFrameSize + paletteBytes(h->indexBits);
+}
+
+static inline uint32_t align4(uint32_t n) {
+    return (n + 3) & ~3u;
+}
+
+size_t frameStoreBytes(uint8_t frames, uint16_t slotSize, uint8_t indexBits) {
+    size_t bytes = prefixBytes(frames, slotSize, indexBits) + (size_t)frames * slotSize;
+#if FRAME_STORE_LZ
+    if (bytes > ANIM_STORE_BYTES) bytes = ANIM_STORE_BYTES;
+#endif
+    return bytes;
+}
+
+uint8_t frameStoreFramesThatFit(size_t maxBlock, uint16_t slotSize, uint8_t indexBits) {
+    size_t reserve = 8192 + frameStoreBytes(0, slotSize, indexBits);
+    if (maxBlock <= reserve) return 0;
+    size_t frames = (maxBlock - reserve) / (frameStoreBytes(1, slotSize, indexBits) - frameStoreBytes(0, slotSize, indexBits));
+    return frames > MAX_ANIM_FRAMES ? MAX_ANIM_FRAMES : frames;
+}
+
+void frameStoreInit(uint8_t* buf, size_t bytes, uint8_t frames, uint16_t slotSize, uint8_t indexBits) {
+    static uint16_t nextSerial = 0;
+    StoreHeader* h = header(buf);
+    memset(h, 0, sizeof(*h));
+    h->serial = ++nextSerial;
+    h->arenaOffset = prefixBytes(frames, slotSize, indexBits);
+    h->arenaSize = bytes > h->arenaOffset ? bytes - h->arenaOffset : 0;
+    h->slotSize = slotSize;
+    h->frames = frames;
+    h->indexBits = indexBits;
+    h->decoded = -1;
+    memset(table(buf), 0, (size_t)frames * sizeof(StoreSlot));
+}
+
+uint8_t* frameStoreStage(uint8_t* buf) {
+    StoreHeader* h = header(buf);
+#if FRAME_STORE_LZ
+    return decodeArea(buf) + h->slotSize;
+#else
+    if (h->arenaSize - h->arenaUsed < h->slotSize) return nullptr;
+    return buf + h->arenaOffset + h->arenaUsed;
+#endif
+}
+
+static void recordSlot(StoreHeader* h, StoreSlot* s, uint16_t stored, uint16_t raw) {
+    s->offset = h->arenaUsed;
+    s->stored = stored;
+    s->raw = raw;
+    h->arenaUsed += align4(stored);
+    h->rawBytes += raw;
+    h->storedFrames++;
+}
+
+bool frameStoreCommit(uint8_t* buf, uint8_t slot, uint16_t len) {
+    StoreHeader* h = header(buf);
+    if (slot >= h->frames || len == 0 || len > h->slotSize) return false;
+    StoreSlot* s = &table(buf)[slot];
+    uint32_t room = h->arenaSize - h->arenaUsed;
+    uint16_t stored = len;
+#if FRAME_STORE_LZ
+    // Comprimido solo si ocupa menos; si no, tal cual
+    uint8_t* dst = buf + h->arenaOffset + h->arenaUsed;
+    size_t packed = lzCompress(frameStoreStage(buf), len, dst, min((uint32_t)len - 1, room));
+    if (packed) {
+        stored = packed;
+    } else {
+        if (len > room) return false;
+        memcpy(dst, frameStoreStage(buf), len);
+    }
+#else
+    if (len > room) return false; // frameStoreStage ya lo habria dicho
+#endif
+    recordSlot(h, s, stored, len);
+    return true;
+}
+
+const uint8_t* frameStoreSlot(uint8_t* buf, uint8_t slot) {
+    StoreHeader* h = header(buf);
+    const StoreSlot& s = table(buf)[slot];
+    const uint8_t* data = buf + h->arenaOffset + s.offset;
+    if (s.stored == s.raw) return data;
+
+    uint8_t* out = decodeArea(buf);
+    if (h->decoded == slot) return out;
+    unsigned long t0 = micros();
+    if (!lzDecompress(data, s.stored, out, s.raw)) {
+        // No deberia pasar (lo comprimimos nosotros o paso el crc de la
+        // cache): un frame vacio en vez de basura
+        LOGF("[Store] Slot %d corrupto (%u/%u bytes)", slot, s.stored, s.raw);
+        memset(out, 0, h->slotSize);
+    }
+    uint32_t us = micros() - t0;
+    h->decoded = slot;
+    h->decodes++;
+    h->decodeUs += us;
+    if (us > h->decodeMaxUs) h->decodeMaxUs = us;
+    return out;
+}
+
+void frameStorePrefetch(uint8_t* buf, uint8_t slot) {
+    if (slot < header(buf)->frames && table(buf)[slot].raw) frameStoreSlot(buf, slot);
+}
+
+const uint8_t* frameStoreStored(const uint8_t* buf, uint8_t slot, uint16_t* stored, uint16_t* raw) {
+    const StoreSlot& s = table(buf)[slot];
+    *stored = s.stored;
+    *raw = s.raw;
+    return buf + header(buf)->arenaOffset + s.offset;
+}
+
+uint8_t* frameStoreAppend(uint8_t* buf, uint8_t slot, uint16_t stored, uint16_t raw) {
+    StoreHeader* h = header(buf);
+    if (slot >= h->frames || table(buf)[slot].raw || raw == 0 || raw > h->slotSize || stored > raw) return nullptr;
+    if (!FRAME_STORE_LZ && stored != raw) return nullptr;
+    if (stored > h->arenaSize - h->arenaUsed) return nullptr;
+    uint8_t* dst = buf + h->arenaOffset + h->arenaUsed;
+    recordSlot(h, &table(buf)[slot], stored, raw);
+    return dst;
+}
+
+uint16_t frameStoreSerial(const uint8_t* buf) {
+    return header(buf)->serial;
+}
+
+uint8_t* frameStoreOnScreen(uint8_t* buf) {
+    return buf + FRAME_STORE_HEADER(header(buf)->frames);
+}
+
+uint16_t* frameStorePalette(uint8_t* buf) {
+    return (uint16_t*)(frameStoreOnScreen(buf) + animFrameSize);
+}
+
+FrameStoreStats frameStoreStats(const uint8_t* buf) {
+    const StoreHeader* h = header(buf);
+    FrameStoreStats st = {h->storedFrames, h->arenaUsed, h->rawBytes, h->arenaSize,
+                          h->decodes, h->decodeUs, h->decodeMaxUs};
+    return st;
+}
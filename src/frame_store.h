@@ -0,0 +1,95 @@
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include "globals.h"
+
+// Buffer de una animacion (animBuffer / playBuffer):
+//   [cabecera + tabla de slots][frame en pantalla][paleta]
+//   [frame descomprimido][frame entrante][arena]
+// Cada frame va a la arena con los bytes que usa al recibirlo (completo,
+// delta compactado o indices) y la tabla guarda donde esta. Con
+// FRAME_STORE_LZ (v2) se guarda ademas comprimido en LZ4 (frame_lz.h) si asi
+// ocupa menos, y el buffer tiene un tope fijo (ANIM_STORE_BYTES) en vez de
+// crecer con los frames: caben animaciones de hasta MAX_ANIM_FRAMES, y si una
+// no cabe la descarga la recorta a lo que entro. Sin compresion (v1) la
+// arena se dimensiona para todos los frames y no hay areas intermedias: el
+// frame se escribe directamente en su sitio.
+//
+// Al reproducir, frameStoreSlot descomprime en su area (un frame cada vez);
+// frameStorePrefetch adelanta el siguiente justo despues de pintar el actual,
+// para que el tick del frame no espere a la descompresion.
+//
+// Un escritor (la descarga, bajo animBufLock) y un lector (la reproduccion).
+// En streaming comparten el buffer: el escritor solo toca la cola de la arena
+// y la tabla del slot, antes de marcarlo en animFramesBitmap.
+
+#ifndef FRAME_STORE_LZ
+#ifdef BOARD_HAS_PSRAM
+#define FRAME_STORE_LZ 1
+#else
+#define FRAME_STORE_LZ 0
+#endif
+#endif
+
+// Tamano fijo del buffer con compresion, y de cada bloque del slab
+// (frame_slab.h): con 2 bloques, 1MB de PSRAM reservado. Si el [Diag] Memoria
+// de las descargas muestra la arena llena a menudo, subirlo con -D.
+#ifndef ANIM_STORE_BYTES
+#define ANIM_STORE_BYTES (512 * 1024)
+#endif
+
+// Cabecera y tabla de frames slots (bytes)
+#define FRAME_STORE_HEADER(frames) (40 + (size_t)(frames) * 8)
+
+// Bytes del buffer para frames de slotSize (+ paleta si es indexada)
+size_t frameStoreBytes(uint8_t frames, uint16_t slotSize, uint8_t indexBits);
+
+// Frames que caben en un bloque libre de maxBlock bytes dejando 8KB de margen
+// al resto del heap. Sin compresion (v1): cada frame ocupa su slot y su
+// entrada en la tabla. El env test-anim-fit lo comprueba con el heap partido
+uint8_t frameStoreFramesThatFit(size_t maxBlock, uint16_t slotSize, uint8_t indexBits);
+
+// Prepara un buffer de bytes bytes (frameStoreBytes o menos: la arena se
+// queda con lo que sobre) sin ningun frame guardado
+void frameStoreInit(uint8_t* buf, size_t bytes, uint8_t frames, uint16_t slotSize, uint8_t indexBits);
+
+// Donde escribir el frame que llega (slotSize bytes); nullptr si ya no cabe
+uint8_t* frameStoreStage(uint8_t* buf);
+
+// Guarda en el slot los len bytes escritos en frameStoreStage. false si la
+// arena esta llena (el frame no se guarda)
+bool frameStoreCommit(uint8_t* buf, uint8_t slot, uint16_t len);
+
+// Bytes del slot listos para frameApply (descomprimidos si hace falta)
+const uint8_t* frameStoreSlot(uint8_t* buf, uint8_t slot);
+
+// Descomprime el slot por adelantado (la siguiente frameStoreSlot es gratis)
+void frameStorePrefetch(uint8_t* buf, uint8_t slot);
+
+// Para la cache de flash (anim_cache.h): los bytes guardados del slot tal
+// cual, y restaurarlos. Append devuelve donde leer stored bytes, o nullptr si
+// no cabe o no es coherente
+const uint8_t* frameStoreStored(const uint8_t* buf, uint8_t slot, uint16_t* stored, uint16_t* raw);
+uint8_t* frameStoreAppend(uint8_t* buf, uint8_t slot, uint16_t stored, uint16_t raw);
+
+// Cambia en cada frameStoreInit: quien escribe un frame por trozos sin tener
+// el lock todo el rato (mqtt_rx.h) comprueba con el que el buffer sigue
+// siendo la misma descarga aunque el slab lo reutilice en la misma direccion
+uint16_t frameStoreSerial(const uint8_t* buf);
+
+uint8_t* frameStoreOnScreen(uint8_t* buf);
+uint16_t* frameStorePalette(uint8_t* buf);
+
+// [Diag] memoria y descompresion
+struct FrameStoreStats {
+    uint8_t frames;       // slots guardados
+    uint32_t storedBytes; // en la arena
+    uint32_t rawBytes;    // lo que ocuparian sin comprimir
+    uint32_t arenaBytes;  // tamano de la arena
+    uint32_t decodes;
+    uint32_t decodeUs;    // total
+    uint32_t decodeMaxUs;
+};
+FrameStoreStats frameStoreStats(const uint8_t* buf);
+
+#endif
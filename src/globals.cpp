@@ -1,7 +1,7 @@
 #include "globals.h"
 
 // Core hardware
-MatrixPanel_I2S_DMA *dma_display = nullptr;
+PanelDisplay *dma_display = nullptr;
 WiFiClient mqttClientWiFi;
 PubSubClient mqttClient(mqttClientWiFi);
 WiFiUDP ntpUDP;
@@ -52,13 +52,14 @@ bool screenOff = false;
 // Clock overlay
 bool clockEnabled = false;
 unsigned long lastClockUpdate = 0;
+volatile bool clockOverlayPending = false;
 
 // Title scroll
 String currentTitle = "";
 String currentName = "";
 int titleScrollOffset = 0;
 unsigned long lastTitleScrollTime = 0;
-unsigned long titleScrollSpeed = 300;
+unsigned long titleScrollSpeed = 75; // ~un caracter Picopixel (4px) cada 300ms, como el scroll por caracteres
 unsigned long titleScrollPauseTime = 2000;
 unsigned long titleScrollPauseStart = 0;
 ScrollState titleScrollState = SCROLL_PAUSED_START;
@@ -89,10 +90,12 @@ int dirtyMaxY = -1;
 
 // Overlay bitmask
 uint8_t overlayMask[64][8] = {};
+bool overlaySpansDirty = true;
 
 void overlayMaskSet(int x, int y) {
     if (x >= 0 && x < 64 && y >= 0 && y < 64)
         overlayMask[y][x / 8] |= (1 << (x % 8));
+    overlaySpansDirty = true;
 }
 
 bool overlayMaskGet(int x, int y) {
@@ -101,6 +104,7 @@ bool overlayMaskGet(int x, int y) {
 
 void overlayMaskClear() {
     memset(overlayMask, 0, sizeof(overlayMask));
+    overlaySpansDirty = true;
 }
 
 // Animation playback
@@ -118,14 +122,26 @@ uint8_t animFrameStep = 1;
 unsigned long animFrameInterval = 200;
 uint8_t* playBuffer = nullptr;
 uint8_t playFrameCount = 0;
+uint8_t playFramesAvailable = 0;
+FrameBitset playDeltaBitmap = {};
+uint8_t playIndexBits = 0;
+uint16_t playSlotSize = ANIM_FRAME_SIZE_32;
 unsigned long playFrameInterval = 200;
 unsigned long playMaxLoops = 3;
 bool animPlaying = false;
 uint8_t animCurrentFrame = 0;
 unsigned long animLastFrameTime = 0;
 unsigned long animLoopCount = 0;
+volatile bool animStreaming = false;
 bool photoPending = false;
-volatile uint64_t animFramesBitmap = 0;
+FrameBitset animFramesBitmap = {};
+FrameBitset animDeltaBitmap = {};
+uint8_t animIndexBits = 0;
+uint16_t animSlotSize = ANIM_FRAME_SIZE_32;
+volatile bool animPaletteOffered = false;
+volatile bool animRangeOffered = false;
+volatile bool animFromCache = false;
+volatile bool animPaletteReceived = false;
 unsigned long animDownloadStartTime = 0;
 uint8_t animRetryCount = 0;
 
@@ -152,14 +168,11 @@ int lastPercentage = 0;
 uint8_t spotifyCoverBuffer[64 * 64 * 2];
 char songIdBuffer[64];
 char httpBuffer[512];
-uint8_t photoBuffer[64 * 64 * 3];
+uint16_t photo565[PANEL_RES_Y][PANEL_RES_X];
 char photoTitle[64];
 char photoAuthor[64];
 
-// MQTT response flags
-volatile bool mqttResponseReceived = false;
-volatile bool mqttResponseSuccess = false;
-volatile uint8_t mqttResponseType = RESP_NONE;
+// Tipos de request/response (mqtt_request.h)
 const char* respName(uint8_t t) {
     switch (t) {
         case RESP_SONG: return "song";
@@ -171,8 +184,6 @@ const char* respName(uint8_t t) {
         default: return "none";
     }
 }
-uint32_t mqttRequestId = 0;
-volatile uint32_t mqttResponseRequestId = 0;
 volatile int mqttRegisterFrameId = 0;
 
 // Loop variable
@@ -47,6 +47,8 @@
 #define PANEL_RES_Y 64
 #define PANEL_CHAIN 1
 
+#include "panel.h" // PanelDisplay: panel con o sin doble buffer
+
 // Configuración de estabilidad y timeouts
 #define WDT_TIMEOUT 30
 #define MQTT_MAX_RETRIES 5
@@ -54,6 +56,14 @@
 #define HTTP_TIMEOUT 10000
 #define HTTP_TIMEOUT_DOWNLOAD 30000
 
+// Buffer de PubSubClient: solo para lo que sale (CONNECT, requests, boot
+// report). Lo que entra lo lee mqtt_rx.h del socket, sin pasar por el.
+#ifndef MQTT_BUFFER_SIZE
+#define MQTT_BUFFER_SIZE 1024
+#endif
+#define MQTT_KEEPALIVE 60      // s
+#define MQTT_SOCKET_TIMEOUT 2  // s: espera maxima al resto de un paquete
+
 // Drawing mode constants
 const int MAX_DRAW_COMMANDS = 100;
 const unsigned long DRAWING_TIMEOUT = 60000;
@@ -73,7 +83,7 @@ enum ScrollState { SCROLL_PAUSED_START, SCROLL_SCROLLING, SCROLL_PAUSED_END, SCR
 // --- Extern declarations ---
 
 // Core hardware
-extern MatrixPanel_I2S_DMA *dma_display;
+extern PanelDisplay *dma_display;
 extern WiFiClient mqttClientWiFi;
 extern PubSubClient mqttClient;
 extern WiFiUDP ntpUDP;
@@ -120,13 +130,14 @@ extern bool screenOff;
 // Clock overlay
 extern bool clockEnabled;
 extern unsigned long lastClockUpdate;
+extern volatile bool clockOverlayPending; // clockEnabled cambio por MQTT (core 0), pintar en loop
 
 // Title scroll
 extern String currentTitle;
 extern String currentName;
-extern int titleScrollOffset;
+extern int titleScrollOffset; // en pixeles
 extern unsigned long lastTitleScrollTime;
-extern unsigned long titleScrollSpeed;
+extern unsigned long titleScrollSpeed; // ms por pixel
 extern unsigned long titleScrollPauseTime;
 extern unsigned long titleScrollPauseStart;
 extern ScrollState titleScrollState;
@@ -159,9 +170,18 @@ extern uint8_t overlayMask[64][8]; // 64 rows × 64 bits (8 bytes per row)
 void overlayMaskSet(int x, int y);
 bool overlayMaskGet(int x, int y);
 void overlayMaskClear();
+extern bool overlaySpansDirty; // la mascara cambio: blit.cpp recalcula sus tramos por fila
 
 // Animation playback
+// Tope de frames por animacion. En v2 el del indice de frame del header (un
+// byte); los frames van comprimidos en un buffer de tamano fijo (frame_store.h).
+// Sin PSRAM no caben mas ni con paleta de 4 bits.
+#ifdef BOARD_HAS_PSRAM
+#define MAX_ANIM_FRAMES 255
+#else
 #define MAX_ANIM_FRAMES 60
+#endif
+#include "frame_bitset.h"
 #define ANIM_FRAME_SIZE_64 (64 * 64 * 2) // 8192 bytes RGB565
 #define ANIM_FRAME_SIZE_32 (32 * 32 * 2) // 2048 bytes RGB565
 extern bool hasPsram;
@@ -183,21 +203,36 @@ extern unsigned long animFrameInterval; // ms between frames (replaces 1000/fps
 
 // -- Estado de REPRODUCCION (la animacion en pantalla; buffer independiente
 //    para poder descargar la siguiente mientras esta se reproduce) --
-extern uint8_t* playBuffer;
+extern uint8_t* playBuffer;      // playFrameCount slots + el frame en pantalla (frame_store.h)
 extern uint8_t playFrameCount;
+extern uint8_t playFramesAvailable; // frames contiguos desde el 0 ya descargados (< playFrameCount solo en streaming)
+extern FrameBitset playDeltaBitmap; // animDeltaBitmap de los frames en reproduccion
+extern uint8_t playIndexBits;
+extern uint16_t playSlotSize;
 extern unsigned long playFrameInterval;
 extern unsigned long playMaxLoops;   // vueltas para cubrir ~secsPhotos
 extern bool animPlaying;
 extern uint8_t animCurrentFrame;
 extern unsigned long animLastFrameTime;
 extern unsigned long animLoopCount;
+// Streaming: la reproduccion empezo antes de acabar la descarga y animBuffer
+// es un alias de playBuffer (no se libera por el lado de la descarga).
+// Bajo animBufLock()
+extern volatile bool animStreaming;
 
 // Foto estatica recibida por prefetch mientras un video se reproduce:
-// queda en photoBuffer y se pinta cuando el video termina
+// queda en photo565 y se pinta cuando el video termina
 extern bool photoPending;
-extern volatile uint64_t animFramesBitmap; // bit i set = slot i already stored (tolerates out-of-order arrival); 64 bits: leer/escribir bajo animBufLock()
+extern FrameBitset animFramesBitmap; // bit i set = slot i already stored (tolerates out-of-order arrival); leer/escribir bajo animBufLock()
+extern uint8_t animIndexBits;      // 0 = slots RGB565; 8/4 = indices de paleta (frame_indexed.h)
+extern uint16_t animSlotSize;      // bytes por slot: animFrameSize o los indices
+extern volatile bool animPaletteOffered;  // el backend ofrece frames indexados para esta animacion
+extern volatile bool animRangeOffered;    // el backend acepta peticiones de rango (request/animation/frames)
+extern volatile bool animFromCache;       // la animacion esta en la cache de flash (anim_cache.h)
+extern volatile bool animPaletteReceived; // bajo animBufLock()
+extern FrameBitset animDeltaBitmap;  // bit i set = slot i guarda un delta de tiles (frame_delta.h); bajo animBufLock()
 extern unsigned long animDownloadStartTime; // millis() of last progress (request batch or frame received)
-extern uint8_t animRetryCount;       // how many timeout retries we've issued for current animation
+extern uint8_t animRetryCount;       // pedidos de frame vencidos (RTO) en la descarga actual (anim_window.h)
 
 // Waiting for owner mode (BLE re-entry when no owner)
 extern bool waitingForOwner;
@@ -222,24 +257,20 @@ extern int lastPercentage;
 extern uint8_t spotifyCoverBuffer[64 * 64 * 2];
 extern char songIdBuffer[64];
 extern char httpBuffer[512];
-extern uint8_t photoBuffer[64 * 64 * 3];
+// Foto recibida, ya en RGB565 listo para pintar (convertida en la tarea de red)
+extern uint16_t photo565[PANEL_RES_Y][PANEL_RES_X];
 extern char photoTitle[64];
 extern char photoAuthor[64];
 
-// MQTT response flags (request/response pattern)
-// mqttResponseType era un String mutado desde ambos cores: String hace
-// malloc/free en cada asignacion y corrompia el heap (PANIC StoreProhibited
-// en multi_heap, cazado por telemetria 2026-08-07). Enum plano, sin heap.
+// Tipos de request/response (mqtt_request.h)
+// Eran un String mutado desde ambos cores: String hace malloc/free en cada
+// asignacion y corrompia el heap (PANIC StoreProhibited en multi_heap, cazado
+// por telemetria 2026-08-07). Enum plano, sin heap.
 enum MqttRespType : uint8_t {
     RESP_NONE = 0, RESP_SONG, RESP_COVER, RESP_PHOTO,
     RESP_OTA, RESP_CONFIG, RESP_REGISTER
 };
 const char* respName(uint8_t t);
-extern volatile bool mqttResponseReceived;
-extern volatile bool mqttResponseSuccess;
-extern volatile uint8_t mqttResponseType; // MqttRespType
-extern uint32_t mqttRequestId;
-extern volatile uint32_t mqttResponseRequestId;
 extern volatile int mqttRegisterFrameId;
 
 // Loop variable
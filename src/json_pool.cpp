@@ -0,0 +1,112 @@
+#include "json_pool.h"
+
+// Cabecera de cada bloque del area: su tamano, para poder crecer el ultimo
+// bloque en su sitio o copiarlo al moverlo. 8 bytes para que los datos
+// queden alineados a 8 (doubles)
+#define BLOCK_HEADER 8
+
+static uint8_t s_area[JSON_POOL_SIZE > 0 ? JSON_POOL_SIZE : 1] __attribute__((aligned(8)));
+
+class JsonPool : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        if (!live) used = 0; // nadie tiene memoria del area: empezar de nuevo
+        void* p = areaAlloc(size);
+        if (!p) {
+            p = malloc(size);
+            if (!p) return nullptr;
+            heapAllocs++;
+        }
+        live++;
+        return p;
+    }
+
+    void deallocate(void* p) override {
+        if (!p) return;
+        live--;
+        if (!inArea(p)) {
+            free(p);
+            return;
+        }
+        // Solo se recupera el ultimo bloque; el resto, al vaciarse el area
+        if ((uint8_t*)p + blockSize(p) == s_area + used) used = (uint8_t*)p - BLOCK_HEADER - s_area;
+    }
+
+    void* reallocate(void* p, size_t size) override {
+        if (!p) return allocate(size);
+        if (!inArea(p)) return realloc(p, size);
+        size_t old = blockSize(p);
+        // El ultimo bloque crece o encoge en su sitio (las cadenas mientras se
+        // parsean, la pagina de variantes al ajustarse)
+        uint8_t* end = s_area + used;
+        if ((uint8_t*)p + old == end) {
+            size_t start = (uint8_t*)p - s_area;
+            if (start + align(size) <= JSON_POOL_SIZE) {
+                used = start + align(size);
+                setBlockSize(p, align(size));
+                trackPeak();
+                return p;
+            }
+        } else if (size <= old) {
+            return p;
+        }
+        void* q = allocate(size);
+        if (!q) return nullptr;
+        memcpy(q, p, min(old, size));
+        deallocate(p);
+        return q;
+    }
+
+    size_t peak = 0;
+    uint32_t heapAllocs = 0;
+
+private:
+    size_t used = 0;
+    int live = 0;
+
+    static size_t align(size_t n) {
+        return (n + 7) & ~(size_t)7;
+    }
+    static bool inArea(void* p) {
+        return (uint8_t*)p >= s_area && (uint8_t*)p < s_area + JSON_POOL_SIZE;
+    }
+    static size_t blockSize(void* p) {
+        return *(uint32_t*)((uint8_t*)p - BLOCK_HEADER);
+    }
+    static void setBlockSize(void* p, size_t size) {
+        *(uint32_t*)((uint8_t*)p - BLOCK_HEADER) = size;
+    }
+    void trackPeak() {
+        if (used > peak) peak = used;
+    }
+    void* areaAlloc(size_t size) {
+        size = align(size);
+        if (used + BLOCK_HEADER + size > (size_t)JSON_POOL_SIZE) return nullptr;
+        uint8_t* p = s_area + used + BLOCK_HEADER;
+        setBlockSize(p, size);
+        used += BLOCK_HEADER + size;
+        trackPeak();
+        return p;
+    }
+};
+
+static JsonPool s_pool;
+
+ArduinoJson::Allocator* jsonPool() {
+    return &s_pool;
+}
+
+JsonDocument jsonFilter(const char* spec) {
+    JsonDocument filter;
+    DeserializationError error = deserializeJson(filter, spec);
+    if (error) LOGF("[JSON] Filtro invalido (%s): %s", error.c_str(), spec);
+    filter.shrinkToFit();
+    return filter;
+}
+
+void jsonPoolStats(size_t* peak, uint32_t* heapAllocs) {
+    *peak = s_pool.peak;
+    *heapAllocs = s_pool.heapAllocs;
+    s_pool.peak = 0;
+    s_pool.heapAllocs = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef JSON_POOL_H
+#define JSON_POOL_H
+
+#include "globals.h"
+
+// Memoria de los JsonDocument de la tarea de red. Con el allocator por
+// defecto cada mensaje (comando, config, registro, cabecera de foto) hacia
+// varios malloc/free: la pagina de variantes, la lista de paginas y una
+// cadena por cada clave y valor. Aqui salen de un area estatica de
+// JSON_POOL_SIZE bytes que se reutiliza: se asigna avanzando un puntero y
+// vuelve a empezar cuando el ultimo documento libera su memoria. Si un mensaje
+// no cabe (un draw_stroke con muchos puntos) lo que falta sale del heap.
+//
+// Junto con los filtros (solo se guardan los campos que lee cada handler) un
+// mensaje normal no toca el heap. Solo para la tarea de red (o el setup antes
+// de arrancarla): sin seccion critica.
+//
+// -DJSON_POOL_SIZE=0 deja el area vacia: todo sale del heap, como con el
+// allocator por defecto, y el [Diag] de mqtt_rx cuenta cada reserva. Para
+// comparar en placa el antes y el despues: heap libre minimo, reservas por
+// mensaje y stack libre minimo de la tarea de red con cada build.
+
+#ifndef JSON_POOL_SIZE
+#define JSON_POOL_SIZE 2048
+#endif
+
+// Para JsonDocument doc(jsonPool())
+ArduinoJson::Allocator* jsonPool();
+
+// Filtro para DeserializationOption::Filter a partir de su JSON
+// ({"campo":true,...}); se construye una vez, en el heap
+JsonDocument jsonFilter(const char* spec);
+
+// [Diag] uso maximo del area y reservas que cayeron al heap desde la ultima
+// llamada (se ponen a cero)
+void jsonPoolStats(size_t* peak, uint32_t* heapAllocs);
+
+#endif
@@ -0,0 +1,224 @@
+#include <Arduino.h>
+#include "pixel_kernels.h"
+#include "blit.h"
+#include "color_pipeline.h"
+
+// Comprueba que los kernels SWAR dan lo mismo que los escalares (datos
+// aleatorios, anchos impares y origen desalineado) y mide
+// cuanto tarda cada version en el chip, y lo que cuesta por foto la gamma +
+// dither frente a truncar. Con el panel conectado mide tambien el blitter de
+// frames (blit.h) frente al bucle de drawPixel de antes:
+// pio run -e test-kernels -t upload
+
+#define TEST_LOG(fmt, ...) Serial.printf("[%lu] " fmt "\n", millis(), ##__VA_ARGS__); Serial.flush()
+
+#define TRIALS 50
+#define BENCH_ITERS 200
+
+static uint8_t src888[64 * 64 * 3 + 1];
+static uint8_t srcBe[64 * 64 * 2 + 1];
+static uint16_t outA[64 * 64];
+static uint16_t outB[64 * 64];
+static uint8_t halfA[32 * 32 * 2];
+static uint8_t halfB[32 * 32 * 2];
+static uint8_t lut[256];
+static uint8_t testFrame[64 * 64 * 2]; // frame de animacion RGB565 big-endian
+
+static void fillRandom(uint8_t* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) buf[i] = esp_random();
+}
+
+static int checkKernels() {
+    int fails = 0;
+    for (int trial = 0; trial < TRIALS; trial++) {
+        fillRandom(src888, sizeof(src888));
+        fillRandom(srcBe, sizeof(srcBe));
+        // Gamma invertida en la mitad de las pruebas; valores cerca de 255
+        // en un tercio para ejercitar la saturacion del dither
+        for (int i = 0; i < 256; i++) lut[i] = trial % 2 ? i : 255 - i;
+        if (trial % 3 == 0) {
+            for (size_t i = 0; i < sizeof(src888); i++) src888[i] = 250 + src888[i] % 6;
+        }
+
+        for (int y = 0; y < 64; y++) {
+            int x = esp_random() % 8;
+            const uint8_t* row = src888 + 1 + y * 64 * 3;
+            pkGbr888ToRow565Scalar(outA, row, 64 - x, x, y, lut);
+            pkGbr888ToRow565Swar(outB, row, 64 - x, x, y, lut);
+            if (memcmp(outA, outB, (64 - x) * 2) != 0) fails++;
+        }
+        const int lens[] = {1, 2, 63, 64, 64 * 64 - 1};
+        for (int n : lens) {
+            pkBe565ToNativeScalar(outA, srcBe + 1, n);
+            pkBe565ToNativeSwar(outB, srcBe + 1, n);
+            if (memcmp(outA, outB, n * 2) != 0) fails++;
+        }
+        pkDownscale2x565Scalar(halfA, srcBe + 1, 64, 64);
+        pkDownscale2x565Swar(halfB, srcBe + 1, 64, 64);
+        if (memcmp(halfA, halfB, sizeof(halfA)) != 0) fails++;
+    }
+    return fails;
+}
+
+// Ciclos medios por imagen 64x64 de fn
+template <typename Fn>
+static uint32_t benchCycles(Fn fn) {
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ITERS; i++) fn();
+    return (ESP.getCycleCount() - start) / BENCH_ITERS;
+}
+
+static void benchKernels() {
+    uint32_t scalar, swar;
+
+    scalar = benchCycles([] { for (int y = 0; y < 64; y++) pkGbr888ToRow565Scalar(outA + y * 64, src888 + y * 192, 64, 0, y, lut); });
+    swar = benchCycles([] { for (int y = 0; y < 64; y++) pkGbr888ToRow565Swar(outA + y * 64, src888 + y * 192, 64, 0, y, lut); });
+    TEST_LOG("888->565: escalar %6u ciclos, swar %6u ciclos", (unsigned)scalar, (unsigned)swar);
+
+    // Coste por foto de la gamma por tabla + dither 4x4 (color_pipeline.h)
+    // frente a truncar a 5/6 bits, como se convertia antes
+    uint32_t mhz = getCpuFrequencyMhz();
+    uint32_t trunc = benchCycles([] {
+        for (int i = 0; i < 64 * 64; i++) {
+            const uint8_t* p = src888 + i * 3; // GBR
+            outA[i] = ((p[2] & 0xF8) << 8) | ((p[0] & 0xFC) << 3) | (p[1] >> 3);
+        }
+    });
+    uint32_t perPixel = benchCycles([] {
+        for (int i = 0; i < 64 * 64; i++) {
+            const uint8_t* p = src888 + i * 3;
+            outA[i] = photoPixelTo565(p[2], p[0], p[1], i % 64, i / 64);
+        }
+    });
+    uint32_t rows = benchCycles([] { for (int y = 0; y < 64; y++) pkGbr888ToRow565(outA + y * 64, src888 + y * 192, 64, 0, y, colorGammaLut); });
+    TEST_LOG("gamma+dither por foto: truncado %6u ciclos (%u us), pixel a pixel (QOI) %6u ciclos (%u us), por filas (raw888) %6u ciclos (%u us)",
+        (unsigned)trunc, (unsigned)(trunc / mhz), (unsigned)perPixel, (unsigned)(perPixel / mhz),
+        (unsigned)rows, (unsigned)(rows / mhz));
+
+    scalar = benchCycles([] { pkBe565ToNativeScalar(outA, srcBe, 64 * 64); });
+    swar = benchCycles([] { pkBe565ToNativeSwar(outA, srcBe, 64 * 64); });
+    TEST_LOG("be->nativo: escalar %6u ciclos, swar %6u ciclos", (unsigned)scalar, (unsigned)swar);
+
+    scalar = benchCycles([] { pkDownscale2x565Scalar(halfA, srcBe, 64, 64); });
+    swar = benchCycles([] { pkDownscale2x565Swar(halfA, srcBe, 64, 64); });
+    TEST_LOG("64->32: escalar %6u ciclos, swar %6u ciclos", (unsigned)scalar, (unsigned)swar);
+}
+
+// drawAnimationFrame antes del blitter: un drawPixel por pixel libre de overlay
+static void drawPixelLoop(const uint8_t* frame, uint8_t width) {
+    if (width == 64) {
+        for (int y = 0; y < 64; y++) {
+            for (int x = 0; x < 64; x++) {
+                if (overlayMaskGet(x, y)) continue;
+                int idx = (y * 64 + x) * 2;
+                dma_display->drawPixel(x, y, (frame[idx] << 8) | frame[idx + 1]);
+            }
+        }
+        return;
+    }
+    for (int y = 0; y < 32; y++) {
+        for (int x = 0; x < 32; x++) {
+            int px = x * 2, py = y * 2;
+            int idx = (y * 32 + x) * 2;
+            uint16_t color = (frame[idx] << 8) | frame[idx + 1];
+            if (!overlayMaskGet(px, py)) dma_display->drawPixel(px, py, color);
+            if (!overlayMaskGet(px + 1, py)) dma_display->drawPixel(px + 1, py, color);
+            if (!overlayMaskGet(px, py + 1)) dma_display->drawPixel(px, py + 1, color);
+            if (!overlayMaskGet(px + 1, py + 1)) dma_display->drawPixel(px + 1, py + 1, color);
+        }
+    }
+}
+
+// Panel como en main.cpp (v2)
+static bool initPanel() {
+    HUB75_I2S_CFG mxconfig(PANEL_RES_X, PANEL_RES_Y, PANEL_CHAIN);
+    mxconfig.gpio.r1 = R1_PIN;
+    mxconfig.gpio.g1 = G1_PIN;
+    mxconfig.gpio.b1 = B1_PIN;
+    mxconfig.gpio.r2 = R2_PIN;
+    mxconfig.gpio.g2 = G2_PIN;
+    mxconfig.gpio.b2 = B2_PIN;
+    mxconfig.gpio.a = A_PIN;
+    mxconfig.gpio.b = B_PIN;
+    mxconfig.gpio.c = C_PIN;
+    mxconfig.gpio.d = D_PIN;
+    mxconfig.gpio.e = E_PIN;
+    mxconfig.gpio.clk = CLK_PIN;
+    mxconfig.gpio.lat = LAT_PIN;
+    mxconfig.gpio.oe = OE_PIN;
+    mxconfig.clkphase = false;
+    mxconfig.i2sspeed = HUB75_I2S_CFG::HZ_20M;
+    mxconfig.min_refresh_rate = 120;
+    dma_display = new MatrixPanel_I2S_DMA(mxconfig);
+    if (!dma_display->begin()) return false;
+    dma_display->setBrightness8(1);
+    dma_display->clearScreen();
+    dma_display->setRotation(135);
+    return true;
+}
+
+// Titulo y autor abajo y reloj arriba a la derecha, como en una foto animada
+static void setPhotoOverlays() {
+    overlayMaskClear();
+    for (int y = 50; y < 64; y++) {
+        for (int x = 2; x < 62; x++) overlayMaskSet(x, y);
+    }
+    for (int y = 1; y < 8; y++) {
+        for (int x = 44; x < 63; x++) overlayMaskSet(x, y);
+    }
+}
+
+// Frame con rachas de 8 pixeles iguales (degradados, fondos planos) o
+// aleatorio (el peor caso: ninguna racha que agrupar)
+static void fillFrame(bool runs) {
+    for (int i = 0; i < 64 * 64; i++) {
+        uint16_t color = runs ? (i / 8) * 0x0841 : esp_random();
+        testFrame[i * 2] = color >> 8;
+        testFrame[i * 2 + 1] = color;
+    }
+}
+
+static void benchBlit() {
+    if (!initPanel()) {
+        TEST_LOG("blit: panel no disponible, sin medida");
+        return;
+    }
+    static uint8_t width;
+    for (int masked = 0; masked < 2; masked++) {
+        if (masked) setPhotoOverlays();
+        else overlayMaskClear();
+        for (int runs = 0; runs < 2; runs++) {
+            fillFrame(runs);
+            const uint8_t widths[] = {64, 32};
+            for (uint8_t w : widths) {
+                width = w;
+                blitAnimationFrame(testFrame, width); // tramos de la mascara ya calculados
+                uint32_t before = benchCycles([] { drawPixelLoop(testFrame, width); });
+                uint32_t after = benchCycles([] { blitAnimationFrame(testFrame, width); });
+                TEST_LOG("blit %dx%d %s, %s: drawPixel %7u ciclos, tramos %7u ciclos por frame", w, w,
+                    runs ? "rachas" : "aleatorio", masked ? "con overlays" : "sin overlays",
+                    (unsigned)before, (unsigned)after);
+            }
+        }
+    }
+    overlayMaskClear();
+    dma_display->clearScreen();
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(3000);
+
+    TEST_LOG("==== KERNEL TEST ====");
+    TEST_LOG("CPU freq: %d MHz", getCpuFrequencyMhz());
+
+    int fails = checkKernels();
+    TEST_LOG("Bit-exacto: %s (%d fallos en %d pruebas)", fails == 0 ? "OK" : "FALLO", fails, TRIALS);
+    benchKernels();
+    benchBlit();
+    TEST_LOG("==== FIN ====");
+}
+
+void loop() {
+    delay(1000);
+}
@@ -9,6 +9,7 @@
 #include "schedule.h"
 #include "drawing.h"
 #include "display.h"
+#include "transition.h"
 #include "messages.h"
 #include "clock.h"
 #include "ble_provisioning.h"
@@ -16,9 +17,13 @@
 #include "mqtt_handlers.h"
 #include "photos.h"
 #include "spotify.h"
+#include "photo_prefetch.h"
 #include "mqtt_client.h"
 #include "boot_report.h"
 #include "net_task.h"
+#include "anim_cache.h"
+#include "frame_slab.h"
+#include "render_task.h"
 #include <esp_ota_ops.h>
 
 // Auto-rollback OTA
@@ -91,7 +96,13 @@ void setup()
     mxconfig.i2sspeed = HUB75_I2S_CFG::HZ_20M;
     mxconfig.min_refresh_rate = 200;
 #endif
+#ifdef PANEL_DOUBLE_BUFFER
+    // Video sin tearing: los frames se componen en el buffer trasero (panel.h)
+    mxconfig.double_buff = true;
+    dma_display = new ShadowPanel(mxconfig);
+#else
     dma_display = new MatrixPanel_I2S_DMA(mxconfig);
+#endif
 
     auto initPanel = [&]() {
         LOG("HUB75 begin()...");
@@ -118,6 +129,9 @@ void setup()
     // (el envío se hace tras conectar MQTT, en sendBootReport())
     bootReportInit();
 
+    animCacheInit();
+    frameSlabInit(); // antes de que se fragmente la PSRAM
+
     // --- Auto-rollback OTA --------------------------------------------------
     // Si venimos de instalar una version nueva (pendingVer>0) contamos arranques.
     // Si entra en boot-loop (varios reinicios sin validar) volvemos al slot OTA
@@ -276,15 +290,14 @@ void setup()
 
     // Configuración de MQTT
     mqttClient.setServer(MQTT_BROKER_URL, MQTT_BROKER_PORT);
-    mqttClient.setCallback(mqttCallback);
-    mqttClient.setKeepAlive(60);
-    mqttClient.setBufferSize(13000); // fits photo response (~12.5KB) and anim frames (8.2KB)
+    mqttClient.setKeepAlive(MQTT_KEEPALIVE);
+    mqttClient.setBufferSize(MQTT_BUFFER_SIZE); // solo salida: lo que entra lo lee mqtt_rx
     // PubSubClient espera bloqueando DENTRO de loop() a que llegue el resto de un
     // paquete fragmentado por TCP. Con el default de 15 s, una rafaga de comandos
     // de dibujo congelaba el loop entero varios segundos y se perdian hasta el
     // 65% de los mensajes (medido: bloqueo maximo de 15,01 s, exactamente el
     // default). Con 2 s se reciben el 100%.
-    mqttClient.setSocketTimeout(2);
+    mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT);
 
     // Configuración de OTA
     ArduinoOTA.setHostname(("Frame-" + String(frameId)).c_str());
@@ -295,6 +308,10 @@ void setup()
         else
             type = "filesystem";
         LOGF("Inicio de actualización OTA: %s", type.c_str());
+        // La pantalla de progreso es nuestra hasta el reinicio: el render no
+        // pinta encima (handle() puede llegar aqui con o sin el panel tomado)
+        renderLockRelease();
+        renderLock();
         showUpdateMessage();
     });
     ArduinoOTA.onEnd([]() {
@@ -319,6 +336,7 @@ void setup()
         else
             errorStr = "UNKNOWN_ERROR";
         LOGF("[ArduinoOTA:onError] Código de error: %u - %s", error, errorStr);
+        renderLockRelease(); // sin reinicio: vuelve el render
     });
     ArduinoOTA.begin();
 
@@ -366,6 +384,7 @@ void setup()
         // Initialize WDT so the loop can reset it
         esp_task_wdt_init(WDT_TIMEOUT, true);
         esp_task_wdt_add(NULL);
+        startRenderTask();
         return;
     }
 
@@ -416,24 +435,31 @@ void setup()
         photoIndex = 1;
         lastPhotoChange = millis();
     }
-}
 
-void loop()
-{
-    esp_task_wdt_reset();
+    panelPresent();
+
+    // Desde aqui el video y las transiciones (la de la primera foto incluida)
+    // los avanza la tarea de render
+    startRenderTask();
+}
 
-    // [Diag] cronometrar la iteracion para cazar qué congela el video: si una
-    // pasada tarda mas que el interval del video, ese frame se pierde
-    unsigned long tLoopStart = millis();
-    unsigned long dMqtt = 0, dSong = 0;
+// [Diag] cronometrar la iteracion para cazar qué congela el video: si una
+// pasada tarda mas que el interval del video, ese frame se pierde
+static unsigned long tLoopStart = 0;
+static unsigned long dMqtt = 0, dSong = 0;
 
+// La parte de la pasada que pinta o arranca algo, con el panel tomado
+// (render_task.h). false si la pasada acaba aqui (sin dueno, pantalla apagada
+// o modo dibujo)
+static bool loopLogic()
+{
     // Manejo de MQTT: con la tarea de red activa (core 0) el bombeo y la
     // reconexion viven alli; sin ella (fallo al crearla) modo clasico
     if (!netTaskRunning) {
         if (!mqttClient.connected()) {
             mqttReconnect();
         }else{
-            mqttClient.loop();
+            mqttRxLoop();
         }
         dMqtt = millis() - tLoopStart;
     }
@@ -464,7 +490,7 @@ void loop()
         processBLENetworkScan();
         ArduinoOTA.handle();
         delay(100);
-        return;
+        return false;
     }
 
     // Verificar y actualizar estado de la pantalla según el horario
@@ -474,7 +500,7 @@ void loop()
     if (screenOff) {
         ArduinoOTA.handle();
         delay(100);
-        return;
+        return false;
     }
 
     // Verificar timeout del modo dibujo
@@ -489,24 +515,25 @@ void loop()
 
         ArduinoOTA.handle();
         delay(10);
-        return;
+        return false;
     }
 
+    // El video acabo sus vueltas en la tarea de render: liberar su buffer y
+    // pasar a la foto pendiente antes de decidir el siguiente cambio
+    finishAnimationPlayback();
+
     // Si estamos conectados a WiFi, se ejecuta la lógica original:
     if (allowSpotify) {
-        // Solo llamar a fetchSongId si el scroll no está activo (evita bloquear el scroll)
-        // y si NO estamos cargando una animación (fetchSongId bloquea el hilo hasta 5s
-        // esperando respuesta y congelaría la descarga de frames).
-        bool scrollActive = titleNeedsScroll && (titleScrollState == SCROLL_SCROLLING || titleScrollState == SCROLL_RETURNING);
-        bool animDownloading = (currentAnimationId > 0 && !animReady);
-        if (millis() - lastSpotifyCheck >= timeToCheckSpotify && !scrollActive && !animDownloading) {
-            // [Diag] fetchSongId bloquea hasta 5s y puede correr con un video en
-            // pantalla (solo se inhibe durante la DESCARGA, no la reproduccion)
+        // Sondeo sin bloquear: la respuesta llega por la tarea de red mientras
+        // el scroll, el video y la descarga de frames siguen su curso
+        if (millis() - lastSpotifyCheck >= timeToCheckSpotify) {
+            // [Diag] solo el alta y la publicacion; ya no se espera la respuesta aqui
             unsigned long tSong = millis();
-            songOnline = fetchSongId();
-            dSong = millis() - tSong;
+            requestSongId();
             lastSpotifyCheck = millis();
+            dSong = millis() - tSong;
         }
+        pollSongId(songOnline);
         if (songOnline == "" || songOnline == "null") {
             // Si antes había canción y ahora no, mostrar foto inmediatamente
             if (songShowing != "") {
@@ -516,8 +543,9 @@ void loop()
             // Cambio normal cuando no hay video; prefetch de la siguiente cuando
             // al video actual le queda poco (la descarga corre en paralelo)
             bool downloadBusy = (currentAnimationId > 0);
+            bool swapBusy = transitionActive(); // cambio de foto a medias (transicion en curso)
             bool changeDue = !animPlaying && millis() - lastPhotoChange >= secsPhotos;
-            if (!downloadBusy && !photoPending && (changeDue || animPrefetchDue())) {
+            if (!downloadBusy && !swapBusy && !photoPending && (changeDue || animPrefetchDue())) {
                 if (photoIndex >= maxPhotos) {
                     photoIndex = 0;
                 }
@@ -536,8 +564,9 @@ void loop()
         }
     } else {
         bool downloadBusy = (currentAnimationId > 0);
+        bool swapBusy = transitionActive();
         bool changeDue = !animPlaying && millis() - lastPhotoChange >= secsPhotos;
-        if (!downloadBusy && !photoPending && (changeDue || animPrefetchDue())) {
+        if (!downloadBusy && !swapBusy && !photoPending && (changeDue || animPrefetchDue())) {
             if (photoIndex >= maxPhotos) {
                 photoIndex = 0;
             }
@@ -549,26 +578,55 @@ void loop()
         }
     }
 
-    // Actualizar el scroll del título si es necesario (solo si no hay animación
-    // reproduciéndose)
-    if (!animPlaying) {
-        updatePhotoInfo();
+    // Sin tarea de render: scroll del título (solo si no hay animación
+    // reproduciéndose) y transicion de pantalla en curso
+    if (!renderTaskRunning) {
+        if (!animPlaying) {
+            updatePhotoInfo();
+        }
+        updateTransition();
     }
 
+    // Descarga atascada: abandonarla (puede volver a la foto estatica)
+    giveUpStalledAnimationDownload();
+
     // Si la descarga de la animación terminó, sustituir la foto anterior y arrancar
-    bool animSwapped = startAnimationPlaybackIfReady();
+    // (el playback empieza cuando acaba el fundido)
+    startAnimationPlaybackIfReady();
 
-    // Reproducir animación frame a frame
-    updateAnimationPlayback();
+    // Reproducir animación frame a frame (sin tarea de render)
+    if (!renderTaskRunning) {
+        updateAnimationPlayback();
+    }
 
-    // Reintentar frames perdidos durante la descarga pipelined
-    checkAnimationDownloadTimeout();
+    // Reloj activado/desactivado por MQTT
+    if (clockOverlayPending) {
+        clockOverlayPending = false;
+        if (clockEnabled) showClockOverlay();
+        else hideClockOverlay();
+        lastClockUpdate = millis();
+    }
 
     // Actualizar reloj cada 60 segundos
     if (clockEnabled && millis() - lastClockUpdate >= 60000) {
         showClockOverlay();
         lastClockUpdate = millis();
     }
+    return true;
+}
+
+// El resto de la pasada no pinta: con el panel suelto, para que el render no
+// espere a la red (netPublish), a la flash ni al chequeo del heap
+static void loopBackground()
+{
+    // Siguientes fotos de la rotacion por adelantado (photo_prefetch.h)
+    photoPrefetchUpdate();
+
+    // Pedir frames de la descarga en curso segun la ventana (y re-pedir los perdidos)
+    updateAnimationDownload();
+
+    // Guardar en flash, slot a slot, la ultima animacion descargada
+    animCacheStoreStep();
 
     // Validar la version a prueba tras un arranque estable (uptime suficiente sin
     // reset/crash). Cancela el rollback: esta version pasa a ser la "ultima buena".
@@ -600,12 +658,12 @@ void loop()
     }
 
     // [Diag] con video activo, una iteracion mas larga que el frame interval
-    // significa frames perdidos: volcar el desglose para ver quién bloquea
+    // significa frames perdidos sin tarea de render (con ella, solo si lo lento
+    // fue loopLogic): volcar el desglose para ver quién bloquea
     {
         bool videoActive = animPlaying || (currentAnimationId > 0 && !animReady);
         unsigned long dLoop = millis() - tLoopStart;
-        // El swap+fade entre videos dura ~1,6s y es esperado: no es una anomalia
-        if (videoActive && !animSwapped && dLoop > 150) {
+        if (videoActive && dLoop > 150) {
             LOGF("[Diag] Iteracion lenta: %lums (mqtt=%lums, spotify=%lums, playing=%d loop=%lu/%lu, dl id=%d %d/%d ready=%d, heap=%d)",
                  dLoop, dMqtt, dSong, (int)animPlaying, animLoopCount, playMaxLoops,
                  currentAnimationId, animFramesReceived, animFrameCount, (int)animReady,
@@ -613,8 +671,24 @@ void loop()
         }
     }
 
+}
+
+void loop()
+{
+    esp_task_wdt_reset();
+    tLoopStart = millis();
+    dMqtt = 0;
+    dSong = 0;
+
+    renderLock();
+    bool fullPass = loopLogic();
+    renderUnlock();
+    if (fullPass) loopBackground();
+
     // Durante la descarga de una animación iteramos rápido para drenar los frames
-    // MQTT cuanto antes; durante la reproducción, para que sea fluida
-    bool animActive = animPlaying || (currentAnimationId > 0 && !animReady);
+    // MQTT cuanto antes; sin tarea de render, tambien durante la reproducción o
+    // una transicion, para que sean fluidas
+    bool rendering = !renderTaskRunning && (animPlaying || transitionActive());
+    bool animActive = rendering || (currentAnimationId > 0 && !animReady);
     wait(animActive ? 5 : 100);
 }
@@ -8,49 +8,51 @@
 #include "mqtt_handlers.h"
 #include "ble_provisioning.h"
 #include "clock.h"
+#include "json_pool.h"
+#include "photo_prefetch.h"
 
-void mqttCallback(char *topic, byte *payload, unsigned int length)
+// Respuestas del patron request/response (mqtt_routes.cpp). Las binarias
+// grandes se leen en streaming; las demas llegan a mqttCallback
+static const MqttRoute* responseRoute(const char* suffix) {
+    size_t n;
+    const MqttRoute* routes = mqttResponseRoutes(&n);
+    return mqttRouteFind(routes, n, suffix);
+}
+
+MqttStreamHandler mqttStreamHandler(const char* topic)
 {
-    String topicStr = String(topic);
+    const char* suffix = mqttResponseSuffix(topic);
+    if (!suffix) return nullptr;
+    const MqttRoute* route = responseRoute(suffix);
+    return route ? route->stream : nullptr;
+}
 
-    // Manejar respuestas del patrón request/response
-    if (topicStr.indexOf("/response/") != -1) {
-        if (topicStr.endsWith("/response/song")) {
-            handleSongResponse(payload, length);
-        }
-        else if (topicStr.endsWith("/response/cover")) {
-            handleCoverResponse(payload, length);
-        }
-        else if (topicStr.endsWith("/response/photo")) {
-            handlePhotoResponse(payload, length);
-        }
-        else if (topicStr.endsWith("/response/ota")) {
-            handleOtaResponse(payload, length);
-        }
-        else if (topicStr.endsWith("/response/config")) {
-            handleConfigResponse(payload, length);
-        }
-        else if (topicStr.endsWith("/response/register")) {
-            handleRegisterResponse(payload, length);
-        }
-        else if (topicStr.endsWith("/response/animation/frame")) {
-            handleAnimationFrameResponse(payload, length);
-        }
-        return;  // No procesar como comando normal
+void mqttCallback(char *topic, byte *payload, unsigned int length)
+{
+    // Respuestas: sin handler (o de tipo desconocido) se descartan, no son comandos
+    const char* suffix = mqttResponseSuffix(topic);
+    if (suffix) {
+        const MqttRoute* route = responseRoute(suffix);
+        if (route && route->message) route->message(payload, length);
+        return;
     }
 
-    // Crear un buffer para el mensaje (solo para comandos, no respuestas binarias)
-    char message[length + 1];
-    memcpy(message, payload, length);
-    message[length] = '\0';
+    // mqtt_rx lo entrega terminado en '\0'
+    const char* message = (const char*)payload;
 
     // Imprimir el mensaje
     LOGF("Mensaje recibido en el topic: %s", topic);
     LOGF("Mensaje: %s", message);
 
-    // Crear un documento JSON
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, message);
+    // Parsear directamente del payload; solo los campos que leen las acciones
+    static JsonDocument filter = jsonFilter(
+        "{\"action\":true,\"id\":true,\"brightness\":true,\"pictures_on_queue\":true,"
+        "\"spotify_enabled\":true,\"secs_between_photos\":true,\"schedule_enabled\":true,"
+        "\"schedule_on_hour\":true,\"schedule_on_minute\":true,\"schedule_off_hour\":true,"
+        "\"schedule_off_minute\":true,\"timezone_offset\":true,\"clock_enabled\":true,"
+        "\"has_owner\":true,\"x\":true,\"y\":true,\"color\":true,\"size\":true,\"points\":true}");
+    JsonDocument doc(jsonPool());
+    DeserializationError error = deserializeJson(doc, message, length, DeserializationOption::Filter(filter));
 
     if (!error)
     {
@@ -78,6 +80,7 @@ void mqttCallback(char *topic, byte *payload, unsigned int length)
                 }
                 if (doc.containsKey("pictures_on_queue")) {
                     maxPhotos = doc["pictures_on_queue"];
+                    photoPrefetchInvalidate();
                     preferences.putInt("maxPhotos", maxPhotos);
                     LOGF("[MQTT] Max photos: %d", maxPhotos);
                 }
@@ -127,11 +130,8 @@ void mqttCallback(char *topic, byte *payload, unsigned int length)
                     clockEnabled = doc["clock_enabled"];
                     preferences.putBool("clockEnabled", clockEnabled);
                     LOGF("[MQTT] Clock enabled: %s", clockEnabled ? "true" : "false");
-                    if (clockEnabled && !wasEnabled) {
-                        showClockOverlay();
-                    } else if (!clockEnabled && wasEnabled) {
-                        hideClockOverlay();
-                    }
+                    // Pintar/quitar el reloj toca el compositor: diferir al core 1
+                    if (clockEnabled != wasEnabled) clockOverlayPending = true;
                 }
                 if (doc.containsKey("has_owner")) {
                     bool hasOwner = doc["has_owner"];
@@ -270,6 +270,7 @@ void mqttReconnect()
         if (connected)
         {
             LOG("[MQTT:mqttReconnect] Conectado exitosamente");
+            mqttRxReset();
 
             // Suscribirse al topic principal de comandos
             String topic = String("frame/") + String(frameId);
@@ -281,7 +282,9 @@ void mqttReconnect()
             }
 
             // Suscribirse a topics de respuesta (para patrón request/response)
-            String responseTopic = String("frame/") + String(frameId) + "/response/#";
+            String responsePrefix = String("frame/") + String(frameId) + "/response/";
+            mqttTopicsSetPrefix(responsePrefix.c_str());
+            String responseTopic = responsePrefix + "#";
             LOGF("[MQTT:mqttReconnect] Suscribiendo a respuestas: %s", responseTopic.c_str());
             if (mqttClient.subscribe(responseTopic.c_str())) {
                 LOG("[MQTT:mqttReconnect] Suscripción a respuestas exitosa");
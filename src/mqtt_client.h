@@ -2,8 +2,13 @@
 #define MQTT_CLIENT_H
 
 #include "globals.h"
+#include "mqtt_rx.h"
 
+// payload terminado en '\0' (mqtt_rx.h)
 void mqttCallback(char *topic, byte *payload, unsigned int length);
+// Handler en streaming del topic (respuestas binarias grandes); nullptr si va
+// entero a mqttCallback
+MqttStreamHandler mqttStreamHandler(const char* topic);
 void mqttReconnect();
 void applyFactoryReset();  // core 1: procesado del flag pendingFactoryReset
 void applyEnvVarsReset();  // core 1: procesado del flag pendingEnvVarsReset
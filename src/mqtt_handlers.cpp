@@ -3,85 +3,31 @@
 #include "ble_provisioning.h"
 #include "photos.h"
 #include "net_task.h"
-
-// Forward declaration (defined in mqtt_client.cpp)
-void mqttCallback(char *topic, byte *payload, unsigned int length);
-
-// Armar la espera ANTES de publicar el request: con la tarea de red en core 0
-// la respuesta puede llegar antes de entrar en waitForMqttResponse, y si los
-// flags se resetearan alli se perderia.
-void armMqttResponseWait() {
-    mqttResponseReceived = false;
-    mqttResponseSuccess = false;
-    mqttResponseType = RESP_NONE;
-}
-
-bool waitForMqttResponse(uint8_t expectedType, unsigned long timeout) {
-    unsigned long start = millis();
-
-    while ((millis() - start) < timeout) {
-        esp_task_wdt_reset();
-        if (!netTaskRunning) {
-            // Sin tarea de red (flujo de setup): bombear aquí como siempre.
-            // [Diag] mqttClient.loop() puede bloquear hasta el socket timeout (2s)
-            // con paquetes fragmentados
-            unsigned long tMqtt = millis();
-            mqttClient.loop();
-            unsigned long dMqtt = millis() - tMqtt;
-            if (dMqtt > 300) {
-                LOGF("[Diag] mqttClient.loop() bloqueó %lums esperando '%s' (playing=%d)",
-                     dMqtt, respName(expectedType), (int)animPlaying);
-            }
-        }
-        // Con tarea de red, el bombeo corre en core 0: aquí solo esperamos el
-        // flag sin dejar de pintar
-        updateAnimationPlayback(); // no congelar un video en curso durante la espera
-        yield();
-        delay(10);
-
-        // Solo salir si recibimos la respuesta del tipo esperado Y fue exitosa
-        if (mqttResponseReceived && mqttResponseType == expectedType) {
-            if (mqttResponseSuccess) {
-                unsigned long waited = millis() - start;
-                if (waited > 1000) {
-                    LOGF("[Diag] Respuesta '%s' tardó %lums (playing=%d, dl id=%d %d/%d)",
-                         respName(expectedType), waited, (int)animPlaying,
-                         currentAnimationId, animFramesReceived, animFrameCount);
-                }
-                return true;
-            }
-            // Respuesta stale (reqId incorrecto) - seguir esperando la buena
-            LOGF("[MQTT] Respuesta stale descartada, seguimos esperando '%s'", respName(expectedType));
-            mqttResponseReceived = false;
-            mqttResponseType = RESP_NONE;
-            continue;
-        }
-
-        // Si recibimos respuesta de otro tipo (tardía), ignorarla y seguir esperando
-        if (mqttResponseReceived && mqttResponseType != expectedType) {
-            LOGF("[MQTT] Ignorando respuesta tardía tipo '%s' (esperando '%s')",
-                 respName(mqttResponseType), respName(expectedType));
-            mqttResponseReceived = false;
-            mqttResponseType = RESP_NONE;
-        }
-    }
-
-    LOGF("[MQTT] Timeout esperando respuesta %s", respName(expectedType));
-    return false;
-}
+#include "render_task.h"
+#include "display.h"
+#include "photo_codec.h"
+#include "pixel_kernels.h"
+#include "frame_delta.h"
+#include "frame_indexed.h"
+#include "frame_store.h"
+#include "anim_window.h"
+#include "anim_cache.h"
+#include "photo_cache.h"
+#include "photo_prefetch.h"
+#include "transition.h"
+#include "mqtt_rx.h"
+#include "mqtt_request.h"
+#include "json_pool.h"
 
 void handleSongResponse(byte* payload, unsigned int length) {
     songIdBuffer[0] = '\0';
 
-    if (length > 0 && length < sizeof(httpBuffer)) {
-        memcpy(httpBuffer, payload, length);
-        httpBuffer[length] = '\0';
-
-        // Parsear para extraer el id
-        char *idStart = strstr(httpBuffer, "\"id\":\"");
+    if (length > 0) {
+        // Extraer el id del payload (mqtt_rx lo entrega terminado en '\0')
+        const char *idStart = strstr((const char*)payload, "\"id\":\"");
         if (idStart) {
             idStart += 6;
-            char *idEnd = strchr(idStart, '"');
+            const char *idEnd = strchr(idStart, '"');
             if (idEnd && (idEnd - idStart) < 63) {
                 int idLen = idEnd - idStart;
                 strncpy(songIdBuffer, idStart, idLen);
@@ -90,114 +36,211 @@ void handleSongResponse(byte* payload, unsigned int length) {
         }
     }
 
-    mqttResponseReceived = true;
-    mqttResponseSuccess = true;
-    mqttResponseType = RESP_SONG;
+    mqttRequestComplete(RESP_SONG, true);
 }
 
-void handleCoverResponse(byte* payload, unsigned int length) {
-    if (length == 8192) {
-        memcpy(spotifyCoverBuffer, payload, length);
-        mqttResponseSuccess = true;
+// Directamente del socket a spotifyCoverBuffer. Sin request pendiente (llega
+// tarde, tras el timeout) no se toca: puede estar en pantalla
+void streamCoverResponse(uint32_t length) {
+    if (!mqttRequestExpected(RESP_COVER, 0)) {
+        LOG("[MQTT] Cover sin request pendiente, descartado");
+        return;
+    }
+    bool ok = length == 8192 && mqttRxRead(spotifyCoverBuffer, length);
+    if (ok) {
         LOG("[MQTT] Cover recibido correctamente");
     } else {
-        LOGF("[MQTT] Cover con tamaño incorrecto: %d (esperado 8192)", length);
-        mqttResponseSuccess = false;
+        LOGF("[MQTT] Cover con tamaño incorrecto o incompleto: %u (esperado 8192)", (unsigned)length);
     }
-    mqttResponseReceived = true;
-    mqttResponseType = RESP_COVER;
+    mqttRequestComplete(RESP_COVER, ok);
 }
 
-void handlePhotoResponse(byte* payload, unsigned int length) {
-    photoTitle[0] = '\0';
-    photoAuthor[0] = '\0';
+// Respuesta de un prefetch (photo_prefetch.h): a su entrada de la cache, sin
+// tocar photo565, photoTitle/photoAuthor ni el estado de animacion (puede
+// haber una foto o un video en pantalla)
+static void streamPrefetchedPhoto(JsonDocument& doc, uint32_t reqId, int index, uint8_t generation) {
+    if (doc["notModified"] | false) {
+        bool ok = photoCacheRevalidate(index, generation);
+        LOGF("[Prefetch] Foto index=%d sin cambios%s", index, ok ? "" : " pero ya no vale (fuera de cache o invalidada)");
+        mqttRequestComplete(RESP_PHOTO, ok, reqId);
+        return;
+    }
+    if (doc["animation"] | false) {
+        LOGF("[Prefetch] Index=%d es una animacion: se pedira al mostrarla", index);
+        mqttRequestComplete(RESP_PHOTO, false, reqId);
+        return;
+    }
+    uint16_t* pixels = photoCacheBeginPrefetch(index, generation, doc["title"] | "", doc["author"] | "");
+    if (!pixels) {
+        LOGF("[Prefetch] Sin memoria para la foto index=%d", index);
+        mqttRequestComplete(RESP_PHOTO, false, reqId);
+        return;
+    }
+    PhotoEncoding enc = photoEncodingFromName(doc["enc"] | "raw888");
+    photoDecodeBegin(enc, pixels);
+    uint8_t chunk[256];
+    bool complete = true;
+    while (mqttRxRemaining()) {
+        size_t n = min((size_t)mqttRxRemaining(), sizeof(chunk));
+        if (!mqttRxRead(chunk, n)) {
+            complete = false;
+            break;
+        }
+        photoDecodeFeed(chunk, n);
+    }
+    bool ok = photoDecodeEnd() && complete;
+    photoCacheEndPrefetch(index, ok, doc["etag"] | (const char*)nullptr);
+    LOGF("[Prefetch] Foto index=%d %s", index, ok ? "lista" : "invalida");
+    mqttRequestComplete(RESP_PHOTO, ok, reqId);
+}
 
-    // Formato: {"title":"x","author":"y","reqId":N}\n[12288 bytes binarios]
-    // Buscar el newline que separa JSON de binario
+void streamPhotoResponse(uint32_t length) {
+    // Formato: {"title":"x","author":"y","reqId":N,"enc":"qoi"}\n[binario]
+    // El binario va en el formato que eligio el backend de los que anunciamos
+    // en el request (sin "enc": raw888, 12288 bytes)
+    // Leer la cabecera JSON hasta el newline que la separa del binario
+    char jsonBuf[256];
     int jsonEnd = -1;
+    uint32_t reqId = 0;
     for (unsigned int i = 0; i < min(length, 256u); i++) {
-        if (payload[i] == '\n') {
+        uint8_t c;
+        if (!mqttRxRead(&c, 1)) break;
+        if (c == '\n') {
             jsonEnd = i;
             break;
         }
+        jsonBuf[i] = c;
     }
 
-    if (jsonEnd > 0 && (length - jsonEnd - 1) >= 12288) {
+    if (jsonEnd > 0) {
         // Parsear JSON metadata
-        char jsonBuf[256];
-        memcpy(jsonBuf, payload, jsonEnd);
         jsonBuf[jsonEnd] = '\0';
 
-        JsonDocument doc;
-        if (deserializeJson(doc, jsonBuf) == DeserializationError::Ok) {
-            // Filtrar respuestas stale: ignorar si reqId no coincide
-            if (doc.containsKey("reqId")) {
-                uint32_t respReqId = doc["reqId"];
-                if (respReqId != mqttRequestId) {
-                    LOGF("[MQTT] Ignorando foto stale (reqId=%d, esperado=%d): %s",
-                         respReqId, mqttRequestId, (const char*)(doc["title"] | "?"));
-                    mqttResponseReceived = true;
-                    mqttResponseType = RESP_PHOTO;
-                    mqttResponseSuccess = false;
-                    return;
+        static JsonDocument filter = jsonFilter(
+            "{\"reqId\":true,\"title\":true,\"author\":true,\"enc\":true,\"notModified\":true,"
+            "\"etag\":true,\"animation\":true,\"animationId\":true,\"totalFrames\":true,\"fps\":true,"
+            "\"palette\":true,\"frameRange\":true}");
+        JsonDocument doc(jsonPool());
+        PhotoEncoding enc = PHOTO_ENC_RAW888;
+        if (deserializeJson(doc, jsonBuf, jsonEnd, DeserializationOption::Filter(filter)) == DeserializationError::Ok) {
+            // Filtrar respuestas stale: ignorar si su request ya no esta
+            // pendiente (timeout, o una foto pedida despues)
+            reqId = doc["reqId"] | 0;
+            if (!mqttRequestExpected(RESP_PHOTO, reqId)) {
+                LOGF("[MQTT] Ignorando foto stale (reqId=%u): %s",
+                     (unsigned)reqId, (const char*)(doc["title"] | "?"));
+                return;
+            }
+
+            uint8_t prefetchGeneration = 0;
+            int prefetchIndex = photoPrefetchIndex(reqId, &prefetchGeneration);
+            if (prefetchIndex >= 0) {
+                streamPrefetchedPhoto(doc, reqId, prefetchIndex, prefetchGeneration);
+                return;
+            }
+
+            // Revalidacion (photo_cache.h): la foto que tenemos sigue valiendo
+            if (doc["notModified"] | false) {
+                bool ok = photoCacheRestore();
+                if (ok) {
+                    resetAnimationDownloadState(true); // es una foto estatica
+                    LOGF("[MQTT] Foto sin cambios (reqId=%u), desde cache: %s by %s",
+                         (unsigned)reqId, photoTitle, photoAuthor);
+                } else {
+                    LOG("[MQTT] notModified para una foto que ya no esta en cache");
                 }
+                mqttRequestComplete(RESP_PHOTO, ok, reqId);
+                return;
             }
 
             strncpy(photoTitle, doc["title"] | "", sizeof(photoTitle) - 1);
             strncpy(photoAuthor, doc["author"] | "", sizeof(photoAuthor) - 1);
             photoTitle[sizeof(photoTitle) - 1] = '\0';
             photoAuthor[sizeof(photoAuthor) - 1] = '\0';
+            enc = photoEncodingFromName(doc["enc"] | "raw888");
+        } else {
+            photoTitle[0] = '\0';
+            photoAuthor[0] = '\0';
         }
 
-        // Copiar datos binarios (first frame as photo - always works, even for animations)
-        memcpy(photoBuffer, payload + jsonEnd + 1, 12288);
-        mqttResponseSuccess = true;
+        // Datos binarios (first frame as photo - always works, even for animations).
+        // Se decodifican aqui, una vez y en core 0, al RGB565 que pintan el
+        // fundido y el revelado, a medida que llegan del socket
+        uint32_t binLen = mqttRxRemaining();
+        unsigned long t0 = micros();
+        photoDecodeBegin(enc);
+        uint8_t chunk[256];
+        bool complete = true;
+        while (mqttRxRemaining()) {
+            size_t n = min((size_t)mqttRxRemaining(), sizeof(chunk));
+            if (!mqttRxRead(chunk, n)) {
+                complete = false;
+                break;
+            }
+            photoDecodeFeed(chunk, n);
+        }
+        if (!photoDecodeEnd() || !complete) {
+            LOGF("[MQTT] Foto %s invalida (%u bytes)", photoEncodingName(enc), (unsigned)binLen);
+            mqttRequestComplete(RESP_PHOTO, false, reqId);
+            return;
+        }
+        LOGF("[MQTT] Foto %s: %u bytes, decodificada en %luus",
+             photoEncodingName(enc), (unsigned)binLen, micros() - t0);
 
         // Check if this is an animation (new firmware detects extra fields).
         // Solo se toca el estado de DESCARGA: un video reproduciendose sigue
         // intacto (es el caso del prefetch del siguiente).
         if (doc.containsKey("animation") && doc["animation"].as<bool>()) {
+            photoCacheDrop();
             currentAnimationId = doc["animationId"] | -1;
-            animFrameCount = doc["totalFrames"] | 0;
+            // El indice de frame del header es un byte: mas frames no se pueden pedir
+            animFrameCount = min((int)(doc["totalFrames"] | 0), 255);
             animFps = doc["fps"] | 10;
+            animPaletteOffered = doc["palette"] | false;
+            animRangeOffered = doc["frameRange"] | false;
+            // En cache: startAnimationDownloadIfNeeded la carga de flash sin pedir frames
+            animFromCache = animCacheContains(currentAnimationId);
             animFramesReceived = 0;
             animReady = false;
-            LOGF("[MQTT] Animation detected: id=%d, frames=%d, fps=%d", currentAnimationId, animFrameCount, animFps);
+            LOGF("[MQTT] Animation detected: id=%d, frames=%d, fps=%d, palette=%d, range=%d, cache=%d",
+                 currentAnimationId, animFrameCount, animFps, (int)animPaletteOffered, (int)animRangeOffered,
+                 (int)animFromCache);
         } else {
             // Foto normal: cancelar cualquier descarga pendiente (la reproduccion
             // en curso no se toca; la foto quedara como photoPending si hace falta)
             resetAnimationDownloadState(true);
+            photoCacheStore(doc["etag"] | (const char*)nullptr);
         }
 
-        LOGF("[MQTT] Photo received (reqId=%d): %s by %s", mqttRequestId, photoTitle, photoAuthor);
+        LOGF("[MQTT] Photo received (reqId=%u): %s by %s", (unsigned)reqId, photoTitle, photoAuthor);
+        mqttRequestComplete(RESP_PHOTO, true, reqId);
     } else {
-        LOGF("[MQTT] Foto con formato incorrecto: length=%d, jsonEnd=%d", length, jsonEnd);
-        mqttResponseSuccess = false;
+        LOGF("[MQTT] Foto con formato incorrecto: length=%u, jsonEnd=%d", (unsigned)length, jsonEnd);
+        mqttRequestComplete(RESP_PHOTO, false);
     }
-    mqttResponseReceived = true;
-    mqttResponseType = RESP_PHOTO;
 }
 
 void handleOtaResponse(byte* payload, unsigned int length) {
-    if (length > 0 && length < sizeof(httpBuffer) - 1) {
+    bool ok = length > 0 && length < sizeof(httpBuffer) - 1;
+    if (ok) {
         memcpy(httpBuffer, payload, length);
         httpBuffer[length] = '\0';
-        mqttResponseSuccess = true;
         LOG("[MQTT] Respuesta OTA recibida");
-    } else {
-        mqttResponseSuccess = false;
     }
-    mqttResponseReceived = true;
-    mqttResponseType = RESP_OTA;
+    mqttRequestComplete(RESP_OTA, ok);
 }
 
 void handleConfigResponse(byte* payload, unsigned int length) {
-    if (length > 0 && length < sizeof(httpBuffer) - 1) {
-        memcpy(httpBuffer, payload, length);
-        httpBuffer[length] = '\0';
-
-        JsonDocument doc;
-        if (deserializeJson(doc, httpBuffer) == DeserializationError::Ok) {
+    bool ok = false;
+    if (length > 0) {
+        static JsonDocument filter = jsonFilter(
+            "{\"brightness\":true,\"pictures_on_queue\":true,\"spotify_enabled\":true,"
+            "\"secs_between_photos\":true,\"schedule_enabled\":true,\"schedule_on_hour\":true,"
+            "\"schedule_on_minute\":true,\"schedule_off_hour\":true,\"schedule_off_minute\":true,"
+            "\"timezone_offset\":true,\"clock_enabled\":true,\"has_owner\":true}");
+        JsonDocument doc(jsonPool());
+        if (deserializeJson(doc, (const char*)payload, length, DeserializationOption::Filter(filter)) ==
+            DeserializationError::Ok) {
             if (doc.containsKey("brightness")) {
                 brightness = doc["brightness"];
                 if (startupBrightnessRampDone) {
@@ -208,6 +251,7 @@ void handleConfigResponse(byte* payload, unsigned int length) {
             }
             if (doc.containsKey("pictures_on_queue")) {
                 maxPhotos = doc["pictures_on_queue"];
+                photoPrefetchInvalidate();
                 preferences.putInt("maxPhotos", maxPhotos);
                 LOGF("[MQTT] Config max photos: %d", maxPhotos);
             }
@@ -263,53 +307,177 @@ void handleConfigResponse(byte* payload, unsigned int length) {
                 if (!hasOwner) enterWaitingForOwnerMode();
                 else exitWaitingForOwnerMode();
             }
-            mqttResponseSuccess = true;
+            ok = true;
             LOG("[MQTT] Configuración recibida correctamente");
         } else {
             LOG("[MQTT] Error parseando config JSON");
-            mqttResponseSuccess = false;
         }
-    } else {
-        mqttResponseSuccess = false;
     }
-    mqttResponseReceived = true;
-    mqttResponseType = RESP_CONFIG;
+    mqttRequestComplete(RESP_CONFIG, ok);
 }
 
-void handleAnimationFrameResponse(byte* payload, unsigned int length) {
-    // Backend always sends 64x64 frames (8192 bytes + 4 byte header)
-    if (length < 4 + ANIM_FRAME_SIZE_64) {
-        LOGF("[MQTT:anim] Invalid frame (size=%d)", length);
-        return;
+// [Diag] bytes de frames recibidos en la descarga actual (frente a frames completos)
+static uint32_t animRxBytes = 0;
+static uint8_t animRxDeltas = 0;
+
+// Con todos los frames (y la paleta, si es indexada) la animacion esta lista.
+// Llamar con animBufLock() tomado.
+static void markAnimationReadyIfComplete() {
+    if (animReady || animFramesReceived < animFrameCount) return;
+    if (animIndexBits && !animPaletteReceived) return;
+
+    animReady = true; // el loop principal pinta la foto nueva y arranca la reproduccion
+    animReadyTime = millis(); // [Diag] para medir la latencia ready→swap
+    LOGF("[MQTT:anim] All frames received (playing=%d, loop=%lu/%lu)",
+         (int)animPlaying, animLoopCount, playMaxLoops);
+    LOGF("[Diag] Descarga: %lu bytes (%d%% de frames completos), %d/%d deltas, %d bits/pixel",
+         (unsigned long)animRxBytes,
+         (int)(animRxBytes * 100 / ((uint32_t)animFrameCount * (4 + ANIM_FRAME_SIZE_64))),
+         animRxDeltas, animFrameCount, animIndexBits ? animIndexBits : 16);
+    // Estado del core 1 leido sin sincronizar: solo para el log
+    LOGF("[Diag] Ventana: completa en %lums (cwnd=%.1f, srtt=%lums, rto=%lums, %d perdidos)",
+         animWindowElapsed(millis()), animWindowCwnd(), animWindowSrtt(), animWindowRto(), animWindowLosses());
+    FrameStoreStats st = frameStoreStats(animBuffer);
+    LOGF("[Diag] Memoria: %u bytes/frame (%u sin comprimir, %u%%), %u/%u KB de arena",
+         (unsigned)(st.storedBytes / max(1, (int)st.frames)), (unsigned)(st.rawBytes / max(1, (int)st.frames)),
+         (unsigned)(st.rawBytes ? (uint64_t)st.storedBytes * 100 / st.rawBytes : 100),
+         (unsigned)(st.storedBytes / 1024), (unsigned)(st.arenaBytes / 1024));
+}
+
+// La arena del buffer se lleno (frame_store.h): la animacion se queda con los
+// frames contiguos desde el 0, al mismo intervalo (dura menos). Lo que llegue
+// por encima se descarta como fuera de rango. Bajo animBufLock().
+static void truncateAnimationDownload(uint8_t slot) {
+    uint8_t keep = bitsetPrefix(animFramesBitmap);
+    FrameStoreStats st = frameStoreStats(animBuffer);
+    LOGF("[MQTT:anim] Sin sitio para el slot %d (%u/%u KB): animacion recortada a %d/%d frames",
+         slot, (unsigned)(st.storedBytes / 1024), (unsigned)(st.arenaBytes / 1024), keep, animFrameCount);
+    if (keep == 0) return; // sin el slot 0 no hay nada que reproducir: sigue la descarga
+    bitsetTruncate(animFramesBitmap, keep);
+    bitsetTruncate(animDeltaBitmap, keep);
+    animFrameCount = keep;
+    animFramesReceived = keep;
+    markAnimationReadyIfComplete();
+}
+
+// Descarga a la que va un frame mientras se lee del socket. Entre trozo y
+// trozo no se tiene animBufLock (esperar al socket con el lock congelaria la
+// reproduccion): si en medio el core 1 libera o reinicia el buffer (swap,
+// stop, foto nueva) el resto del frame se descarta.
+struct FrameSink {
+    uint8_t* buf;
+    uint16_t serial;
+};
+
+// Bajo animBufLock()
+static bool frameSinkAlive(const FrameSink& sink) {
+    return animBuffer == sink.buf && frameStoreSerial(sink.buf) == sink.serial;
+}
+
+// Cuerpo tal cual (frame de 64 px o indices): del socket al area de entrada
+static bool receiveFrameDirect(const FrameSink& sink, uint8_t* dst, size_t len) {
+    while (len) {
+        if (!mqttRxWait()) return false;
+        animBufLock();
+        if (!frameSinkAlive(sink)) {
+            animBufUnlock();
+            return false;
+        }
+        size_t got = mqttRxReadSome(dst, len);
+        animBufUnlock();
+        dst += got;
+        len -= got;
+    }
+    return true;
+}
+
+// v1: frame de 64 px escalado a 32 de 8 en 8 filas (el dither 4x4 del
+// escalado va por fila de destino: cada franja empieza en multiplo de 4).
+// La franja va en la pila de la tarea de red
+static bool receiveFrameDownscaled(const FrameSink& sink, uint8_t* dst) {
+    uint8_t strip[8 * 64 * 2];
+    for (int y = 0; y < 64; y += 8) {
+        if (!mqttRxRead(strip, sizeof(strip))) return false;
+        animBufLock();
+        bool alive = frameSinkAlive(sink);
+        if (alive) pkDownscale2x565(dst + (y / 2) * 32 * 2, strip, 64, 8);
+        animBufUnlock();
+        if (!alive) return false;
+    }
+    return true;
+}
+
+// Delta de len bytes, tile a tile (frame_delta.h)
+static bool receiveFrameDelta(const FrameSink& sink, uint8_t* dst, size_t len, uint8_t width, bool* isDelta) {
+    uint8_t buf[FRAME_WIRE_TILE_BYTES];
+    if (!mqttRxRead(buf, FRAME_DELTA_HEADER)) return false;
+    FrameDeltaWriter w = {};
+    animBufLock();
+    bool ok = frameSinkAlive(sink);
+    if (ok && !frameDeltaBegin(&w, dst, buf, len, width)) {
+        LOGF("[MQTT:anim] Delta invalido (size=%u)", (unsigned)len);
+        ok = false;
+    }
+    animBufUnlock();
+
+    while (ok && w.pending) {
+        if (!mqttRxRead(buf, sizeof(buf))) return false;
+        animBufLock();
+        ok = frameSinkAlive(sink);
+        if (ok) frameDeltaTile(&w, buf);
+        animBufUnlock();
+    }
+    *isDelta = w.isDelta;
+    return ok;
+}
+
+// Un frame de length bytes del PUBLISH en curso. Devuelve false solo si se
+// perdio la conexion; lo que no se use del frame se descarta.
+static bool streamAnimationFrame(uint32_t length, bool delta) {
+    uint32_t end = mqttRxRemaining() - length;
+    uint8_t hdr[4];
+    if (length < 4 || !mqttRxRead(hdr, 4)) {
+        LOGF("[MQTT:anim] Invalid frame (size=%u)", (unsigned)length);
+        return mqttRxSkip(mqttRxRemaining() - end);
     }
 
     // Corre en la tarea de red (core 0): bloquear el buffer para que el core 1
-    // no lo libere/transfiera (swap, stop, foto nueva) a mitad de escritura
+    // no lo libere/transfiera (swap, stop, foto nueva) mientras se valida
     animBufLock();
     if (!animBuffer) {
         animBufUnlock();
         LOGF("[MQTT:anim] Frame descartado (buffer null, descarga cancelada)");
-        return;
+        return mqttRxSkip(mqttRxRemaining() - end);
     }
 
-    uint8_t frameIndex = payload[0];
-    uint8_t totalFrames = payload[1];
+    // Backend always sends 64x64 frames (8192 bytes + 4 byte header), o un
+    // delta de tiles (frame_delta.h) si lo pedimos con deltaFrom, o indices
+    // de paleta al tamano del slot si la descarga es indexada (frame_indexed.h)
+    unsigned int expected = 4 + (delta ? FRAME_DELTA_HEADER : animIndexBits ? animSlotSize : ANIM_FRAME_SIZE_64);
+    if (length < expected || (delta && animIndexBits)) {
+        animBufUnlock();
+        LOGF("[MQTT:anim] Invalid frame (size=%u, delta=%d, bits=%d)", (unsigned)length, (int)delta, animIndexBits);
+        return mqttRxSkip(mqttRxRemaining() - end);
+    }
+
+    uint8_t frameIndex = hdr[0];
+    uint8_t totalFrames = hdr[1];
 
     // Bytes 2-3 del header: animationId (u16). Backends antiguos mandan 0.
     // Con prefetch puede haber frames rezagados de la animacion anterior en
     // vuelo: descartarlos para no corromper el buffer de la nueva.
-    uint16_t hdrAnimId = ((uint16_t)payload[2] << 8) | payload[3];
+    uint16_t hdrAnimId = ((uint16_t)hdr[2] << 8) | hdr[3];
     if (hdrAnimId != 0 && currentAnimationId > 0 &&
         hdrAnimId != (uint16_t)(currentAnimationId & 0xFFFF)) {
         animBufUnlock();
         LOGF("[MQTT:anim] Frame de animacion %d descartado (descargando %d)", hdrAnimId, currentAnimationId);
-        return;
+        return mqttRxSkip(mqttRxRemaining() - end);
     }
 
-    if (frameIndex >= MAX_ANIM_FRAMES || frameIndex >= totalFrames) {
+    if (frameIndex >= totalFrames) {
         animBufUnlock();
         LOGF("[MQTT:anim] Frame index out of range: %d/%d", frameIndex, totalFrames);
-        return;
+        return mqttRxSkip(mqttRxRemaining() - end);
     }
 
     // Map backend frame index to its slot in animBuffer.
@@ -318,68 +486,215 @@ void handleAnimationFrameResponse(byte* payload, unsigned int length) {
     if (slot >= animFrameCount) {
         animBufUnlock();
         LOGF("[MQTT:anim] Slot %d out of range (frameCount=%d, step=%d)", slot, animFrameCount, animFrameStep);
-        return;
+        return mqttRxSkip(mqttRxRemaining() - end);
     }
 
     // Drop duplicates: bit already set means we already stored this slot
-    if (animFramesBitmap & (1ULL << slot)) {
+    if (bitsetTest(animFramesBitmap, slot)) {
         animBufUnlock();
         LOGF("[MQTT:anim] Duplicate frame %d (slot %d), ignoring", frameIndex, slot);
-        return;
+        return mqttRxSkip(mqttRxRemaining() - end);
     }
 
-    uint8_t* src = payload + 4; // 64x64 RGB565 from backend
-    uint8_t* dst = animBuffer + slot * animFrameSize;
+    if (delta && slot == 0) {
+        animBufUnlock();
+        LOGF("[MQTT:anim] Delta invalido para slot 0 (size=%u)", (unsigned)length);
+        return mqttRxSkip(mqttRxRemaining() - end);
+    }
+
+    // El cuerpo va del socket al area de entrada del buffer y frameStoreCommit
+    // lo pasa a la arena (comprimido en v2) con los bytes que de verdad usa
+    uint8_t* dst = frameStoreStage(animBuffer);
+    if (!dst) {
+        truncateAnimationDownload(slot);
+        animBufUnlock();
+        return mqttRxSkip(mqttRxRemaining() - end);
+    }
+    FrameSink sink = {animBuffer, frameStoreSerial(animBuffer)};
+    uint8_t width = animFrameWidth;
+    uint16_t used = animSlotSize;
+    bool indexed = animIndexBits != 0;
+    animBufUnlock();
 
-    if (animFrameWidth == 64) {
-        memcpy(dst, src, ANIM_FRAME_SIZE_64);
+    bool storedAsDelta = false;
+    bool ok;
+    if (indexed) {
+        ok = receiveFrameDirect(sink, dst, used);
+    } else if (delta) {
+        ok = receiveFrameDelta(sink, dst, length - 4, width, &storedAsDelta);
+    } else if (width == 64) {
+        ok = receiveFrameDirect(sink, dst, ANIM_FRAME_SIZE_64);
     } else {
-        // Downscale 64x64 → 32x32: pick top-left pixel of each 2x2 block
-        for (int y = 0; y < 32; y++) {
-            for (int x = 0; x < 32; x++) {
-                int srcIdx = (y * 2 * 64 + x * 2) * 2;
-                int dstIdx = (y * 32 + x) * 2;
-                dst[dstIdx] = src[srcIdx];
-                dst[dstIdx + 1] = src[srcIdx + 1];
-            }
-        }
+        // Downscale 64x64 → 32x32: media de cada bloque 2x2 con dither
+        ok = receiveFrameDownscaled(sink, dst);
+    }
+
+    animBufLock();
+    if (!ok || !frameSinkAlive(sink)) {
+        animBufUnlock();
+        LOGF("[MQTT:anim] Frame %d (slot %d) incompleto o de una descarga ya cancelada", frameIndex, slot);
+        return mqttRxSkip(mqttRxRemaining() - end);
     }
+    if (storedAsDelta) used = frameDeltaBytes(dst, width);
 
-    animFramesBitmap |= (1ULL << slot);
+    if (!frameStoreCommit(animBuffer, slot, used)) {
+        truncateAnimationDownload(slot);
+        animBufUnlock();
+        return mqttRxSkip(mqttRxRemaining() - end);
+    }
+    if (storedAsDelta) bitsetSet(animDeltaBitmap, slot);
+
+    if (animFramesReceived == 0) {
+        animRxBytes = 0;
+        animRxDeltas = 0;
+    }
+    animRxBytes += length;
+    if (delta) animRxDeltas++;
+
+    bitsetSet(animFramesBitmap, slot);
     animFramesReceived = animFramesReceived + 1;
     animDownloadStartTime = millis(); // hay progreso: el timeout mide estancamiento, no duracion total
     LOGF("[MQTT:anim] Frame %d->slot %d received (%d/%d stored)", frameIndex, slot, animFramesReceived, animFrameCount);
 
-    if (animFramesReceived >= animFrameCount) {
-        animReady = true; // el loop principal pinta la foto nueva y arranca la reproduccion
-        animReadyTime = millis(); // [Diag] para medir la latencia ready→swap
-        LOGF("[MQTT:anim] All frames received (playing=%d, loop=%lu/%lu)",
-             (int)animPlaying, animLoopCount, playMaxLoops);
+    markAnimationReadyIfComplete();
+    animBufUnlock();
+    return mqttRxSkip(mqttRxRemaining() - end);
+}
+
+void streamAnimationFrameResponse(uint32_t length) {
+    streamAnimationFrame(length, false);
+}
+
+void streamAnimationDeltaResponse(uint32_t length) {
+    streamAnimationFrame(length, true);
+}
+
+// Paquete de varios frames (respuesta a un rango):
+//   [animationId u16][n u8] y n veces [tipo u8: 0 frame, 1 delta][len u16][len bytes]
+// donde cada entrada es exactamente lo que llegaria por /response/animation/frame
+// o /response/animation/delta. El backend parte el rango en paquetes de como
+// mucho maxBytes. Cada entrada se guarda segun llega (el core 1 puede ver el
+// paquete a medias, como con frames sueltos)
+void streamAnimationFramesResponse(uint32_t length) {
+    uint8_t hdr[3];
+    if (length < 3 || !mqttRxRead(hdr, sizeof(hdr))) {
+        LOGF("[MQTT:anim] Paquete de frames invalido (size=%u)", (unsigned)length);
+        return;
+    }
+    // Paquete de una animacion anterior (rango pedido antes de cambiar): fuera
+    // entero, sin mirar las entradas
+    uint16_t hdrAnimId = ((uint16_t)hdr[0] << 8) | hdr[1];
+    if (hdrAnimId != (uint16_t)(currentAnimationId & 0xFFFF)) {
+        LOGF("[MQTT:anim] Paquete de frames descartado (id=%d, descargando %d)", hdrAnimId, currentAnimationId);
+        return; // mqtt_rx descarta el resto
+    }
+    uint8_t count = hdr[2];
+
+    uint8_t stored = 0;
+    for (; stored < count; stored++) {
+        uint8_t entry[3];
+        if (!mqttRxRead(entry, sizeof(entry))) break;
+        uint8_t kind = entry[0];
+        uint32_t len = ((uint32_t)entry[1] << 8) | entry[2];
+        if (kind > 1 || len > mqttRxRemaining()) break;
+        if (!streamAnimationFrame(len, kind == 1)) break;
+    }
+
+    if (stored < count || mqttRxRemaining()) {
+        LOGF("[MQTT:anim] Paquete de frames truncado: %d/%d entradas (size=%u)", stored, count, (unsigned)length);
+    }
+}
+
+void handleAnimationPaletteResponse(byte* payload, unsigned int length) {
+    animBufLock();
+    if (!animBuffer || !animIndexBits) {
+        animBufUnlock();
+        LOG("[MQTT:anim] Paleta descartada (sin descarga indexada)");
+        return;
     }
+
+    unsigned int colors = 1u << animIndexBits;
+    uint16_t hdrAnimId = length >= 2 ? ((uint16_t)payload[0] << 8) | payload[1] : 0;
+    if (length != 2 + colors * 2 || hdrAnimId != (uint16_t)(currentAnimationId & 0xFFFF)) {
+        animBufUnlock();
+        LOGF("[MQTT:anim] Paleta invalida (size=%d, id=%d, descargando %d)", length, hdrAnimId, currentAnimationId);
+        return;
+    }
+
+    uint16_t* palette = frameStorePalette(animBuffer);
+    for (unsigned int i = 0; i < colors; i++) {
+        palette[i] = ((uint16_t)payload[2 + i * 2] << 8) | payload[3 + i * 2];
+    }
+    animPaletteReceived = true;
+    animDownloadStartTime = millis();
+    LOGF("[MQTT:anim] Paleta de %u colores recibida", colors);
+
+    markAnimationReadyIfComplete();
     animBufUnlock();
 }
 
+bool requestAnimationPalette(int animationId) {
+    char topic[64];
+    snprintf(topic, sizeof(topic), "frame/%d/request/animation/palette", frameId);
+    char payload[64];
+    snprintf(payload, sizeof(payload), "{\"animationId\":%d,\"bits\":%d}", animationId, animIndexBits);
+    return netPublish(topic, payload);
+}
+
 bool requestAnimationFrame(int animationId, int frameIndex) {
     char topic[64];
     snprintf(topic, sizeof(topic), "frame/%d/request/animation/frame", frameId);
-    char payload[64];
-    snprintf(payload, sizeof(payload), "{\"animationId\":%d,\"frame\":%d}", animationId, frameIndex);
+    // deltaFrom: el frame del slot anterior, sobre el que el backend puede
+    // mandar solo los tiles que cambian (frame_delta.h). El primero va completo.
+    char payload[80];
+    if (animIndexBits) {
+        // Indexada: el backend escala y cuantiza contra la paleta; sin deltas
+        snprintf(payload, sizeof(payload), "{\"animationId\":%d,\"frame\":%d,\"width\":%d,\"bits\":%d}",
+                 animationId, frameIndex, animFrameWidth, animIndexBits);
+    } else if (frameIndex >= animFrameStep) {
+        snprintf(payload, sizeof(payload), "{\"animationId\":%d,\"frame\":%d,\"deltaFrom\":%d}",
+                 animationId, frameIndex, frameIndex - animFrameStep);
+    } else {
+        snprintf(payload, sizeof(payload), "{\"animationId\":%d,\"frame\":%d}", animationId, frameIndex);
+    }
     bool ok = netPublish(topic, payload);
     if (ok) LOGF("[MQTT:anim] Requesting frame %d of animation %d", frameIndex, animationId);
     return ok;
 }
 
+bool requestAnimationFrames(int animationId, int fromFrame, int toFrame) {
+    char topic[64];
+    snprintf(topic, sizeof(topic), "frame/%d/request/animation/frames", frameId);
+    // Mismas variantes que el frame suelto: indexado al ancho/bits del slot o,
+    // si no, deltas contra el frame anterior del rango (el 0 va completo)
+    int maxBytes = ANIM_FRAMES_MAX_PACK;
+    char payload[128];
+    if (animIndexBits) {
+        snprintf(payload, sizeof(payload),
+                 "{\"animationId\":%d,\"from\":%d,\"to\":%d,\"step\":%d,\"maxBytes\":%d,\"width\":%d,\"bits\":%d}",
+                 animationId, fromFrame, toFrame, animFrameStep, maxBytes, animFrameWidth, animIndexBits);
+    } else {
+        snprintf(payload, sizeof(payload),
+                 "{\"animationId\":%d,\"from\":%d,\"to\":%d,\"step\":%d,\"maxBytes\":%d,\"deltas\":true}",
+                 animationId, fromFrame, toFrame, animFrameStep, maxBytes);
+    }
+    bool ok = netPublish(topic, payload);
+    if (ok) LOGF("[MQTT:anim] Requesting frames %d-%d (step %d) of animation %d",
+                 fromFrame, toFrame, animFrameStep, animationId);
+    return ok;
+}
+
 void handleRegisterResponse(byte* payload, unsigned int length) {
     mqttRegisterFrameId = 0;
 
-    if (length > 0 && length < sizeof(httpBuffer)) {
-        memcpy(httpBuffer, payload, length);
-        httpBuffer[length] = '\0';
+    if (length > 0) {
+        // mqtt_rx lo entrega terminado en '\0'
+        LOGF("[MQTT:register] Respuesta recibida: %s", (const char*)payload);
 
-        LOGF("[MQTT:register] Respuesta recibida: %s", httpBuffer);
-
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, httpBuffer);
+        static JsonDocument filter = jsonFilter("{\"frameId\":true,\"pixieId\":true,\"deviceToken\":true}");
+        JsonDocument doc(jsonPool());
+        DeserializationError error = deserializeJson(doc, (const char*)payload, length,
+                                                     DeserializationOption::Filter(filter));
         if (!error) {
             mqttRegisterFrameId = doc["frameId"] | doc["pixieId"] | 0;
             LOGF("[MQTT:register] frameId=%d", mqttRegisterFrameId);
@@ -392,16 +707,11 @@ void handleRegisterResponse(byte* payload, unsigned int length) {
                 LOGF("[MQTT:register] Device token stored (%d chars)", mqttToken.length());
             }
 
-            mqttResponseSuccess = (mqttRegisterFrameId > 0);
         } else {
             LOG("[MQTT:register] Error parseando JSON");
-            mqttResponseSuccess = false;
         }
-    } else {
-        mqttResponseSuccess = false;
     }
-    mqttResponseReceived = true;
-    mqttResponseType = RESP_REGISTER;
+    mqttRequestComplete(RESP_REGISTER, mqttRegisterFrameId > 0);
 }
 
 void requestConfig()
@@ -410,14 +720,14 @@ void requestConfig()
 
     // Publicar request via MQTT
     String topic = String("frame/") + String(frameId) + "/request/config";
-    armMqttResponseWait();
-    if (!netPublish(topic.c_str(), "{}")) {
+    uint32_t req = mqttRequest(RESP_CONFIG, topic.c_str(), "{}", 10000);
+    if (!req) {
         LOG("[Config] Error publicando request MQTT");
         return;
     }
 
     // Esperar respuesta
-    if (waitForMqttResponse(RESP_CONFIG, 10000)) {
+    if (mqttRequestWait(req)) {
         LOG("[Config] Configuración aplicada correctamente");
     } else {
         LOG("[Config] Error recibiendo configuración via MQTT");
@@ -435,8 +745,7 @@ bool registerFrameViaMQTT()
 
     // Configurar MQTT
     mqttClient.setServer(MQTT_BROKER_URL, MQTT_BROKER_PORT);
-    mqttClient.setCallback(mqttCallback);
-    mqttClient.setKeepAlive(60);
+    mqttClient.setKeepAlive(MQTT_KEEPALIVE);
 
     // Conectar con client ID temporal usando register credentials
     LOGF("[MQTT:register] Conectando con client ID: %s", tempClientId.c_str());
@@ -446,9 +755,12 @@ bool registerFrameViaMQTT()
         return false;
     }
     LOG("[MQTT:register] Conectado a MQTT");
+    mqttRxReset();
 
     // Suscribirse al topic de respuesta
-    String responseTopic = "frame/mac/" + macAddress + "/response/register";
+    String responsePrefix = "frame/mac/" + macAddress + "/response/";
+    mqttTopicsSetPrefix(responsePrefix.c_str());
+    String responseTopic = responsePrefix + "register";
     LOGF("[MQTT:register] Suscribiendo a: %s", responseTopic.c_str());
     if (!mqttClient.subscribe(responseTopic.c_str())) {
         LOG("[MQTT:register] Error suscribiendo");
@@ -459,15 +771,16 @@ bool registerFrameViaMQTT()
     // Publicar request de registro
     String requestTopic = "frame/mac/" + macAddress + "/request/register";
     LOGF("[MQTT:register] Publicando en: %s", requestTopic.c_str());
-    armMqttResponseWait();
-    if (!mqttClient.publish(requestTopic.c_str(), "{}")) {
+    // Antes de la tarea de red: mqttRequest publica directo
+    uint32_t req = mqttRequest(RESP_REGISTER, requestTopic.c_str(), "{}", 10000);
+    if (!req) {
         LOG("[MQTT:register] Error publicando request");
         mqttClient.disconnect();
         return false;
     }
 
     // Esperar respuesta
-    if (waitForMqttResponse(RESP_REGISTER, 10000)) {
+    if (mqttRequestWait(req)) {
         if (mqttRegisterFrameId > 0) {
             frameId = mqttRegisterFrameId;
             preferences.putInt("frameId", frameId);
@@ -3,15 +3,27 @@
 
 #include "globals.h"
 
-void armMqttResponseWait(); // llamar SIEMPRE antes del netPublish cuya respuesta se va a esperar
-bool waitForMqttResponse(uint8_t expectedType, unsigned long timeout = 10000); // MqttRespType
+// Los handle*/stream*Response de request/response completan su peticion
+// en mqtt_request.h
 void handleSongResponse(byte* payload, unsigned int length);
-void handleCoverResponse(byte* payload, unsigned int length);
-void handlePhotoResponse(byte* payload, unsigned int length);
 void handleOtaResponse(byte* payload, unsigned int length);
 void handleConfigResponse(byte* payload, unsigned int length);
-void handleAnimationFrameResponse(byte* payload, unsigned int length);
+// Respuestas binarias grandes: leen el cuerpo del socket (mqtt_rx.h)
+void streamCoverResponse(uint32_t length);
+void streamPhotoResponse(uint32_t length);
+void streamAnimationFrameResponse(uint32_t length);
+void streamAnimationDeltaResponse(uint32_t length); // frame_delta.h
+void handleAnimationPaletteResponse(byte* payload, unsigned int length); // frame_indexed.h
+bool requestAnimationPalette(int animationId); // false = cola de red llena, reintentar
 bool requestAnimationFrame(int animationId, int frameIndex); // false = cola de red llena, reintentar
+// Rango [fromFrame, toFrame] cada animFrameStep frames, en paquetes de varios
+// frames de como mucho ANIM_FRAMES_MAX_PACK bytes. Solo si el backend lo
+// ofrece ("frameRange":true en la foto). Al leerse en streaming el paquete no
+// tiene que caber en ningun buffer: el tope es un frame completo y poco mas,
+// para que un paquete perdido no cueste mas que un frame.
+#define ANIM_FRAMES_MAX_PACK 8576
+void streamAnimationFramesResponse(uint32_t length);
+bool requestAnimationFrames(int animationId, int fromFrame, int toFrame); // false = cola de red llena, reintentar
 void handleRegisterResponse(byte* payload, unsigned int length);
 void requestConfig();
 bool registerFrameViaMQTT();
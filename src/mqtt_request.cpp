@@ -0,0 +1,242 @@
+#include "mqtt_request.h"
+#include "mqtt_rx.h"
+#include "net_task.h"
+#include "render_task.h"
+#include "photos.h"
+#include "transition.h"
+
+struct PendingRequest {
+    uint32_t id; // 0 = libre
+    uint8_t type;
+    uint8_t state;
+    unsigned long sentAt;
+    unsigned long timeout;
+    TaskHandle_t waiter;
+    MqttRequestDone done;
+    uint32_t tag;
+};
+
+// La escriben el core 1 (alta, espera, recogida) y la tarea de red
+// (respuestas, timeouts): todo bajo el spinlock
+static PendingRequest pending[MQTT_MAX_PENDING];
+static portMUX_TYPE pendingMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t lastId = 0;
+
+// Bajo pendingMux
+static PendingRequest* findRequest(uint32_t id) {
+    if (!id) return nullptr;
+    for (int i = 0; i < MQTT_MAX_PENDING; i++) {
+        if (pending[i].id == id) return &pending[i];
+    }
+    return nullptr;
+}
+
+// Cuerpo JSON con el reqId: "{}" -> {"reqId":N}, "{...}" -> {...,"reqId":N}
+static void withRequestId(char* dst, size_t cap, const char* payload, uint32_t id) {
+    const char* close = strrchr(payload, '}');
+    if (!close) {
+        strlcpy(dst, payload, cap);
+        return;
+    }
+    bool empty = close > payload && close[-1] == '{';
+    snprintf(dst, cap, "%.*s%s\"reqId\":%u}", (int)(close - payload), payload, empty ? "" : ",", (unsigned)id);
+}
+
+uint32_t mqttRequest(uint8_t type, const char* topic, const char* payload, unsigned long timeout,
+                     MqttRequestDone done, uint32_t tag) {
+    uint32_t id = 0;
+    portENTER_CRITICAL(&pendingMux);
+    PendingRequest* r = nullptr;
+    for (int i = 0; i < MQTT_MAX_PENDING && !r; i++) {
+        if (!pending[i].id) r = &pending[i];
+    }
+    if (r) {
+        id = ++lastId;
+        if (!id) id = ++lastId;
+        r->id = id;
+        r->type = type;
+        r->state = REQ_PENDING;
+        r->sentAt = millis();
+        r->timeout = timeout;
+        r->waiter = nullptr;
+        r->done = done;
+        r->tag = tag;
+    }
+    portEXIT_CRITICAL(&pendingMux);
+    if (!id) {
+        LOGF("[MQTT:req] Tabla de peticiones llena, '%s' no se envia", respName(type));
+        return 0;
+    }
+
+    // Alta antes de publicar: la respuesta puede llegar antes de que el
+    // llamante empiece a esperar
+    char body[256];
+    withRequestId(body, sizeof(body), payload, id);
+    if (!netPublish(topic, body)) {
+        mqttRequestCancel(id);
+        return 0;
+    }
+    return id;
+}
+
+static uint8_t requestState(uint32_t id) {
+    portENTER_CRITICAL(&pendingMux);
+    PendingRequest* r = findRequest(id);
+    uint8_t state = r ? r->state : REQ_FAILED;
+    portEXIT_CRITICAL(&pendingMux);
+    return state;
+}
+
+static bool waitUnlocked(uint32_t id, uint8_t type) {
+    unsigned long start = millis();
+    while (requestState(id) == REQ_PENDING) {
+        esp_task_wdt_reset();
+        if (!netTaskRunning) {
+            // Sin tarea de red (flujo de setup): bombear aquí como siempre.
+            // [Diag] mqttRxLoop() puede bloquear hasta el socket timeout (2s)
+            // con paquetes fragmentados
+            unsigned long tMqtt = millis();
+            mqttRxLoop();
+            unsigned long dMqtt = millis() - tMqtt;
+            if (dMqtt > 300) {
+                LOGF("[Diag] mqttRxLoop() bloqueó %lums esperando '%s' (playing=%d)",
+                     dMqtt, respName(type), (int)animPlaying);
+            }
+        }
+        mqttRequestExpire();
+        // Con tarea de render pinta ella; si no, no congelar un video en curso
+        // durante la espera ni un cambio de foto a medias
+        if (!renderTaskRunning) {
+            updateAnimationPlayback();
+            updateTransition();
+        }
+        // Despierta en cuanto la tarea de red completa la peticion
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+    }
+
+    unsigned long waited = millis() - start;
+    if (waited > 1000 && requestState(id) == REQ_OK) {
+        LOGF("[Diag] Respuesta '%s' tardó %lums (playing=%d, dl id=%d %d/%d)",
+             respName(type), waited, (int)animPlaying,
+             currentAnimationId, animFramesReceived, animFrameCount);
+    }
+    return mqttRequestPoll(id) == REQ_OK;
+}
+
+bool mqttRequestWait(uint32_t id) {
+    uint8_t type = RESP_NONE;
+    portENTER_CRITICAL(&pendingMux);
+    PendingRequest* r = findRequest(id);
+    if (r) {
+        r->waiter = xTaskGetCurrentTaskHandle();
+        type = r->type;
+    }
+    portEXIT_CRITICAL(&pendingMux);
+    if (!r) return false;
+
+    // El panel queda para la tarea de render mientras se espera
+    bool held = renderLockRelease();
+    bool ok = waitUnlocked(id, type);
+    renderLockRestore(held);
+    return ok;
+}
+
+uint8_t mqttRequestPoll(uint32_t id) {
+    mqttRequestExpire();
+    portENTER_CRITICAL(&pendingMux);
+    PendingRequest* r = findRequest(id);
+    uint8_t state = r ? r->state : REQ_FAILED;
+    if (r && state != REQ_PENDING) r->id = 0;
+    portEXIT_CRITICAL(&pendingMux);
+    return state;
+}
+
+void mqttRequestCancel(uint32_t id) {
+    portENTER_CRITICAL(&pendingMux);
+    PendingRequest* r = findRequest(id);
+    if (r) r->id = 0;
+    portEXIT_CRITICAL(&pendingMux);
+}
+
+bool mqttRequestExpected(uint8_t type, uint32_t reqId) {
+    bool expected = false;
+    portENTER_CRITICAL(&pendingMux);
+    for (int i = 0; i < MQTT_MAX_PENDING; i++) {
+        const PendingRequest& r = pending[i];
+        if (r.id && r.type == type && r.state == REQ_PENDING && (!reqId || r.id == reqId)) expected = true;
+    }
+    portEXIT_CRITICAL(&pendingMux);
+    return expected;
+}
+
+uint32_t mqttRequestTag(uint32_t reqId) {
+    portENTER_CRITICAL(&pendingMux);
+    PendingRequest* r = findRequest(reqId);
+    uint32_t tag = r ? r->tag : 0;
+    portEXIT_CRITICAL(&pendingMux);
+    return tag;
+}
+
+// Marca r como terminada. Con callback la entrada se libera ya (nadie la
+// va a recoger). Bajo pendingMux; el aviso, fuera (finishNotify)
+struct FinishedRequest {
+    uint32_t id;
+    uint8_t type;
+    TaskHandle_t waiter;
+    MqttRequestDone done;
+};
+
+static FinishedRequest finishLocked(PendingRequest* r, uint8_t state) {
+    FinishedRequest f = {r->id, r->type, r->waiter, r->done};
+    r->state = state;
+    if (r->done) r->id = 0;
+    return f;
+}
+
+static void finishNotify(const FinishedRequest& f, bool ok) {
+    if (f.waiter) xTaskNotifyGive(f.waiter);
+    if (f.done) f.done(f.id, ok);
+}
+
+void mqttRequestComplete(uint8_t type, bool ok, uint32_t reqId) {
+    FinishedRequest f = {};
+    portENTER_CRITICAL(&pendingMux);
+    PendingRequest* match = nullptr;
+    for (int i = 0; i < MQTT_MAX_PENDING; i++) {
+        PendingRequest* r = &pending[i];
+        if (!r->id || r->type != type || r->state != REQ_PENDING) continue;
+        if (reqId) {
+            if (r->id == reqId) match = r;
+        } else if (!match || (int32_t)(r->id - match->id) < 0) {
+            match = r; // la mas antigua
+        }
+    }
+    if (match) f = finishLocked(match, ok ? REQ_OK : REQ_FAILED);
+    portEXIT_CRITICAL(&pendingMux);
+
+    if (!f.id) {
+        LOGF("[MQTT:req] Respuesta '%s' (reqId=%u) sin peticion pendiente, descartada",
+             respName(type), (unsigned)reqId);
+        return;
+    }
+    finishNotify(f, ok);
+}
+
+void mqttRequestExpire() {
+    FinishedRequest expired[MQTT_MAX_PENDING];
+    int n = 0;
+    unsigned long now = millis();
+    portENTER_CRITICAL(&pendingMux);
+    for (int i = 0; i < MQTT_MAX_PENDING; i++) {
+        PendingRequest* r = &pending[i];
+        if (r->id && r->state == REQ_PENDING && now - r->sentAt >= r->timeout) {
+            expired[n++] = finishLocked(r, REQ_TIMEOUT);
+        }
+    }
+    portEXIT_CRITICAL(&pendingMux);
+
+    for (int i = 0; i < n; i++) {
+        LOGF("[MQTT] Timeout esperando respuesta %s (reqId=%u)", respName(expired[i].type), (unsigned)expired[i].id);
+        finishNotify(expired[i], false);
+    }
+}
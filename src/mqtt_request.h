@@ -0,0 +1,51 @@
+#ifndef MQTT_REQUEST_H
+#define MQTT_REQUEST_H
+
+#include "globals.h"
+
+// Peticiones request/response sobre netPublish. Cada peticion lleva un id
+// ("reqId" en el cuerpo JSON) y queda en una tabla de pendientes hasta que
+// llega su respuesta, vence su timeout o se cancela. Los handlers de respuesta
+// (tarea de red) la completan: por reqId si la respuesta lo trae de vuelta
+// (las fotos) y si no, la mas antigua pendiente de ese tipo (el broker
+// entrega en orden los mensajes de cada topic). Una respuesta de un tipo no
+// pisa la espera de otro: puede haber foto, cancion y config en vuelo a la vez.
+//
+// Al completarse se despierta con una notificacion a la tarea que espera en
+// mqttRequestWait, o se llama al callback (en la tarea de red). Sin esperar ni
+// callback, el resultado se recoge con mqttRequestPoll. Los datos de la
+// respuesta siguen donde los dejaba su handler (photo565, songIdBuffer,
+// spotifyCoverBuffer, httpBuffer...).
+
+#define MQTT_MAX_PENDING 8
+
+enum MqttRequestState : uint8_t {
+    REQ_PENDING, REQ_OK, REQ_FAILED, REQ_TIMEOUT
+};
+
+typedef void (*MqttRequestDone)(uint32_t id, bool ok);
+
+// Publica y deja pendiente una peticion de tipo type (MqttRespType). Devuelve
+// su id, o 0 si la tabla o la cola de red estan llenas (reintentar). tag: dato
+// del llamante para el handler de la respuesta (mqttRequestTag)
+uint32_t mqttRequest(uint8_t type, const char* topic, const char* payload, unsigned long timeout,
+                     MqttRequestDone done = nullptr, uint32_t tag = 0);
+
+// Bloquea al llamante hasta que se complete (sin congelar el video ni el WDT,
+// y bombeando MQTT si aun no hay tarea de red). true si llego bien
+bool mqttRequestWait(uint32_t id);
+
+// Sin bloquear: REQ_PENDING mientras no se complete. El resultado se entrega
+// una vez (despues el id ya no existe y se ve como REQ_FAILED)
+uint8_t mqttRequestPoll(uint32_t id);
+void mqttRequestCancel(uint32_t id);
+
+// Para los handlers de respuesta (tarea de red). reqId 0: la respuesta no lo trae
+bool mqttRequestExpected(uint8_t type, uint32_t reqId);
+uint32_t mqttRequestTag(uint32_t reqId); // 0 si no esta pendiente
+void mqttRequestComplete(uint8_t type, bool ok, uint32_t reqId = 0);
+
+// Vence las pendientes pasadas de su timeout (tarea de red y esperas)
+void mqttRequestExpire();
+
+#endif
@@ -0,0 +1,34 @@
+#include "mqtt_topics.h"
+
+// Handlers de mqtt_handlers.h. Solo los prototipos, sin globals.h, para que el
+// env test-dispatch compile esta misma tabla con sus propios handlers
+void streamAnimationDeltaResponse(uint32_t length);
+void streamAnimationFrameResponse(uint32_t length);
+void streamAnimationFramesResponse(uint32_t length);
+void handleAnimationPaletteResponse(byte* payload, unsigned int length);
+void handleConfigResponse(byte* payload, unsigned int length);
+void streamCoverResponse(uint32_t length);
+void handleOtaResponse(byte* payload, unsigned int length);
+void streamPhotoResponse(uint32_t length);
+void handleRegisterResponse(byte* payload, unsigned int length);
+void handleSongResponse(byte* payload, unsigned int length);
+
+// Respuestas del patron request/response, ordenadas por sufijo.
+// Las binarias grandes se leen en streaming; las demas llegan a mqttCallback
+static const MqttRoute responseRoutes[] = {
+    {"animation/delta", streamAnimationDeltaResponse, nullptr},
+    {"animation/frame", streamAnimationFrameResponse, nullptr},
+    {"animation/frames", streamAnimationFramesResponse, nullptr},
+    {"animation/palette", nullptr, handleAnimationPaletteResponse},
+    {"config", nullptr, handleConfigResponse},
+    {"cover", streamCoverResponse, nullptr},
+    {"ota", nullptr, handleOtaResponse},
+    {"photo", streamPhotoResponse, nullptr},
+    {"register", nullptr, handleRegisterResponse},
+    {"song", nullptr, handleSongResponse},
+};
+
+const MqttRoute* mqttResponseRoutes(size_t* n) {
+    *n = sizeof(responseRoutes) / sizeof(responseRoutes[0]);
+    return responseRoutes;
+}
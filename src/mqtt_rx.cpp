@@ -0,0 +1,228 @@
+#include "mqtt_rx.h"
+#include "mqtt_client.h"
+#include "json_pool.h"
+
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+
+#define MQTT_RX_BURST 8 // paquetes por pasada: entre medias se drenan los publishes
+
+static uint32_t s_remaining = 0; // bytes del paquete en curso por leer
+static bool s_broken = false;    // socket cerrado a mitad de paquete
+static unsigned long s_lastPing = 0;
+static bool s_pingOutstanding = false;
+
+// Mensajes enteros para mqttCallback. Estatico y no en la pila: hasta 4KB
+// dentro de la tarea de red obligaban a darle ese margen de stack
+static uint8_t s_message[MQTT_RX_MESSAGE_MAX + 1];
+
+// [Diag] lo recibido desde el ultimo ping
+static uint32_t s_rxMessages = 0;
+static uint32_t s_rxStreamed = 0;
+static uint32_t s_rxMaxBytes = 0;
+
+static void rxAbort(const char* why) {
+    LOGF("[MQTT:rx] %s: cerrando la conexion", why);
+    s_broken = true;
+    s_remaining = 0;
+    mqttClientWiFi.stop();
+}
+
+static bool rxWaitData() {
+    unsigned long start = millis();
+    while (!mqttClientWiFi.available()) {
+        if (!mqttClientWiFi.connected()) {
+            rxAbort("Socket cerrado a mitad de paquete");
+            return false;
+        }
+        if (millis() - start >= MQTT_SOCKET_TIMEOUT * 1000UL) {
+            rxAbort("Timeout a mitad de paquete");
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+// Cabecera fija: todavia sin longitud de paquete
+static bool rxReadByte(uint8_t* b) {
+    if (s_broken || !rxWaitData()) return false;
+    if (mqttClientWiFi.read(b, 1) != 1) {
+        rxAbort("Error de lectura");
+        return false;
+    }
+    return true;
+}
+
+static void rxWrite(const uint8_t* data, size_t len) {
+    if (mqttClientWiFi.write(data, len) != len) LOG("[MQTT:rx] Error de escritura");
+}
+
+uint32_t mqttRxRemaining() {
+    return s_remaining;
+}
+
+size_t mqttRxReadSome(uint8_t* dst, size_t max) {
+    if (s_broken) return 0;
+    size_t n = min((size_t)s_remaining, max);
+    int avail = mqttClientWiFi.available();
+    if (avail <= 0 || n == 0) return 0;
+    n = min(n, (size_t)avail);
+    int got = mqttClientWiFi.read(dst, n);
+    if (got <= 0) {
+        rxAbort("Error de lectura");
+        return 0;
+    }
+    s_remaining -= got;
+    return got;
+}
+
+bool mqttRxWait() {
+    return !s_broken && s_remaining > 0 && rxWaitData();
+}
+
+bool mqttRxRead(uint8_t* dst, size_t len) {
+    if (len > s_remaining) return false; // mas de lo que queda: mensaje mal formado
+    while (len) {
+        if (!mqttRxWait()) return false;
+        size_t got = mqttRxReadSome(dst, len);
+        dst += got;
+        len -= got;
+    }
+    return true;
+}
+
+bool mqttRxSkip(size_t len) {
+    uint8_t scratch[64];
+    if (len > s_remaining) len = s_remaining;
+    while (len) {
+        size_t n = min(len, sizeof(scratch));
+        if (!mqttRxRead(scratch, n)) return false;
+        len -= n;
+    }
+    return !s_broken;
+}
+
+static bool readPublish(uint8_t type) {
+    uint8_t qos = (type >> 1) & 3;
+    uint8_t hdr[2];
+    if (!mqttRxRead(hdr, 2)) return mqttRxSkip(s_remaining);
+    uint16_t topicLen = ((uint16_t)hdr[0] << 8) | hdr[1];
+    if (topicLen > MQTT_RX_TOPIC_MAX || topicLen > s_remaining) {
+        LOGF("[MQTT:rx] PUBLISH con topic de %u bytes descartado", topicLen);
+        return mqttRxSkip(s_remaining);
+    }
+    char topic[MQTT_RX_TOPIC_MAX + 1];
+    if (!mqttRxRead((uint8_t*)topic, topicLen)) return mqttRxSkip(s_remaining);
+    topic[topicLen] = '\0';
+    uint16_t packetId = 0;
+    if (qos) {
+        if (!mqttRxRead(hdr, 2)) return mqttRxSkip(s_remaining);
+        packetId = ((uint16_t)hdr[0] << 8) | hdr[1];
+    }
+
+    uint32_t length = s_remaining;
+    s_rxMessages++;
+    if (length > s_rxMaxBytes) s_rxMaxBytes = length;
+    MqttStreamHandler stream = mqttStreamHandler(topic);
+    if (stream) {
+        s_rxStreamed++;
+        stream(length);
+    } else if (length <= MQTT_RX_MESSAGE_MAX) {
+        // Terminado en '\0': mqttCallback lo parsea sin copiarlo
+        if (mqttRxRead(s_message, length)) {
+            s_message[length] = '\0';
+            mqttCallback(topic, s_message, length);
+        }
+    } else {
+        LOGF("[MQTT:rx] Mensaje de %u bytes en %s descartado (max %d)", (unsigned)length, topic,
+             MQTT_RX_MESSAGE_MAX);
+    }
+    if (!mqttRxSkip(s_remaining)) return false;
+
+    // Nos suscribimos con QoS 0; si el broker manda QoS 1, confirmarlo como
+    // hacia PubSubClient (QoS 2 tampoco lo soportaba)
+    if (qos == 1) {
+        uint8_t ack[4] = {MQTT_PUBACK, 2, (uint8_t)(packetId >> 8), (uint8_t)packetId};
+        rxWrite(ack, sizeof(ack));
+    }
+    return true;
+}
+
+static bool readPacket() {
+    s_broken = false;
+    s_remaining = 0;
+    uint8_t type;
+    if (!rxReadByte(&type)) return false;
+    // Longitud restante: hasta 4 bytes de 7 bits
+    uint32_t len = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b;
+        if (shift > 21) {
+            rxAbort("Longitud de paquete invalida");
+            return false;
+        }
+        if (!rxReadByte(&b)) return false;
+        len |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    s_remaining = len;
+
+    switch (type & 0xF0) {
+    case MQTT_PUBLISH:
+        return readPublish(type);
+    case MQTT_PINGRESP:
+        s_pingOutstanding = false;
+        break;
+    case MQTT_PINGREQ: {
+        uint8_t resp[2] = {MQTT_PINGRESP, 0};
+        rxWrite(resp, sizeof(resp));
+        break;
+    }
+    default:
+        break; // SUBACK/UNSUBACK y demas: nada que hacer
+    }
+    return mqttRxSkip(s_remaining);
+}
+
+void mqttRxReset() {
+    s_broken = false;
+    s_remaining = 0;
+    s_lastPing = millis();
+    s_pingOutstanding = false;
+}
+
+void mqttRxLoop() {
+    if (!mqttClient.connected()) return;
+
+    // Keepalive: un PINGREQ cada MQTT_KEEPALIVE aunque haya trafico (no vemos
+    // lo que publica PubSubClient, y el broker corta si el cliente calla 1,5x
+    // el keepalive). Sin respuesta al anterior, la conexion esta muerta
+    unsigned long now = millis();
+    if (now - s_lastPing >= MQTT_KEEPALIVE * 1000UL) {
+        if (s_pingOutstanding) {
+            rxAbort("Sin PINGRESP");
+            return;
+        }
+        uint8_t ping[2] = {MQTT_PINGREQ, 0};
+        rxWrite(ping, sizeof(ping));
+        s_pingOutstanding = true;
+        s_lastPing = now;
+        size_t jsonPeak;
+        uint32_t jsonHeap;
+        jsonPoolStats(&jsonPeak, &jsonHeap);
+        LOGF("[Diag] MQTT rx: %u mensajes (%u en streaming, max %u bytes), heap libre %u (minimo %u)",
+             (unsigned)s_rxMessages, (unsigned)s_rxStreamed, (unsigned)s_rxMaxBytes,
+             (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap());
+        LOGF("[Diag] MQTT rx: JSON pool pico %u/%u bytes, %u reservas al heap; stack libre minimo %u",
+             (unsigned)jsonPeak, (unsigned)JSON_POOL_SIZE, (unsigned)jsonHeap,
+             (unsigned)uxTaskGetStackHighWaterMark(nullptr));
+        s_rxMessages = s_rxStreamed = s_rxMaxBytes = 0;
+    }
+
+    for (int i = 0; i < MQTT_RX_BURST && mqttClientWiFi.available(); i++) {
+        if (!readPacket()) return;
+    }
+}
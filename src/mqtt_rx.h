@@ -0,0 +1,39 @@
+#ifndef MQTT_RX_H
+#define MQTT_RX_H
+
+#include "globals.h"
+#include "mqtt_topics.h"
+
+// Recepcion MQTT sin el buffer de PubSubClient. PubSubClient::loop() leia cada
+// PUBLISH entero en su buffer (que tenia que dar para un frame o una foto, 8.7KB
+// de DRAM fijos) y el handler lo copiaba despues a su sitio. Aqui se lee del
+// socket la cabecera y el topic, y el cuerpo lo va leyendo el handler del topic
+// directamente a su destino: la cover a spotifyCoverBuffer, la foto al
+// decodificador de photo565, los frames al area de entrada de animBuffer.
+// PubSubClient sigue conectando y publicando (su buffer queda para lo que sale).
+//
+// Los topics sin handler en streaming (comandos JSON, respuestas cortas) se
+// leen enteros en un buffer estatico, hasta MQTT_RX_MESSAGE_MAX, y van a
+// mqttCallback.
+//
+// Una vez conectado, mqttRxLoop() sustituye a mqttClient.loop(): mismo dueño
+// (la tarea de red, o el core 1 antes de arrancarla) y el mismo keepalive. Un
+// paquete que no se completa en MQTT_SOCKET_TIMEOUT deja el socket
+// desincronizado: se cierra y mqttReconnect vuelve a conectar.
+
+#ifndef MQTT_RX_MESSAGE_MAX
+#define MQTT_RX_MESSAGE_MAX 4096
+#endif
+#define MQTT_RX_TOPIC_MAX 128
+
+void mqttRxReset(); // tras cada connect
+void mqttRxLoop();
+
+// Cuerpo del PUBLISH en curso (solo desde un MqttStreamHandler)
+uint32_t mqttRxRemaining();
+size_t mqttRxReadSome(uint8_t* dst, size_t max); // lo que ya haya llegado, sin esperar
+bool mqttRxWait();                               // hasta que llegue algo; false si timeout o desconexion
+bool mqttRxRead(uint8_t* dst, size_t len);       // exactamente len bytes
+bool mqttRxSkip(size_t len);
+
+#endif
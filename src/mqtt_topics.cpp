@@ -0,0 +1,26 @@
+#include "mqtt_topics.h"
+
+static char s_prefix[MQTT_TOPIC_PREFIX_MAX];
+static size_t s_prefixLen = 0;
+
+void mqttTopicsSetPrefix(const char* prefix) {
+    strlcpy(s_prefix, prefix, sizeof(s_prefix));
+    s_prefixLen = strlen(s_prefix);
+}
+
+const char* mqttResponseSuffix(const char* topic) {
+    if (!s_prefixLen || strncmp(topic, s_prefix, s_prefixLen) != 0) return nullptr;
+    return topic + s_prefixLen;
+}
+
+const MqttRoute* mqttRouteFind(const MqttRoute* routes, size_t n, const char* suffix) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = strcmp(suffix, routes[mid].suffix);
+        if (c == 0) return &routes[mid];
+        if (c < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return nullptr;
+}
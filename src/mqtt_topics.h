@@ -0,0 +1,43 @@
+#ifndef MQTT_TOPICS_H
+#define MQTT_TOPICS_H
+
+#include <Arduino.h>
+
+// Despacho de los topics de respuesta sin tocar el heap. Antes cada mensaje
+// (cada frame de una animacion) se envolvia en un String y se comparaba con
+// indexOf("/response/") y una cadena de endsWith. Ahora el prefijo
+// "frame/<id>/response/" se fija una vez al suscribirse, y el resto del topic
+// se busca en una tabla de rutas ordenada por sufijo (busqueda binaria con
+// strcmp): un memcmp y unos 4 strcmp por mensaje. El env test-dispatch
+// comprueba el despacho con la tabla de produccion y mide lo que cuesta
+// frente al de antes.
+
+// Handler en streaming: lee (o no) los length bytes del cuerpo con las
+// funciones de mqtt_rx.h; lo que deje sin leer se descarta al volver
+typedef void (*MqttStreamHandler)(uint32_t length);
+// Mensaje entero, terminado en '\0'
+typedef void (*MqttMessageHandler)(byte* payload, unsigned int length);
+
+struct MqttRoute {
+    const char* suffix; // tras el prefijo de respuestas
+    MqttStreamHandler stream;   // respuestas binarias grandes
+    MqttMessageHandler message; // el resto (JSON corto)
+};
+
+#define MQTT_TOPIC_PREFIX_MAX 48
+
+// Al suscribirse a las respuestas (mqttReconnect, registro). El prefijo lo
+// leen despues la tarea de red o el setup, nunca a la vez que se fija
+void mqttTopicsSetPrefix(const char* prefix);
+
+// Lo que sigue al prefijo de respuestas, o nullptr si topic no es una respuesta
+const char* mqttResponseSuffix(const char* topic);
+
+// Tabla de respuestas de produccion (mqtt_routes.cpp), con sus n rutas
+const MqttRoute* mqttResponseRoutes(size_t* n);
+
+// Ruta de suffix en routes (n rutas ordenadas por strcmp de suffix); nullptr
+// si no hay
+const MqttRoute* mqttRouteFind(const MqttRoute* routes, size_t n, const char* suffix);
+
+#endif
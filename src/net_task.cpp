@@ -1,6 +1,8 @@
 #include "globals.h"
 #include "net_task.h"
 #include "mqtt_client.h"
+#include "mqtt_rx.h"
+#include "mqtt_request.h"
 
 // Mensaje de la cola de publishes salientes. Tamaños: el payload más grande
 // que pasa por aquí es un request JSON corto (photo/ota/config/anim frame);
@@ -31,7 +33,7 @@ bool netPublish(const char* topic, const char* payload) {
     strlcpy(msg.payload, payload, sizeof(msg.payload));
     // Timeout corto: si la cola está llena (tarea de red bloqueada drenando un
     // paquete gordo), devolvemos false en vez de congelar el core 1; el
-    // llamante reintenta intercalando updateAnimationPlayback()
+    // llamante reintenta en la siguiente pasada
     return xQueueSend(pubQueue, &msg, pdMS_TO_TICKS(50)) == pdTRUE;
 }
 
@@ -51,7 +53,9 @@ static void netTaskLoop(void*) {
 
         // Bombear MQTT: aquí es donde el socket puede bloquear hasta 2s con
         // paquetes fragmentados; en core 0 ya no congela la reproducción
-        mqttClient.loop();
+        mqttRxLoop();
+        // Timeouts de las peticiones que nadie espera (callback o sondeo)
+        mqttRequestExpire();
 
         // Refrescar NTP aquí: NTPClient::update() bloquea 1s por intento cuando
         // el servidor no responde y encadenaba iteraciones de ~1s en el core 1
@@ -72,7 +76,8 @@ void startNetTask() {
         return;
     }
     // Prio 1 (la misma que loop()); stack holgado porque el callback MQTT
-    // (fotos, config, dibujo) corre en su contexto
+    // (fotos, config, dibujo) corre en su contexto. No bajar sin haber leido
+    // en el dispositivo el minimo de stack libre que da el [Diag] de mqtt_rx
     BaseType_t ok = xTaskCreatePinnedToCore(netTaskLoop, "netTask", 10240, nullptr, 1, nullptr, 0);
     if (ok != pdPASS) {
         LOG("[Net] ERROR creando la tarea - seguimos en modo single-core");
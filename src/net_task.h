@@ -21,7 +21,7 @@ void startNetTask();
 bool netPublish(const char* topic, const char* payload);
 
 // Mutex recursivo que protege animBuffer y su estado de descarga: lo escriben
-// handleAnimationFrameResponse/handlePhotoResponse (tarea de red) y lo
+// streamAnimationFrameResponse/streamPhotoResponse (tarea de red) y lo
 // libera/transfiere el core 1 (swap, stop, timeout).
 void animBufLock();
 void animBufUnlock();
@@ -3,6 +3,7 @@
 #include "config.h"
 #include "display.h"
 #include "mqtt_handlers.h"
+#include "mqtt_request.h"
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
 #include <Update.h>
@@ -30,14 +31,14 @@ void checkForUpdates()
     // Publicar request via MQTT con hw_version
     String topic = String("frame/") + String(frameId) + "/request/ota";
     String payload = String("{\"hw_version\":\"") + HW_VERSION + "\",\"current_version\":" + String(currentVersion) + "}";
-    armMqttResponseWait();
-    if (!netPublish(topic.c_str(), payload.c_str())) {
+    uint32_t req = mqttRequest(RESP_OTA, topic.c_str(), payload.c_str(), 10000);
+    if (!req) {
         LOG("[OTA] Error publicando request MQTT");
         return;
     }
 
     // Esperar respuesta
-    if (!waitForMqttResponse(RESP_OTA, 10000)) {
+    if (!mqttRequestWait(req)) {
         LOG("[OTA] Error recibiendo respuesta de versión via MQTT");
         return;
     }
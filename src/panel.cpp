@@ -0,0 +1,114 @@
+#include "globals.h"
+
+#ifdef PANEL_DOUBLE_BUFFER
+
+// Lo que muestra la pantalla, en coordenadas logicas (tras la rotacion)
+static uint16_t shadow[PANEL_RES_Y][PANEL_RES_X];
+
+// [Diag] tiempo de composicion (beginFrame -> present) frente a flip +
+// resincronizacion, acumulado y volcado cada 5 s mientras haya frames
+static unsigned diagFrames = 0;
+static unsigned long diagComposeUs = 0, diagComposeMaxUs = 0;
+static unsigned long diagFlipUs = 0, diagFlipMaxUs = 0;
+static unsigned long diagLastReport = 0;
+
+void ShadowPanel::shadowFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    int x0 = max((int)x, 0), x1 = min(x + w, PANEL_RES_X);
+    int y0 = max((int)y, 0), y1 = min(y + h, PANEL_RES_Y);
+    for (int row = y0; row < y1; row++) {
+        for (int col = x0; col < x1; col++) shadow[row][col] = color;
+        if (x0 < x1) dirtyRows |= 1ULL << row;
+    }
+}
+
+void ShadowPanel::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (inBase) { MatrixPanel_I2S_DMA::drawPixel(x, y, color); return; }
+    shadowFill(x, y, 1, 1, color);
+    forward([&]() { MatrixPanel_I2S_DMA::drawPixel(x, y, color); });
+}
+
+void ShadowPanel::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (inBase) { MatrixPanel_I2S_DMA::fillRect(x, y, w, h, color); return; }
+    shadowFill(x, y, w, h, color);
+    forward([&]() { MatrixPanel_I2S_DMA::fillRect(x, y, w, h, color); });
+}
+
+void ShadowPanel::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    if (inBase) { MatrixPanel_I2S_DMA::drawFastHLine(x, y, w, color); return; }
+    shadowFill(x, y, w, 1, color);
+    forward([&]() { MatrixPanel_I2S_DMA::drawFastHLine(x, y, w, color); });
+}
+
+void ShadowPanel::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    if (inBase) { MatrixPanel_I2S_DMA::drawFastVLine(x, y, h, color); return; }
+    shadowFill(x, y, 1, h, color);
+    forward([&]() { MatrixPanel_I2S_DMA::drawFastVLine(x, y, h, color); });
+}
+
+void ShadowPanel::fillScreen(uint16_t color) {
+    if (inBase) { MatrixPanel_I2S_DMA::fillScreen(color); return; }
+    shadowFill(0, 0, PANEL_RES_X, PANEL_RES_Y, color);
+    forward([&]() { MatrixPanel_I2S_DMA::fillScreen(color); });
+}
+
+void ShadowPanel::beginFrame() {
+    if (timing) return;
+    timing = true;
+    frameStartUs = micros();
+}
+
+void ShadowPanel::present() {
+    unsigned long t0 = micros();
+    unsigned long composeUs = t0 - frameStartUs;
+    bool timed = timing;
+    timing = false;
+    if (dirtyRows == 0) return;
+
+    flipDMABuffer();
+
+    // El nuevo buffer trasero es el que se mostraba: le faltan las filas
+    // compuestas en este frame. Copiarlas desde el shadow por rachas de color.
+    inBase = true;
+    for (int y = 0; y < PANEL_RES_Y; y++) {
+        if (!(dirtyRows & (1ULL << y))) continue;
+        int x = 0;
+        while (x < PANEL_RES_X) {
+            uint16_t color = shadow[y][x];
+            int run = 1;
+            while (x + run < PANEL_RES_X && shadow[y][x + run] == color) run++;
+            MatrixPanel_I2S_DMA::drawFastHLine(x, y, run, color);
+            x += run;
+        }
+    }
+    inBase = false;
+    dirtyRows = 0;
+
+    // Los present() de fuera de un frame (overlays, pantallas de arranque)
+    // no cuentan: solo frames de video y pasos de transicion
+    if (!timed) return;
+    unsigned long flipUs = micros() - t0;
+    diagFrames++;
+    diagComposeUs += composeUs;
+    diagFlipUs += flipUs;
+    if (composeUs > diagComposeMaxUs) diagComposeMaxUs = composeUs;
+    if (flipUs > diagFlipMaxUs) diagFlipMaxUs = flipUs;
+    if (millis() - diagLastReport >= 5000) {
+        LOGF("[Diag] Panel: %u frames, componer %luus (max %lu), flip+resync %luus (max %lu)",
+             diagFrames, diagComposeUs / diagFrames, diagComposeMaxUs,
+             diagFlipUs / diagFrames, diagFlipMaxUs);
+        diagFrames = 0;
+        diagComposeUs = diagComposeMaxUs = 0;
+        diagFlipUs = diagFlipMaxUs = 0;
+        diagLastReport = millis();
+    }
+}
+
+void panelBeginFrame() {
+    dma_display->beginFrame();
+}
+
+void panelPresent() {
+    dma_display->present();
+}
+
+#endif
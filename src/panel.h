@@ -0,0 +1,71 @@
+#ifndef PANEL_H
+#define PANEL_H
+
+#include <ESP32-HUB75-MatrixPanel-I2S-DMA.h>
+
+// Salida con doble buffer (opt-in: -DPANEL_DOUBLE_BUFFER, solo v2, env
+// release-v2-db). Sin doble buffer cada pixel se escribe en el buffer DMA que
+// el refresco esta escaneando, y un frame de video a medio pintar se ve
+// partido (tearing). Con el flag todo se pinta en el buffer trasero y solo se
+// ve en panelPresent(), que hace un flip en el limite de frame. Una copia en
+// RAM de la pantalla (shadow) permite resincronizar tras el flip las filas
+// tocadas, asi que lo que no se repinta cada frame (overlays de la
+// overlayMask: titulo, reloj...) sigue en ambos buffers.
+//
+// Quien pinta presenta al acabar: renderUnlock()/renderLockRelease() (lo de
+// loop()), la tarea de render tras cada tick y las pantallas de arranque y
+// OTA de display.cpp. panelBeginFrame() solo marca el inicio de un frame para
+// el [Diag] de tiempos.
+
+#ifdef PANEL_DOUBLE_BUFFER
+
+#ifndef HW_V2
+#error "PANEL_DOUBLE_BUFFER solo esta soportado en v2 (el doble buffer DMA no cabe en v1)"
+#endif
+
+class ShadowPanel : public MatrixPanel_I2S_DMA {
+public:
+    ShadowPanel(const HUB75_I2S_CFG &cfg) : MatrixPanel_I2S_DMA(cfg) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    // clearScreen() de la libreria solo limpia el buffer trasero
+    void clearScreen() { fillScreen(0); }
+
+    void beginFrame();
+    void present();
+
+private:
+    // Aplica una operacion de la libreria al buffer trasero
+    template <typename Draw>
+    void forward(Draw draw) {
+        inBase = true;
+        draw();
+        inBase = false;
+    }
+    void shadowFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    bool timing = false;      // entre beginFrame() y present(), para el [Diag]
+    bool inBase = false;      // la libreria puede reentrar (p.ej. fillRect -> drawFastVLine)
+    uint64_t dirtyRows = 0;   // filas tocadas desde el ultimo present()
+    unsigned long frameStartUs = 0;
+};
+
+typedef ShadowPanel PanelDisplay;
+
+void panelBeginFrame();
+void panelPresent();
+
+#else
+
+typedef MatrixPanel_I2S_DMA PanelDisplay;
+
+inline void panelBeginFrame() {}
+inline void panelPresent() {}
+
+#endif
+
+#endif
@@ -0,0 +1,323 @@
+#include "photo_cache.h"
+#include "photo_prefetch.h"
+
+struct CachedPhoto {
+    uint16_t pixels[PANEL_RES_Y][PANEL_RES_X];
+    char title[64];
+    char author[64];
+};
+
+struct CacheSlot {
+    CachedPhoto* photo; // nullptr = libre
+    bool byId;
+    int key;
+    char etag[PHOTO_ETAG_MAX];
+    uint32_t lastUse;
+    bool fresh;           // precargada y aun sin mostrar
+    bool filling;         // core 0 decodificando un prefetch en ella
+    unsigned long freshAt;
+    uint8_t generation;   // la del request del prefetch que la llena
+};
+
+static CacheSlot slots[PHOTO_CACHE_ENTRIES];
+static uint32_t useCounter = 0;
+static uint8_t prefetchGeneration = 0; // photoCacheInvalidatePrefetch la avanza
+static portMUX_TYPE cacheMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Request en curso
+static bool selById = false;
+static int selKey = -1;
+static bool selHadEntry = false; // se envio etag
+static bool lastWasHit = false;
+static volatile bool restoreMissed = false; // core 0 lo pone antes de completar el request
+
+static PhotoCacheStats stats = {0, 0, 0, 0, 0};
+
+// Bajo cacheMux
+static int findSlot(bool byId, int key) {
+    for (int i = 0; i < PHOTO_CACHE_ENTRIES; i++) {
+        if (slots[i].photo && slots[i].byId == byId && slots[i].key == key) return i;
+    }
+    return -1;
+}
+
+// Entrada libre, o la usada hace mas tiempo de las que no estan frescas ni
+// llenandose. -1 si no queda ninguna. Bajo cacheMux
+static int victimSlot() {
+    int victim = -1;
+    for (int i = 0; i < PHOTO_CACHE_ENTRIES; i++) {
+        if (!slots[i].photo) return i;
+        if (slots[i].fresh || slots[i].filling) continue;
+        if (victim < 0 || slots[i].lastUse < slots[victim].lastUse) victim = i;
+    }
+    return victim;
+}
+
+static bool isFresh(const CacheSlot& slot) {
+    return slot.fresh && millis() - slot.freshAt < PHOTO_PREFETCH_MAX_AGE;
+}
+
+// Memoria de una entrada nueva (fuera de cacheMux: malloc)
+static CachedPhoto* allocPhoto() {
+    if (hasPsram) return (CachedPhoto*)ps_malloc(sizeof(CachedPhoto));
+    if (ESP.getFreeHeap() >= PHOTO_CACHE_MIN_HEAP + sizeof(CachedPhoto)) {
+        return (CachedPhoto*)malloc(sizeof(CachedPhoto));
+    }
+    return nullptr;
+}
+
+// Entrada para (byId, key): la suya, una libre (reservando memoria) o la
+// victima. Bajo cacheMux a la vuelta; -1 si no hay
+static int claimSlot(bool byId, int key) {
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(byId, key);
+    if (i >= 0 && slots[i].filling) return -1; // la esta escribiendo otro
+    if (i < 0) i = victimSlot();
+    if (i < 0 || slots[i].photo) return i;
+    portEXIT_CRITICAL(&cacheMux);
+
+    CachedPhoto* photo = allocPhoto();
+    if (!photo) {
+        portENTER_CRITICAL(&cacheMux);
+        return -1;
+    }
+    portENTER_CRITICAL(&cacheMux);
+    if (slots[i].photo) { // otra la ocupo mientras tanto: free fuera de cacheMux
+        portEXIT_CRITICAL(&cacheMux);
+        free(photo);
+        portENTER_CRITICAL(&cacheMux);
+        if (!slots[i].photo || slots[i].fresh || slots[i].filling) return -1;
+        return i;
+    }
+    slots[i].photo = photo;
+    slots[i].fresh = false;
+    slots[i].filling = false;
+    return i;
+}
+
+void photoCacheSelect(bool byId, int key) {
+    selById = byId;
+    selKey = key;
+    selHadEntry = false;
+    lastWasHit = false;
+    restoreMissed = false;
+}
+
+static String etagField(bool byId, int key, bool* found) {
+    char etag[PHOTO_ETAG_MAX] = "";
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(byId, key);
+    if (i >= 0) strcpy(etag, slots[i].etag);
+    portEXIT_CRITICAL(&cacheMux);
+    if (found) *found = etag[0] != '\0';
+    if (!etag[0]) return ""; // precargada sin etag: no hay con que revalidar
+    return String(",\"etag\":\"") + etag + "\"";
+}
+
+String photoCacheRequestField() {
+    return etagField(selById, selKey, &selHadEntry);
+}
+
+bool photoCacheRestore() {
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(selById, selKey);
+    bool ok = i >= 0 && !slots[i].filling;
+    if (ok) {
+        slots[i].lastUse = ++useCounter;
+        slots[i].filling = true; // que no la elijan de victima mientras se copia
+    }
+    portEXIT_CRITICAL(&cacheMux);
+    if (!ok) {
+        restoreMissed = true;
+        selHadEntry = false; // la que llegue al repetir no es una foto cambiada
+        return false;
+    }
+
+    memcpy(photo565, slots[i].photo->pixels, sizeof(photo565));
+    strcpy(photoTitle, slots[i].photo->title);
+    strcpy(photoAuthor, slots[i].photo->author);
+    portENTER_CRITICAL(&cacheMux);
+    slots[i].filling = false;
+    portEXIT_CRITICAL(&cacheMux);
+    lastWasHit = true;
+    return true;
+}
+
+bool photoCacheRestoreMissed() {
+    return restoreMissed;
+}
+
+void photoCacheStore(const char* etag) {
+    // El etag vuelve tal cual en el JSON del request: nada que haya que escapar
+    if (!etag || !*etag || strlen(etag) >= PHOTO_ETAG_MAX || strpbrk(etag, "\"\\")) return;
+
+    int i = claimSlot(selById, selKey);
+    if (i < 0) {
+        portEXIT_CRITICAL(&cacheMux);
+        return;
+    }
+    CacheSlot& slot = slots[i];
+    slot.byId = selById;
+    slot.key = selKey;
+    slot.fresh = false;
+    slot.filling = true;
+    portEXIT_CRITICAL(&cacheMux);
+
+    memcpy(slot.photo->pixels, photo565, sizeof(photo565));
+    strcpy(slot.photo->title, photoTitle);
+    strcpy(slot.photo->author, photoAuthor);
+
+    portENTER_CRITICAL(&cacheMux);
+    strcpy(slot.etag, etag);
+    slot.lastUse = ++useCounter;
+    slot.filling = false;
+    portEXIT_CRITICAL(&cacheMux);
+}
+
+void photoCacheDrop() {
+    CachedPhoto* photo = nullptr;
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(selById, selKey);
+    if (i >= 0 && !slots[i].filling) {
+        photo = slots[i].photo;
+        slots[i].photo = nullptr;
+        slots[i].fresh = false;
+    }
+    portEXIT_CRITICAL(&cacheMux);
+    free(photo);
+}
+
+int photoCachePrefetchDepth() {
+    int depth = min(PHOTO_PREFETCH_DEPTH, PHOTO_CACHE_ENTRIES - 1);
+    if (hasPsram) return ESP.getFreePsram() >= PHOTO_PREFETCH_MIN_PSRAM ? depth : 0;
+
+    // Sin PSRAM cada entrada son 8KB de heap que las animaciones necesitan mas
+    if (animPlaying || currentAnimationId > 0) return 0;
+    int entries = 0;
+    portENTER_CRITICAL(&cacheMux);
+    for (int i = 0; i < PHOTO_CACHE_ENTRIES; i++) {
+        if (slots[i].photo) entries++;
+    }
+    portEXIT_CRITICAL(&cacheMux);
+    uint32_t heap = ESP.getFreeHeap();
+    if (heap > PHOTO_CACHE_MIN_HEAP) entries += (heap - PHOTO_CACHE_MIN_HEAP) / sizeof(CachedPhoto);
+    return max(0, min(depth, entries - 1));
+}
+
+String photoCacheEtagField(int index) {
+    return etagField(false, index, nullptr);
+}
+
+bool photoCacheIsFresh(int index) {
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(false, index);
+    bool fresh = i >= 0 && isFresh(slots[i]);
+    portEXIT_CRITICAL(&cacheMux);
+    return fresh;
+}
+
+uint8_t photoCachePrefetchGeneration() {
+    return prefetchGeneration;
+}
+
+uint16_t* photoCacheBeginPrefetch(int index, uint8_t generation, const char* title, const char* author) {
+    int i = claimSlot(false, index);
+    if (i < 0) {
+        portEXIT_CRITICAL(&cacheMux);
+        return nullptr;
+    }
+    CacheSlot& slot = slots[i];
+    slot.byId = false;
+    slot.key = index;
+    slot.etag[0] = '\0';
+    slot.fresh = false;
+    slot.filling = true;
+    slot.generation = generation;
+    portEXIT_CRITICAL(&cacheMux);
+
+    strlcpy(slot.photo->title, title, sizeof(slot.photo->title));
+    strlcpy(slot.photo->author, author, sizeof(slot.photo->author));
+    return &slot.photo->pixels[0][0];
+}
+
+void photoCacheEndPrefetch(int index, bool ok, const char* etag) {
+    if (etag && (strlen(etag) >= PHOTO_ETAG_MAX || strpbrk(etag, "\"\\"))) etag = nullptr;
+    CachedPhoto* photo = nullptr;
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(false, index);
+    if (i >= 0 && slots[i].filling) {
+        CacheSlot& slot = slots[i];
+        slot.filling = false;
+        // Invalidada mientras llegaba: la foto puede no ser la de ese indice
+        if (ok && slot.generation == prefetchGeneration) {
+            strcpy(slot.etag, etag ? etag : "");
+            slot.fresh = true;
+            slot.freshAt = millis();
+            slot.lastUse = ++useCounter;
+        } else {
+            photo = slot.photo;
+            slot.photo = nullptr;
+        }
+    }
+    portEXIT_CRITICAL(&cacheMux);
+    free(photo);
+}
+
+bool photoCacheRevalidate(int index, uint8_t generation) {
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(false, index);
+    // Invalidada mientras llegaba: el indice puede ser ya otra foto
+    bool ok = i >= 0 && !slots[i].filling && generation == prefetchGeneration;
+    if (ok) {
+        slots[i].fresh = true;
+        slots[i].freshAt = millis();
+        slots[i].lastUse = ++useCounter;
+    }
+    portEXIT_CRITICAL(&cacheMux);
+    return ok;
+}
+
+bool photoCacheTakeFresh(int index) {
+    portENTER_CRITICAL(&cacheMux);
+    int i = findSlot(false, index);
+    bool ok = i >= 0 && isFresh(slots[i]) && !slots[i].filling;
+    if (ok) slots[i].filling = true; // sigue fresca: nadie la pisa mientras se copia
+    portEXIT_CRITICAL(&cacheMux);
+    if (!ok) return false;
+
+    memcpy(photo565, slots[i].photo->pixels, sizeof(photo565));
+    strcpy(photoTitle, slots[i].photo->title);
+    strcpy(photoAuthor, slots[i].photo->author);
+
+    portENTER_CRITICAL(&cacheMux);
+    slots[i].filling = false;
+    slots[i].fresh = false;
+    slots[i].lastUse = ++useCounter;
+    portEXIT_CRITICAL(&cacheMux);
+    return true;
+}
+
+void photoCacheInvalidatePrefetch() {
+    portENTER_CRITICAL(&cacheMux);
+    prefetchGeneration++;
+    for (int i = 0; i < PHOTO_CACHE_ENTRIES; i++) slots[i].fresh = false;
+    portEXIT_CRITICAL(&cacheMux);
+}
+
+void photoCacheRecordLatency(unsigned long ms) {
+    if (lastWasHit) {
+        stats.hits++;
+        stats.hitMs += ms;
+    } else {
+        stats.misses++;
+        stats.missMs += ms;
+        if (selHadEntry) stats.changed++;
+    }
+    LOGF("[Diag] Cache de fotos: %u/%u aciertos (%u cambiadas), media %lums acierto / %lums red",
+         (unsigned)stats.hits, (unsigned)(stats.hits + stats.misses), (unsigned)stats.changed,
+         stats.hits ? stats.hitMs / stats.hits : 0, stats.misses ? stats.missMs / stats.misses : 0);
+}
+
+PhotoCacheStats photoCacheStats() {
+    return stats;
+}
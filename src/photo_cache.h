@@ -0,0 +1,101 @@
+#ifndef PHOTO_CACHE_H
+#define PHOTO_CACHE_H
+
+#include "globals.h"
+
+// Cache LRU de fotos estaticas ya decodificadas (photo565 + titulo/autor),
+// por selector del request (indice o id) y etag del backend. La rotacion pasa
+// por las mismas fotos todo el dia: si la foto esta en cache el request lleva
+// su etag y el backend puede contestar sin binario:
+//   request/photo    {...,"index":N,"etag":"abc"}
+//   /response/photo  {"reqId":N,"notModified":true}\n
+// y la foto sale de aqui. Si cambio, llega completa (con su etag nuevo) y se
+// reemplaza. En PSRAM en v2; en v1 unas pocas entradas en DRAM, solo si
+// sobra heap (las animaciones lo necesitan mas).
+//
+// Core 1 elige el selector antes de publicar; core 0 (streamPhotoResponse)
+// guarda/restaura al llegar la respuesta. Un request normal cada vez
+// (isLoadingPhoto); los de prefetch llevan su indice y no usan el selector.
+//
+// Las entradas sirven tambien de buffer al prefetch (photo_prefetch.h): la
+// foto precargada se decodifica en su entrada y queda "fresca" hasta que se
+// muestra sin ir a la red (photoCacheTakeFresh). Una entrada fresca no se
+// elige como victima. Los datos de las entradas los protege un spinlock; los
+// pixeles se copian fuera de el (una entrada fresca no la escribe nadie).
+
+#ifndef PHOTO_CACHE_ENTRIES
+#ifdef BOARD_HAS_PSRAM
+#define PHOTO_CACHE_ENTRIES 8
+#else
+#define PHOTO_CACHE_ENTRIES 2
+#endif
+#endif
+
+#define PHOTO_ETAG_MAX 32
+#define PHOTO_CACHE_MIN_HEAP (64 * 1024) // sin PSRAM: no cachear por debajo
+
+struct PhotoCacheStats {
+    uint32_t hits;          // "notModified": la foto salio de la cache
+    uint32_t misses;        // foto completa por la red
+    uint32_t changed;       // de esas, con etag enviado (la foto habia cambiado)
+    unsigned long hitMs;    // latencia acumulada (request -> foto lista)
+    unsigned long missMs;
+};
+
+// Foto que se va a pedir (antes de construir el request)
+void photoCacheSelect(bool byId, int key);
+
+// ",\"etag\":\"...\"" si la foto seleccionada esta en cache; "" si no
+String photoCacheRequestField();
+
+// Respuesta "notModified": copia la foto seleccionada a photo565/photoTitle/
+// photoAuthor. false si ya no esta (el request debe repetirse sin etag)
+bool photoCacheRestore();
+// El ultimo request del selector fallo por eso: photoCacheRestore no la encontro
+bool photoCacheRestoreMissed();
+
+// Foto estatica completa recibida para el selector: guarda photo565/titulo/autor
+void photoCacheStore(const char* etag);
+
+// El selector ya no es una foto estatica (ahora es una animacion)
+void photoCacheDrop();
+
+// ---- Prefetch (photo_prefetch.h) ----
+
+// Fotos que se pueden precargar sin quitarle memoria a lo demas: con PSRAM
+// hasta PHOTO_PREFETCH_DEPTH; sin ella segun el heap que sobre y nunca con
+// una animacion en memoria. Siempre deja una entrada para la foto en pantalla
+int photoCachePrefetchDepth();
+
+// Campo etag del request de prefetch del indice ("" si no esta en cache)
+String photoCacheEtagField(int index);
+
+// El indice esta fresco: precargado hace menos de PHOTO_PREFETCH_MAX_AGE
+bool photoCacheIsFresh(int index);
+
+// Core 1: generacion de los prefetch, para el request (photo_prefetch.h). La
+// respuesta la devuelve y si entretanto hubo photoCacheInvalidatePrefetch no
+// deja nada fresco
+uint8_t photoCachePrefetchGeneration();
+
+// Core 0: cabecera de una foto precargada. Devuelve los pixeles donde
+// decodificarla (su entrada, reservada si hace falta) o nullptr sin memoria
+uint16_t* photoCacheBeginPrefetch(int index, uint8_t generation, const char* title, const char* author);
+// Core 0: fin del binario. ok: la entrada queda fresca con su etag; si no, se libera
+void photoCacheEndPrefetch(int index, bool ok, const char* etag);
+// Core 0: "notModified" de un prefetch: la entrada vuelve a estar fresca.
+// false si ya no esta o el request es de antes de una invalidacion
+bool photoCacheRevalidate(int index, uint8_t generation);
+
+// Core 1: si el indice esta fresco, lo copia a photo565/photoTitle/photoAuthor
+bool photoCacheTakeFresh(int index);
+
+// Los indices de la rotacion ya no son los que se precargaron (foto nueva,
+// cambio de pictures_on_queue): nada queda fresco, tampoco lo que este en vuelo
+void photoCacheInvalidatePrefetch();
+
+// [Diag] tras mostrar la foto: latencia del request y si fue acierto
+void photoCacheRecordLatency(unsigned long ms);
+PhotoCacheStats photoCacheStats();
+
+#endif
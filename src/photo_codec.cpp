@@ -0,0 +1,209 @@
+#include "photo_codec.h"
+#include "color_pipeline.h"
+
+#define PHOTO_PIXELS (PANEL_RES_X * PANEL_RES_Y)
+#define QOI_HEADER_SIZE 14
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+#define QOI_MASK_2   0xC0
+
+struct QoiPixel {
+    uint8_t r, g, b, a;
+};
+
+// Estado del decodificador: todo estatico, sin heap
+static PhotoEncoding decEnc = PHOTO_ENC_UNKNOWN;
+static bool decError = false;
+static uint16_t* decDst = nullptr; // 64x64 pixeles: photo565 o un hueco de prefetch
+static int decPos = 0;            // pixeles escritos en decDst
+static uint8_t decPend[5];        // bytes de un pixel/op partido entre trozos
+static uint8_t decPendLen = 0;
+static uint8_t decNeed = 0;       // bytes que faltan para completar decPend
+
+static QoiPixel qoiPx;
+static QoiPixel qoiIndex[64];
+static uint8_t qoiHeader[QOI_HEADER_SIZE];
+static uint8_t qoiHeaderLen = 0;
+
+static inline void putPixel(uint16_t c) {
+    decDst[decPos++] = c;
+}
+
+// Los formatos 888 pasan por gamma + dither (color_pipeline.h) en su posicion
+static inline void putPixel888(uint8_t r, uint8_t g, uint8_t b) {
+    putPixel(photoPixelTo565(r, g, b, decPos % PANEL_RES_X, decPos / PANEL_RES_X));
+}
+
+PhotoEncoding photoEncodingFromName(const char* name) {
+    if (!name || !name[0] || strcmp(name, "raw888") == 0) return PHOTO_ENC_RAW888;
+    if (strcmp(name, "rgb565") == 0) return PHOTO_ENC_RGB565;
+    if (strcmp(name, "qoi") == 0) return PHOTO_ENC_QOI;
+    return PHOTO_ENC_UNKNOWN;
+}
+
+const char* photoEncodingName(PhotoEncoding enc) {
+    switch (enc) {
+        case PHOTO_ENC_RAW888: return "raw888";
+        case PHOTO_ENC_RGB565: return "rgb565";
+        case PHOTO_ENC_QOI: return "qoi";
+        default: return "?";
+    }
+}
+
+void photoDecodeBegin(PhotoEncoding enc, uint16_t* dst) {
+    decEnc = enc;
+    decDst = dst;
+    decError = enc == PHOTO_ENC_UNKNOWN;
+    decPos = 0;
+    decPendLen = 0;
+    decNeed = 0;
+    qoiPx = {0, 0, 0, 255};
+    memset(qoiIndex, 0, sizeof(qoiIndex));
+    qoiHeaderLen = 0;
+}
+
+// ---- QOI ----
+
+static bool qoiCheckHeader() {
+    const uint8_t* h = qoiHeader;
+    uint32_t w = ((uint32_t)h[4] << 24) | ((uint32_t)h[5] << 16) | (h[6] << 8) | h[7];
+    uint32_t hgt = ((uint32_t)h[8] << 24) | ((uint32_t)h[9] << 16) | (h[10] << 8) | h[11];
+    if (memcmp(h, "qoif", 4) != 0 || w != PANEL_RES_X || hgt != PANEL_RES_Y) {
+        LOGF("[Photo] Cabecera QOI invalida (%ux%u)", (unsigned)w, (unsigned)hgt);
+        return false;
+    }
+    return true;
+}
+
+static void qoiEmit(int count) {
+    while (count-- > 0 && decPos < PHOTO_PIXELS) putPixel888(qoiPx.r, qoiPx.g, qoiPx.b);
+}
+
+static inline void qoiRemember() {
+    qoiIndex[(qoiPx.r * 3 + qoiPx.g * 5 + qoiPx.b * 7 + qoiPx.a * 11) & 63] = qoiPx;
+}
+
+// Bytes totales de la op que empieza por b1
+static uint8_t qoiOpSize(uint8_t b1) {
+    if (b1 == QOI_OP_RGB) return 4;
+    if (b1 == QOI_OP_RGBA) return 5;
+    if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) return 2;
+    return 1;
+}
+
+static void qoiApply(const uint8_t* op) {
+    uint8_t b1 = op[0];
+    int count = 1;
+    if (b1 == QOI_OP_RGB) {
+        qoiPx.r = op[1];
+        qoiPx.g = op[2];
+        qoiPx.b = op[3];
+    } else if (b1 == QOI_OP_RGBA) {
+        qoiPx.r = op[1];
+        qoiPx.g = op[2];
+        qoiPx.b = op[3];
+        qoiPx.a = op[4];
+    } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+        qoiPx = qoiIndex[b1];
+    } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+        qoiPx.r += ((b1 >> 4) & 0x03) - 2;
+        qoiPx.g += ((b1 >> 2) & 0x03) - 2;
+        qoiPx.b += (b1 & 0x03) - 2;
+    } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+        int vg = (b1 & 0x3F) - 32;
+        qoiPx.r += vg - 8 + ((op[1] >> 4) & 0x0F);
+        qoiPx.g += vg;
+        qoiPx.b += vg - 8 + (op[1] & 0x0F);
+    } else { // QOI_OP_RUN: el pixel anterior, 1..62 veces
+        count = (b1 & 0x3F) + 1;
+    }
+    qoiRemember(); // tambien en RUN, como el decodificador de referencia
+    qoiEmit(count);
+}
+
+static void qoiFeed(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    while (i < len && qoiHeaderLen < QOI_HEADER_SIZE) {
+        qoiHeader[qoiHeaderLen++] = data[i++];
+        if (qoiHeaderLen == QOI_HEADER_SIZE && !qoiCheckHeader()) {
+            decError = true;
+            return;
+        }
+    }
+
+    // Completar una op partida en el trozo anterior
+    while (decNeed > 0 && i < len) {
+        decPend[decPendLen++] = data[i++];
+        if (--decNeed == 0) qoiApply(decPend);
+    }
+
+    // El marcador de fin (7x 0x00 + 0x01) se ignora: paramos al llenar la foto
+    while (i < len && decPos < PHOTO_PIXELS) {
+        uint8_t size = qoiOpSize(data[i]);
+        if (i + size > len) {
+            decPendLen = 0;
+            while (i < len) decPend[decPendLen++] = data[i++];
+            decNeed = size - decPendLen;
+            return;
+        }
+        qoiApply(data + i);
+        i += size;
+    }
+}
+
+// ---- Formatos crudos ----
+
+static void rawFeed(const uint8_t* data, size_t len, uint8_t bpp) {
+    size_t i = 0;
+    while (i < len && decPos < PHOTO_PIXELS) {
+        // Camino rapido: pixeles enteros hasta el final de la fila, de golpe
+        // con los kernels (el caso normal: la foto llega en un solo trozo)
+        if (decPendLen == 0 && len - i >= bpp) {
+            int x = decPos % PANEL_RES_X;
+            int n = min((size_t)(PANEL_RES_X - x), (len - i) / bpp);
+            uint16_t* dst = decDst + decPos;
+            if (bpp == 3) {
+                pkGbr888ToRow565(dst, data + i, n, x, decPos / PANEL_RES_X, colorGammaLut);
+            } else {
+                pkBe565ToNative(dst, data + i, n);
+            }
+            decPos += n;
+            i += n * bpp;
+            continue;
+        }
+        decPend[decPendLen++] = data[i++];
+        if (decPendLen < bpp) continue;
+        decPendLen = 0;
+        if (bpp == 3) {
+            putPixel888(decPend[2], decPend[0], decPend[1]); // GBR
+        } else {
+            putPixel(((uint16_t)decPend[0] << 8) | decPend[1]);
+        }
+    }
+}
+
+bool photoDecodeFeed(const uint8_t* data, size_t len) {
+    if (decError) return false;
+    switch (decEnc) {
+        case PHOTO_ENC_RAW888: rawFeed(data, len, 3); break;
+        case PHOTO_ENC_RGB565: rawFeed(data, len, 2); break;
+        case PHOTO_ENC_QOI: qoiFeed(data, len); break;
+        default: decError = true; break;
+    }
+    return !decError;
+}
+
+bool photoDecodeEnd() {
+    bool ok = !decError && decPos == PHOTO_PIXELS;
+    if (!ok) {
+        LOGF("[Photo] Decodificacion %s incompleta (%d/%d pixeles%s)",
+             photoEncodingName(decEnc), decPos, PHOTO_PIXELS, decError ? ", error" : "");
+    }
+    decEnc = PHOTO_ENC_UNKNOWN;
+    return ok;
+}
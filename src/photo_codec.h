@@ -0,0 +1,37 @@
+#ifndef PHOTO_CODEC_H
+#define PHOTO_CODEC_H
+
+#include "globals.h"
+
+// Formatos de foto en el cable. El request/photo anuncia los que aceptamos
+// ("enc") y el tamano maximo del binario ("maxBytes"); el backend elige uno y
+// lo indica en el "enc" de la cabecera JSON de la respuesta (sin "enc" =
+// raw888, backends antiguos).
+//   raw888: 64x64x3, orden GBR (12288 bytes)
+//   rgb565: 64x64x2, big-endian como covers y frames (8192 bytes)
+//   qoi:    imagen QOI 64x64 (RGB o RGBA), sin perdidas y de tamano variable
+enum PhotoEncoding : uint8_t {
+    PHOTO_ENC_RAW888,
+    PHOTO_ENC_RGB565,
+    PHOTO_ENC_QOI,
+    PHOTO_ENC_UNKNOWN
+};
+
+// Binario maximo: el de raw888. Se decodifica segun llega del socket
+// (mqtt_rx.h), asi que ya no lo limita el buffer MQTT
+#define PHOTO_MAX_PAYLOAD (64 * 64 * 3)
+
+// Elementos del array "enc" del request, por orden de preferencia
+#define PHOTO_ACCEPT_ENCODINGS "\"qoi\",\"rgb565\",\"raw888\""
+
+PhotoEncoding photoEncodingFromName(const char* name);
+const char* photoEncodingName(PhotoEncoding enc);
+
+// Decodificador en streaming a photo565 (o a dst, los 64x64 pixeles de una
+// foto precargada): Begin, Feed con trozos de cualquier tamano, y End devuelve
+// true si se completaron los 64x64 pixeles sin errores
+void photoDecodeBegin(PhotoEncoding enc, uint16_t* dst = &photo565[0][0]);
+bool photoDecodeFeed(const uint8_t* data, size_t len);
+bool photoDecodeEnd();
+
+#endif
@@ -0,0 +1,105 @@
+#include "photo_prefetch.h"
+#include "photo_cache.h"
+#include "photos.h"
+#include "mqtt_request.h"
+#include "net_task.h"
+
+// Tag de los requests de prefetch (mqttRequestTag): la marca en el byte alto,
+// para distinguirlos de los que no llevan tag; la generacion de la cache
+// (photoCachePrefetchGeneration) en el siguiente y el indice + 1 en los bajos
+#define PREFETCH_TAG 0x50000000u
+#define PREFETCH_TAG_MASK 0xFF000000u
+#define PREFETCH_GEN_SHIFT 16
+
+// Solo core 1
+static uint32_t inflightReq = 0;
+static int inflightIndex = -1;
+static unsigned long lastFailure = 0;
+static PhotoPrefetchStats stats = {0, 0};
+
+// Hay algo que precargar: rotacion de mas de una foto, sin cover de Spotify
+// en pantalla y con memoria para al menos una entrada
+static bool prefetchEnabled() {
+    return maxPhotos >= 2 && songShowing == "" && photoCachePrefetchDepth() > 0;
+}
+
+static void requestPrefetch(int index) {
+    String topic = String("frame/") + String(frameId) + "/request/photo";
+    String payload = photoRequestPayload("\"index\":" + String(index), photoCacheEtagField(index));
+    uint32_t generation = photoCachePrefetchGeneration();
+    inflightReq = mqttRequest(RESP_PHOTO, topic.c_str(), payload.c_str(), 15000, nullptr,
+                              PREFETCH_TAG | generation << PREFETCH_GEN_SHIFT | (uint32_t)(index + 1));
+    if (!inflightReq) {
+        lastFailure = millis();
+        return;
+    }
+    inflightIndex = index;
+    LOGF("[Prefetch] Pidiendo foto index=%d", index);
+}
+
+void photoPrefetchUpdate() {
+    if (inflightReq) {
+        uint8_t state = mqttRequestPoll(inflightReq);
+        if (state == REQ_PENDING) return;
+        if (state != REQ_OK) {
+            LOGF("[Prefetch] Foto index=%d no precargada", inflightIndex);
+            lastFailure = millis();
+        }
+        inflightReq = 0;
+        inflightIndex = -1;
+    }
+
+    // Sin competir con un request normal ni con la descarga de un video
+    if (isLoadingPhoto || currentAnimationId > 0 || !prefetchEnabled()) return;
+    if (lastFailure && millis() - lastFailure < PHOTO_PREFETCH_RETRY_MS) return;
+
+    int depth = photoCachePrefetchDepth();
+    for (int k = 0; k < depth; k++) {
+        int index = (photoIndex + k) % maxPhotos; // photoIndex: la siguiente a mostrar
+        if (photoCacheIsFresh(index)) continue;
+        requestPrefetch(index);
+        return;
+    }
+}
+
+static void reportStats() {
+    PhotoCacheStats cache = photoCacheStats();
+    char payload[160];
+    snprintf(payload, sizeof(payload),
+             "{\"prefetchHits\":%u,\"prefetchMisses\":%u,\"prefetchDepth\":%d,\"cacheHits\":%u,\"cacheMisses\":%u}",
+             (unsigned)stats.hits, (unsigned)stats.misses, photoCachePrefetchDepth(),
+             (unsigned)cache.hits, (unsigned)cache.misses);
+    char topic[48];
+    snprintf(topic, sizeof(topic), "frame/%d/request/stats", frameId);
+    netPublish(topic, payload);
+}
+
+bool photoPrefetchTake(int index) {
+    bool hit = photoCacheTakeFresh(index);
+    // Un cambio sin prefetch posible (profundidad 0, cover, una sola foto) no
+    // es un fallo: no cuenta
+    if (!hit && !prefetchEnabled()) return false;
+    if (hit) stats.hits++;
+    else stats.misses++;
+    LOGF("[Diag] Prefetch de fotos: %s index=%d, %u/%u aciertos (profundidad %d)",
+         hit ? "acierto" : "fallo", index, (unsigned)stats.hits, (unsigned)(stats.hits + stats.misses),
+         photoCachePrefetchDepth());
+    if ((stats.hits + stats.misses) % PHOTO_PREFETCH_REPORT_EVERY == 0) reportStats();
+    return hit;
+}
+
+int photoPrefetchIndex(uint32_t reqId, uint8_t* generation) {
+    uint32_t tag = reqId ? mqttRequestTag(reqId) : 0;
+    if ((tag & PREFETCH_TAG_MASK) != PREFETCH_TAG) return -1;
+    *generation = (tag >> PREFETCH_GEN_SHIFT) & 0xFF;
+    return (int)(tag & 0xFFFF) - 1;
+}
+
+void photoPrefetchInvalidate() {
+    // Lo que este en vuelo llega con la generacion vieja y se descarta
+    photoCacheInvalidatePrefetch();
+}
+
+PhotoPrefetchStats photoPrefetchStats() {
+    return stats;
+}
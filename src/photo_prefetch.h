@@ -0,0 +1,50 @@
+#ifndef PHOTO_PREFETCH_H
+#define PHOTO_PREFETCH_H
+
+#include "globals.h"
+
+// Prefetch de las siguientes fotos de la rotacion. Sin el, cada cambio de foto
+// esperaba el request MQTT entero (ida, vuelta y decodificado) antes del
+// fundido. Ahora loop() (photoPrefetchUpdate) pide por adelantado las
+// siguientes photoCachePrefetchDepth() fotos por indice, una cada vez y sin
+// bloquear, y la respuesta se decodifica en una entrada de la cache de fotos
+// (photo_cache.h) en vez de en photo565. Al cumplirse el intervalo, showPhoto
+// la copia de alli (photoPrefetchTake) y el cambio no toca la red.
+//
+// Las animaciones no se precargan: la respuesta se descarta y esa foto sale
+// por el camino normal. La profundidad depende de la memoria libre (0 en v1
+// con un video en memoria). Aciertos y fallos van al log y, cada
+// PHOTO_PREFETCH_REPORT_EVERY cambios, a frame/{id}/request/stats
+// (fire-and-forget, como el boot report).
+
+#ifndef PHOTO_PREFETCH_DEPTH
+#define PHOTO_PREFETCH_DEPTH 2
+#endif
+#define PHOTO_PREFETCH_MAX_AGE (10 * 60 * 1000UL) // mas vieja: se vuelve a pedir (con etag)
+#define PHOTO_PREFETCH_MIN_PSRAM (256 * 1024)    // con menos PSRAM libre no se precarga
+#define PHOTO_PREFETCH_RETRY_MS 30000            // tras un fallo (timeout, animacion, sin memoria)
+#define PHOTO_PREFETCH_REPORT_EVERY 20
+
+struct PhotoPrefetchStats {
+    uint32_t hits;   // cambio servido desde una foto precargada
+    uint32_t misses; // cambio que tuvo que ir a la red
+};
+
+// Core 1, cada vuelta de loop(): recoge el prefetch en curso y pide el siguiente
+void photoPrefetchUpdate();
+
+// Core 1, cambio de foto de la rotacion: true si index estaba precargada (ya
+// en photo565/photoTitle/photoAuthor). Cuenta acierto o fallo, este solo si
+// habia prefetch posible
+bool photoPrefetchTake(int index);
+
+// Core 0 (streamPhotoResponse): indice precargado por reqId (y la generacion
+// de la cache con la que se pidio), o -1 si la respuesta no es de un prefetch
+int photoPrefetchIndex(uint32_t reqId, uint8_t* generation);
+
+// Los indices de la rotacion cambiaron (foto nueva, pictures_on_queue)
+void photoPrefetchInvalidate();
+
+PhotoPrefetchStats photoPrefetchStats();
+
+#endif
@@ -2,82 +2,98 @@
 #include "display.h"
 #include "clock.h"
 #include "mqtt_handlers.h"
+#include "mqtt_request.h"
 #include "net_task.h"
-#include <Fonts/Picopixel.h>
+#include "blit.h"
+#include "transition.h"
+#include "text_strip.h"
+#include "compositor.h"
+#include "photo_codec.h"
+#include "frame_delta.h"
+#include "frame_indexed.h"
+#include "frame_store.h"
+#include "anim_window.h"
+#include "anim_cache.h"
+#include "photo_cache.h"
+#include "photo_prefetch.h"
+#include "frame_slab.h"
+#include "render_task.h"
+
+// Titulo y autor de la foto actual, rasterizados en showPhotoInfo(), y sus
+// cajas en la capa de texto del compositor
+static TextStrip titleStrip;
+static TextStrip nameStrip;
+static LayerRect titleBox, nameBox;
+static int titleTextX, titleTextY, nameTextX, nameTextY; // esquina de los bounds
+
+// Cambio de foto con fundido, sin bloquear: fade out de lo que hay en
+// pantalla, photo565 -> screenBuffer y fade in, un paso por tick de loop().
+// Titulo, reloj y Dev se pintan al acabar; despues se llama a onShown.
+static void (*photoShownCallback)() = nullptr;
+
+static void photoFadeInDone()
+{
+    showPhotoInfo(String(photoTitle), String(photoAuthor));
+    showClockOverlay();
+    showDevOverlay();
 
-// Mark a rectangle in the overlay bitmask
-void markOverlayRegion(int x, int y, int w, int h) {
-    for (int row = max(0, y); row < min(64, y + h); row++) {
-        for (int col = max(0, x); col < min(64, x + w); col++) {
-            overlayMaskSet(col, row);
-        }
-    }
+    void (*cb)() = photoShownCallback;
+    photoShownCallback = nullptr;
+    if (cb) cb();
 }
 
-// Build overlay bitmask from current title/author/clock positions
-void buildOverlayMask() {
-    overlayMaskClear();
-    dma_display->setFont(&Picopixel);
-    dma_display->setTextSize(1);
-
-    // Title region
-    if (currentTitle.length() > 0) {
-        int16_t x1, y1;
-        uint16_t w, h;
-        dma_display->getTextBounds(currentTitle, 1, titleY, &x1, &y1, &w, &h);
-        // Mark the full width for scrolling titles, or just the text width
-        int rectW = titleNeedsScroll ? PANEL_RES_X : w + 3;
-        markOverlayRegion(0, y1 - 1, rectW, h + 2);
-    }
+static void photoFadeOutDone()
+{
+    dma_display->clearScreen();
 
-    // Author name region: usar la posicion real donde showPhotoInfo lo pinto
-    // (derecha en layout de una linea, izquierda en el de dos lineas)
-    if (currentName.length() > 0) {
-        int16_t x1, y1;
-        uint16_t w, h;
-        dma_display->getTextBounds(currentName, nameX, nameY, &x1, &y1, &w, &h);
-        markOverlayRegion(nameX - 1, y1 - 1, w + 2, h + 2);
-    }
+    // La foto llega ya convertida a RGB565
+    memcpy(screenBuffer, photo565, sizeof(screenBuffer));
 
-    // Clock region (top-right corner)
-    if (clockEnabled) {
-        // Clock uses ~30x8 pixels in top-right
-        markOverlayRegion(PANEL_RES_X - 30, 0, 30, 8);
-    }
-
-    #ifdef DEV_MODE
-    // Dev overlay (top-left)
-    markOverlayRegion(0, 0, 18, 8);
-    #endif
+    transitionStartFade(true, photoFadeInDone);
 }
 
-void displayPhotoWithFade()
+void displayPhotoWithFade(void (*onShown)())
 {
-    // Solo hacer fadeOut DESPUÉS de confirmar que la imagen está completa
-    fadeOut();
-    dma_display->clearScreen();
-
-    // Resetear el estado del scroll del título anterior
+    // Resetear el estado del scroll del título anterior: no debe repintarse
+    // encima del fundido
     titleNeedsScroll = false;
+    photoShownCallback = onShown;
+    transitionStartFade(false, photoFadeOutDone);
+}
 
-    // Copiar al screenBuffer desde el buffer estático
-    for (int y = 0; y < 64; y++)
-    {
-        for (int x = 0; x < 64; x++)
-        {
-            int idx = (y * 64 + x) * 3;
-            uint8_t g = photoBuffer[idx];
-            uint8_t b = photoBuffer[idx + 1];
-            uint8_t r = photoBuffer[idx + 2];
-            screenBuffer[y][x] = dma_display->color565(r, g, b);
+// Cuerpo de request/photo: el selector de foto mas los formatos que sabemos
+// decodificar y el binario maximo que cabe en el buffer MQTT (y el etag si la
+// foto esta en cache: photoCacheRequestField tras photoCacheSelect)
+String photoRequestPayload(const String &selector, const String &etagField)
+{
+    // Sin PSRAM pedimos paleta para las animaciones: frames indexados (frame_indexed.h).
+    // animRange: sabemos pedir los frames por rangos (requestAnimationFrames)
+    return "{" + selector + etagField +
+           ",\"enc\":[" PHOTO_ACCEPT_ENCODINGS "],\"maxBytes\":" + String(PHOTO_MAX_PAYLOAD) +
+           ",\"animRange\":true" + (hasPsram ? "}" : ",\"animPalette\":true}");
+}
+
+// Pide la foto ya seleccionada (photoCacheSelect) y espera la respuesta. Si el
+// backend contesta notModified por una entrada que la cache ya desalojo, se
+// repite una vez sin etag. false si no llego (ya logueado con tag)
+static bool fetchSelectedPhoto(const String &selector, const char *tag)
+{
+    String topic = String("frame/") + String(frameId) + "/request/photo";
+    String payload = photoRequestPayload(selector, photoCacheRequestField());
+    for (int attempt = 0; attempt < 2; attempt++) {
+        // reqId (mqtt_request.h): la respuesta de una peticion anterior se descarta
+        uint32_t req = mqttRequest(RESP_PHOTO, topic.c_str(), payload.c_str(), 15000);
+        if (!req) {
+            LOGF("%s Error publicando request MQTT", tag);
+            return false;
         }
+        if (mqttRequestWait(req)) return true;
+        if (attempt > 0 || !photoCacheRestoreMissed()) break;
+        LOGF("%s La foto ya no esta en cache: se pide de nuevo sin etag", tag);
+        payload = photoRequestPayload(selector, "");
     }
-
-    fadeIn();
-
-    showPhotoInfo(String(photoTitle), String(photoAuthor));
-    showClockOverlay();
-    showDevOverlay();
+    LOGF("%s Error recibiendo foto via MQTT", tag);
+    return false;
 }
 
 void showPhoto(int index)
@@ -89,28 +105,27 @@ void showPhoto(int index)
     }
     isLoadingPhoto = true;
 
-    LOGF("[Photo] Heap libre: %d bytes", ESP.getFreeHeap());
-    LOGF("[Photo] Solicitando foto index=%d via MQTT", index);
-
-    // Generar request ID único para filtrar respuestas stale
-    mqttRequestId++;
-
-    // Publicar request via MQTT
-    String topic = String("frame/") + String(frameId) + "/request/photo";
-    String payload = "{\"index\":" + String(index) + ",\"reqId\":" + String(mqttRequestId) + "}";
-
-    armMqttResponseWait();
-    if (!netPublish(topic.c_str(), payload.c_str())) {
-        LOG("[Photo] Error publicando request MQTT");
+    // Precargada (photo_prefetch.h): ya esta en photo565, sin ir a la red
+    if (photoPrefetchTake(index)) {
+        LOGF("[Photo] Foto index=%d precargada: %s by %s", index, photoTitle, photoAuthor);
+        resetAnimationDownloadState(true); // es una foto estatica
+        if (animPlaying) photoPending = true;
+        else displayPhotoWithFade();
         isLoadingPhoto = false;
         processPendingPhoto();
         return;
     }
 
-    // Esperar respuesta
-    if (waitForMqttResponse(RESP_PHOTO, 15000)) {
+    LOGF("[Photo] Heap libre: %d bytes", ESP.getFreeHeap());
+    LOGF("[Photo] Solicitando foto index=%d via MQTT", index);
+
+    // Publicar request via MQTT y esperar respuesta
+    photoCacheSelect(false, index);
+    unsigned long tRequest = millis();
+    if (fetchSelectedPhoto("\"index\":" + String(index), "[Photo]")) {
         esp_task_wdt_reset();
-        LOGF("[Photo] Foto recibida via MQTT: %s by %s", photoTitle, photoAuthor);
+        LOGF("[Photo] Foto recibida via MQTT en %lums: %s by %s", millis() - tRequest, photoTitle, photoAuthor);
+        photoCacheRecordLatency(millis() - tRequest);
         if (currentAnimationId > 0) {
             // Animacion: lo que haya en pantalla (foto o video en curso) sigue
             // hasta que la descarga termine (el swap lo hace startAnimationPlaybackIfReady)
@@ -120,8 +135,6 @@ void showPhoto(int index)
             if (animPlaying) photoPending = true; // prefetch: se pinta al acabar el video
             else displayPhotoWithFade();
         }
-    } else {
-        LOG("[Photo] Error recibiendo foto via MQTT");
     }
 
     isLoadingPhoto = false;
@@ -140,22 +153,13 @@ void showPhotoById(int id)
     LOGF("[Photo] Heap libre: %d bytes", ESP.getFreeHeap());
     LOGF("[Photo] Solicitando foto id=%d via MQTT", id);
 
-    // Publicar request via MQTT
-    String topic = String("frame/") + String(frameId) + "/request/photo";
-    String payload = "{\"id\":" + String(id) + "}";
-
-    armMqttResponseWait();
-    if (!netPublish(topic.c_str(), payload.c_str())) {
-        LOG("[Photo] Error publicando request MQTT");
-        isLoadingPhoto = false;
-        processPendingPhoto();
-        return;
-    }
-
-    // Esperar respuesta
-    if (waitForMqttResponse(RESP_PHOTO, 15000)) {
+    // Publicar request via MQTT y esperar respuesta
+    photoCacheSelect(true, id);
+    unsigned long tRequest = millis();
+    if (fetchSelectedPhoto("\"id\":" + String(id), "[Photo]")) {
         esp_task_wdt_reset();
-        LOGF("[Photo] Foto recibida via MQTT: %s by %s", photoTitle, photoAuthor);
+        LOGF("[Photo] Foto recibida via MQTT en %lums: %s by %s", millis() - tRequest, photoTitle, photoAuthor);
+        photoCacheRecordLatency(millis() - tRequest);
         if (currentAnimationId > 0) {
             startAnimationDownloadIfNeeded();
         }
@@ -163,70 +167,25 @@ void showPhotoById(int id)
             if (animPlaying) photoPending = true;
             else displayPhotoWithFade();
         }
-    } else {
-        LOG("[Photo] Error recibiendo foto via MQTT");
     }
 
     isLoadingPhoto = false;
     processPendingPhoto();
 }
 
+static void photoCenterRevealDone()
+{
+    showPhotoInfo(String(photoTitle), String(photoAuthor));
+}
+
 void displayPhotoFromCenter()
 {
     // Resetear el estado del scroll del título anterior
     titleNeedsScroll = false;
 
-    const int width = 64;
-    const int height = 64;
-    int centerX = 32;
-    int centerY = 32;
-
-    // Animación de cuadrados de colores
-    uint16_t colors[] = {color1, color2, color3, color4, color5};
-    int numColors = 5;
-
-    for (int colorIndex = 0; colorIndex < numColors; colorIndex++)
-    {
-        for (int size = 2; size <= max(PANEL_RES_X, PANEL_RES_Y); size += 2)
-        {
-            for (int y = centerY - size / 2; y <= centerY + size / 2; y++)
-            {
-                for (int x = centerX - size / 2; x <= centerX + size / 2; x++)
-                {
-                    if (x >= 0 && x < PANEL_RES_X && y >= 0 && y < PANEL_RES_Y)
-                    {
-                        drawPixelWithBuffer(x, y, colors[colorIndex]);
-                    }
-                }
-            }
-            delay(5);
-        }
-    }
-
-    // Mostrar imagen desde el centro
-    for (int radius = 0; radius <= max(width, height); radius++)
-    {
-        for (int y = centerY - radius; y <= centerY + radius; y++)
-        {
-            for (int x = centerX - radius; x <= centerX + radius; x++)
-            {
-                if (x >= 0 && x < width && y >= 0 && y < height)
-                {
-                    if (abs(x - centerX) == radius || abs(y - centerY) == radius)
-                    {
-                        int index = (y * width + x) * 3;
-                        uint8_t r = photoBuffer[index + 2];
-                        uint8_t g = photoBuffer[index + 0];
-                        uint8_t b = photoBuffer[index + 1];
-                        uint16_t color = dma_display->color565(r, g, b);
-                        drawPixelWithBuffer(x, y, color);
-                    }
-                }
-            }
-        }
-        delay(5);
-    }
-    showPhotoInfo(String(photoTitle), String(photoAuthor));
+    // Cuadrados de colores desde el centro y luego la foto por anillos; avanza
+    // con updateTransition() (sustituye a un fundido en curso)
+    transitionStartCenterReveal(photoCenterRevealDone);
 }
 
 void showPhotoFromCenterById(int id)
@@ -241,30 +200,19 @@ void showPhotoFromCenterById(int id)
     LOGF("[PhotoCenter] Heap libre: %d bytes", ESP.getFreeHeap());
     LOGF("[PhotoCenter] Solicitando foto id=%d via MQTT", id);
 
-    // Publicar request via MQTT
-    String topic = String("frame/") + String(frameId) + "/request/photo";
-    String payload = "{\"id\":" + String(id) + "}";
-
-    armMqttResponseWait();
-    if (!netPublish(topic.c_str(), payload.c_str())) {
-        LOG("[PhotoCenter] Error publicando request MQTT");
-        isLoadingPhoto = false;
-        processPendingPhoto();
-        return;
-    }
-
-    // Esperar respuesta
-    if (waitForMqttResponse(RESP_PHOTO, 15000)) {
+    // Publicar request via MQTT y esperar respuesta
+    photoCacheSelect(true, id);
+    unsigned long tRequest = millis();
+    if (fetchSelectedPhoto("\"id\":" + String(id), "[PhotoCenter]")) {
         esp_task_wdt_reset();
-        LOGF("[PhotoCenter] Foto recibida via MQTT: %s by %s", photoTitle, photoAuthor);
+        LOGF("[PhotoCenter] Foto recibida via MQTT en %lums: %s by %s", millis() - tRequest, photoTitle, photoAuthor);
+        photoCacheRecordLatency(millis() - tRequest);
         if (currentAnimationId > 0) {
             startAnimationDownloadIfNeeded();
         }
         if (currentAnimationId <= 0) {
             displayPhotoFromCenter();
         }
-    } else {
-        LOG("[PhotoCenter] Error recibiendo foto via MQTT");
     }
 
     songShowing = "";
@@ -303,6 +251,7 @@ void onReceiveNewPic(int id)
     }
 
     photoIndex = 1;
+    photoPrefetchInvalidate(); // la foto nueva desplaza los indices de la rotacion
 
     // Un push del usuario interrumpe cualquier video en curso o descarga pendiente
     stopAnimation();
@@ -314,25 +263,32 @@ void onReceiveNewPic(int id)
     songShowing = "";
 }
 
-void showPhotoInfo(String title, String name)
+static bool inBox(const LayerRect &r, int x, int y)
 {
-    dma_display->setFont(&Picopixel);
-    dma_display->setTextSize(1);
-    dma_display->setTextColor(myWHITE);
-
-    // Calcular las dimensiones reales de ambos textos primero
-    int16_t titleX1, titleY1, nameX1, nameY1;
-    uint16_t titleW = 0, titleH = 0, nameW = 0, nameH = 0;
-
-    dma_display->setTextWrap(false);
+    return x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h;
+}
 
-    if (title.length() > 0) {
-        dma_display->getTextBounds(title, 0, 0, &titleX1, &titleY1, &titleW, &titleH);
+// Capa de texto: cajas negras con el titulo (desplazado titleScrollOffset
+// pixeles si hace scroll) y el autor en blanco
+static uint16_t textLayerPixel(int x, int y)
+{
+    bool on;
+    if (titleStrip.w > 0 && inBox(titleBox, x, y)) {
+        on = textStripGet(titleStrip, x - titleTextX + titleScrollOffset, y - titleTextY);
+    } else {
+        on = textStripGet(nameStrip, x - nameTextX, y - nameTextY);
     }
+    return on ? myWHITE : myBLACK;
+}
 
-    if (name.length() > 0) {
-        dma_display->getTextBounds(name, 0, 0, &nameX1, &nameY1, &nameW, &nameH);
-    }
+void showPhotoInfo(String title, String name)
+{
+    // Rasterizar titulo y autor una vez por foto: el scroll y la overlayMask
+    // trabajan sobre estos bitmaps y sus bounds cacheados
+    textStripRender(titleStrip, title);
+    textStripRender(nameStrip, name);
+    uint16_t titleW = titleStrip.w, titleH = titleStrip.h;
+    uint16_t nameW = nameStrip.w;
     LOGF("titleW: %d title: %s", titleW, title.c_str());
 
     // Guardar el título y nombre actuales
@@ -355,34 +311,7 @@ void showPhotoInfo(String title, String name)
     if (sameLine) {
         titleY = PANEL_RES_Y - 2;
         nameY = PANEL_RES_Y - 2;
-
-        if (title.length() > 0) {
-            if (titleW > PANEL_RES_X - 2) {
-                titleNeedsScroll = true;
-                titleScrollOffset = 0;
-                titleScrollState = SCROLL_PAUSED_START;
-                titleScrollPauseStart = millis();
-
-                dma_display->getTextBounds(title, 1, titleY, &titleX1, &titleY1, &titleW, &titleH);
-                dma_display->fillRect(0, titleY1 - 1, PANEL_RES_X, titleH + 2, myBLACK);
-                dma_display->setCursor(1, titleY);
-                dma_display->print(title);
-            } else {
-                titleNeedsScroll = false;
-                dma_display->getTextBounds(title, 1, titleY, &titleX1, &titleY1, &titleW, &titleH);
-                dma_display->fillRect(0, titleY1 - 1, titleW + 3, titleH + 2, myBLACK);
-                dma_display->setCursor(1, titleY);
-                dma_display->print(title);
-            }
-        }
-
-        if (name.length() > 0) {
-            nameX = PANEL_RES_X - nameW;
-            dma_display->getTextBounds(name, nameX, nameY, &nameX1, &nameY1, &nameW, &nameH);
-            dma_display->fillRect(nameX - 1, nameY1 - 1, nameW + 2, nameH + 2, myBLACK);
-            dma_display->setCursor(nameX, nameY);
-            dma_display->print(name);
-        }
+        nameX = PANEL_RES_X - nameW;
     } else {
         int bottomY = PANEL_RES_Y - 2;
         int topY = bottomY - titleH - 3;
@@ -393,71 +322,157 @@ void showPhotoInfo(String title, String name)
 
         titleY = bottomY;
         nameY = topY;
+        nameX = 1;
+    }
 
-        if (title.length() > 0) {
-            if (titleW > PANEL_RES_X - 2) {
-                titleNeedsScroll = true;
-                titleScrollOffset = 0;
-                titleScrollState = SCROLL_PAUSED_START;
-                titleScrollPauseStart = millis();
-
-                dma_display->getTextBounds(title, 1, titleY, &titleX1, &titleY1, &titleW, &titleH);
-                dma_display->fillRect(0, titleY1 - 1, PANEL_RES_X, titleH + 2, myBLACK);
-                dma_display->setCursor(1, titleY);
-                dma_display->print(title);
-            } else {
-                titleNeedsScroll = false;
-                dma_display->getTextBounds(title, 1, titleY, &titleX1, &titleY1, &titleW, &titleH);
-                dma_display->fillRect(0, titleY1 - 1, titleW + 3, titleH + 2, myBLACK);
-                dma_display->setCursor(1, titleY);
-                dma_display->print(title);
-            }
-        }
+    LayerRect rects[2];
+    uint8_t count = 0;
 
-        if (name.length() > 0) {
-            nameX = 1;
-            dma_display->getTextBounds(name, 1, nameY, &nameX1, &nameY1, &nameW, &nameH);
-            dma_display->fillRect(0, nameY1 - 1, nameW + 3, nameH + 2, myBLACK);
-            dma_display->setCursor(1, nameY);
-            dma_display->print(name);
+    titleNeedsScroll = false;
+    if (title.length() > 0) {
+        if (titleW > PANEL_RES_X - 2) {
+            titleNeedsScroll = true;
+            titleScrollOffset = 0;
+            titleScrollState = SCROLL_PAUSED_START;
+            titleScrollPauseStart = millis();
         }
+        // Caja negra de borde a borde si hace scroll, o ajustada al texto
+        titleTextX = 1 + titleStrip.x1;
+        titleTextY = titleY + titleStrip.y1;
+        int boxW = titleNeedsScroll ? PANEL_RES_X : titleW + 3;
+        titleBox = {0, (int16_t)(titleTextY - 1), (int16_t)boxW, (int16_t)(titleH + 2)};
+        rects[count++] = titleBox;
     }
 
+    if (name.length() > 0) {
+        nameTextX = nameX + nameStrip.x1;
+        nameTextY = nameY + nameStrip.y1;
+        // En el layout de dos lineas (x=1) la caja lleva 1px mas, como el titulo
+        int boxW = nameX == 1 ? nameW + 3 : nameW + 2;
+        nameBox = {(int16_t)(nameX - 1), (int16_t)(nameTextY - 1), (int16_t)boxW, (int16_t)(nameStrip.h + 2)};
+        rects[count++] = nameBox;
+    }
+
+    compositorSetLayer(LAYER_TEXT, rects, count, textLayerPixel);
+    compositorFlush();
 }
 
-// Encola el request de un frame reintentando si la cola de red esta llena,
-// pero acotado: resetea el WDT (un while sin reset causo el TASK_WDT del
-// soak 2026-08-07) y desiste tras capMs — el timeout de descarga re-pedira
-// los frames que falten cuando la red se recupere.
-static bool requestFrameBounded(int animId, int frameIdx, unsigned long capMs) {
+// Suelta el buffer de descarga (bajo animBufLock). En streaming es el mismo
+// que el de reproduccion: solo se corta el alias y el video sigue con los
+// frames que ya habian llegado.
+static void releaseDownloadBuffer() {
+    if (animStreaming) {
+        animStreaming = false;
+    } else if (animBuffer) {
+        frameSlabFree(animBuffer);
+    }
+    animBuffer = nullptr;
+}
+
+static unsigned long animDownloadBegin = 0; // millis() de la rafaga: tasa de llegada y time-to-motion
+static unsigned long animPaletteSentAt = 0;
+static bool animLoadedFromCache = false; // la descarga en curso salio de flash: no se vuelve a guardar
+
+// Carga la animacion de la cache de flash y la deja lista para el swap, sin
+// pedir ningun frame. La lectura va a un buffer que aun no ve nadie, sin
+// animBufLock (la tarea de red no espera a la flash); el lock solo cubre
+// publicarlo. false si no esta, no cabe en RAM o llego otra animacion mientras.
+static bool loadCachedAnimation() {
+    int animId = currentAnimationId;
+    AnimCacheInfo info;
+    if (!animCacheLookup(animId, &info) || info.frameWidth != animFrameWidth) return false;
+
     unsigned long t0 = millis();
-    while (!requestAnimationFrame(animId, frameIdx)) {
-        esp_task_wdt_reset();
-        updateAnimationPlayback();
-        if (millis() - t0 > capMs) return false;
+    size_t needed = frameStoreBytes(info.frameCount, info.slotSize, info.indexBits);
+    uint8_t* buffer = nullptr;
+    if (hasPsram || needed + 8192 <= ESP.getMaxAllocHeap()) {
+        buffer = frameSlabAlloc(needed);
+    }
+    if (!buffer) {
+        LOGF("[Anim] Animacion %d en cache pero sin RAM para cargarla (%d bytes)", animId, needed);
+        return false;
+    }
+    frameStoreInit(buffer, needed, info.frameCount, info.slotSize, info.indexBits);
+    if (!animCacheRead(animId, buffer, info)) {
+        frameSlabFree(buffer);
+        return false;
+    }
+
+    animBufLock();
+    if (currentAnimationId != animId) {
+        animBufUnlock();
+        frameSlabFree(buffer);
+        LOGF("[Anim] Animacion %d leida de cache pero ya no es la actual", animId);
+        return false;
     }
+    animBuffer = buffer;
+    animFrameCount = info.frameCount;
+    animFrameStep = info.frameStep;
+    animFrameInterval = info.frameInterval;
+    animIndexBits = info.indexBits;
+    animSlotSize = info.slotSize;
+    animDeltaBitmap = info.deltaBitmap;
+    bitsetFill(animFramesBitmap, info.frameCount);
+    animFramesReceived = info.frameCount;
+    animPaletteReceived = true;
+    animRetryCount = 0;
+    animReady = true;
+    animReadyTime = millis();
+    animLoadedFromCache = true;
+    animBufUnlock();
+    LOGF("[Anim] Animacion %d desde cache: %d frames (%d bits) en %lums, sin pedir frames",
+         animId, info.frameCount, info.indexBits ? info.indexBits : 16, millis() - t0);
     return true;
 }
 
-void startAnimationDownloadIfNeeded() {
+// Guarda en la cache de flash la animacion que acaba de pasar a reproduccion
+// (se escribe slot a slot desde el loop). Sin animBufLock: playBuffer ya es
+// solo de la reproduccion, y la expulsion LRU y crear el fichero tocan flash.
+static void cacheDownloadedAnimation(int animId, uint8_t frameStep) {
+    if (animLoadedFromCache) return;
+    AnimCacheInfo info = {playFrameCount, animFrameWidth, playIndexBits, frameStep,
+                          playSlotSize, (uint16_t)playFrameInterval, playDeltaBitmap};
+    animCacheStoreBegin(animId, playBuffer, info);
+}
+
+static void prepareAnimationDownload() {
     if (currentAnimationId > 0 && animFrameCount > 0 && !animReady) {
         // Bajo lock: la tarea de red puede estar escribiendo un frame rezagado
         // de la animacion anterior en el buffer que vamos a liberar
         animBufLock();
-        if (animBuffer) {
-            free(animBuffer);
-            animBuffer = nullptr;
-        }
+        releaseDownloadBuffer();
+        animBufUnlock();
+
+        animDownloadBegin = millis();
+        animLoadedFromCache = false;
+        if (animFromCache && loadCachedAnimation()) return;
 
+        animBufLock();
+        if (currentAnimationId <= 0 || animFrameCount == 0 || animReady) {
+            // Cambio mientras se miraba la cache (foto nueva, reset)
+            animBufUnlock();
+            return;
+        }
         uint8_t totalBackendFrames = animFrameCount;
         uint8_t framesToUse = totalBackendFrames;
         animFrameStep = 1;
+        animIndexBits = 0;
+        animSlotSize = animFrameSize;
+        animPaletteReceived = false;
 
         if (!hasPsram) {
-            // Limit frames to fit in largest contiguous free block (with 8KB safety margin)
+            // Limit frames to fit in largest contiguous free block (with 8KB safety
+            // margin, the extra on-screen frame used by delta playback and the palette)
             size_t maxBlock = ESP.getMaxAllocHeap();
-            size_t safeBlock = maxBlock > 8192 ? maxBlock - 8192 : 0;
-            uint8_t maxFrames = safeBlock / animFrameSize;
+
+            // Con paleta: 8 bits por pixel si caben todos los frames, si no 4
+            // (un cuarto del RGB565, con 16 colores)
+            if (animPaletteOffered) {
+                uint16_t slot8 = frameIndexedSize(animFrameWidth, 8);
+                animIndexBits = frameStoreFramesThatFit(maxBlock, slot8, 8) >= totalBackendFrames ? 8 : 4;
+                animSlotSize = frameIndexedSize(animFrameWidth, animIndexBits);
+            }
+            uint8_t maxFrames = frameStoreFramesThatFit(maxBlock, animSlotSize, animIndexBits);
 
             if (maxFrames < 2) {
                 LOGF("[Anim] Not enough RAM for animation (largest block: %d)", maxBlock);
@@ -475,12 +490,11 @@ void startAnimationDownloadIfNeeded() {
             }
         }
 
-        size_t needed = framesToUse * animFrameSize;
-        if (hasPsram) {
-            animBuffer = (uint8_t*)ps_malloc(needed);
-        } else {
-            animBuffer = (uint8_t*)malloc(needed);
-        }
+        // Ademas de los frames: el frame en pantalla, sobre el que se aplican
+        // los deltas al reproducir (frame_delta.h), y la paleta si es
+        // indexada. Con compresion el tamano es fijo (frame_store.h)
+        size_t needed = frameStoreBytes(framesToUse, animSlotSize, animIndexBits);
+        animBuffer = frameSlabAlloc(needed);
         if (!animBuffer) {
             LOGF("[Anim] Failed to allocate %d bytes (free heap: %d, largest block: %d)", needed, ESP.getFreeHeap(), ESP.getMaxAllocHeap());
             currentAnimationId = -1;
@@ -488,6 +502,7 @@ void startAnimationDownloadIfNeeded() {
             animBufUnlock();
             return;
         }
+        frameStoreInit(animBuffer, needed, framesToUse, animSlotSize, animIndexBits);
 
         // Adjust playback interval to maintain original duration
         // Original duration = totalBackendFrames / animFps seconds
@@ -495,104 +510,233 @@ void startAnimationDownloadIfNeeded() {
         animFrameInterval = (unsigned long)totalBackendFrames * 1000 / animFps / framesToUse;
         animFrameCount = framesToUse;
 
-        LOGF("[Anim] %d/%d frames (step=%d, %dx%d, %s), interval=%dms",
+        LOGF("[Anim] %d/%d frames (step=%d, %dx%d, %d bits, %s), interval=%dms",
              framesToUse, totalBackendFrames, animFrameStep,
-             animFrameWidth, animFrameWidth, hasPsram ? "PSRAM" : "RAM",
-             animFrameInterval);
+             animFrameWidth, animFrameWidth, animIndexBits ? animIndexBits : 16,
+             hasPsram ? "PSRAM" : "RAM", animFrameInterval);
         animFramesReceived = 0;
-        animFramesBitmap = 0;
+        bitsetResize(animFramesBitmap, framesToUse);
+        bitsetResize(animDeltaBitmap, framesToUse);
         animRetryCount = 0;
         animBufUnlock(); // los frames ya pueden empezar a llegar mientras encolamos
 
-        // Pipelined download: encolar todos los requests; la tarea de red (core 0)
-        // los publica y drena las respuestas sin bloquear la reproduccion aqui.
-        unsigned long tBurst = millis(); // [Diag]
-        uint8_t queued = 0;
-        for (uint8_t slot = 0; slot < animFrameCount; slot++) {
-            if (!requestFrameBounded(currentAnimationId, slot * animFrameStep, 3000)) {
-                LOGF("[Anim] Cola de red saturada: rafaga abortada en slot %d/%d (el timeout re-pedira el resto)",
-                     slot, animFrameCount);
-                break;
-            }
-            queued++;
-            updateAnimationPlayback(); // no congelar un video en curso (prefetch)
-        }
-        LOGF("[Diag] Rafaga de %d/%d requests encolada en %lums (playing=%d)",
-             queued, animFrameCount, millis() - tBurst, (int)animPlaying);
-        animDownloadStartTime = millis();
+        // Descarga con ventana deslizante (anim_window.h): aqui solo se abre la
+        // ventana inicial; updateAnimationDownload la mantiene llena desde el
+        // loop. La tarea de red (core 0) publica y drena las respuestas.
+        animDownloadBegin = millis();
+        animDownloadStartTime = animDownloadBegin;
+        animWindowBegin(animFrameCount, animDownloadBegin);
+        animPaletteSentAt = 0;
+        updateAnimationDownload();
+        LOGF("[Diag] Ventana inicial: %d/%d frames pedidos (%s, playing=%d)",
+             animWindowInFlight(), animFrameCount, animRangeOffered ? "rango" : "frame a frame",
+             (int)animPlaying);
     }
 }
 
-// La descarga termino: sustituye lo que haya en pantalla (foto anterior o video
-// que acaba sus vueltas) por el primer frame + titulo de la animacion y arranca
-// el playback. El buffer de descarga pasa a ser el de reproduccion, dejando la
-// maquinaria de descarga libre para el prefetch del siguiente. Llamada desde el
-// loop principal.
-bool startAnimationPlaybackIfReady() {
-    if (!animReady || currentAnimationId <= 0 || !animBuffer) return false;
-    // Si hay un video reproduciendose, dejarle terminar sus vueltas antes del swap
-    if (animPlaying && animLoopCount < playMaxLoops) return false;
+void startAnimationDownloadIfNeeded() {
+    // La lectura de flash (cache), las reservas y la ventana inicial no pintan
+    // y el estado de descarga es solo de la logica: el render sigue mientras
+    // (render_task.h)
+    bool held = renderLockRelease();
+    prepareAnimationDownload();
+    renderLockRestore(held);
+}
+
+// La descarga termino (o va lo bastante adelantada, ver animStreamCanStart):
+// sustituye lo que haya en pantalla (foto anterior o video que acaba sus
+// vueltas) por el primer frame + titulo de la animacion y arranca el playback
+// al terminar el fundido. El buffer de descarga pasa a ser el de
+// reproduccion, dejando la maquinaria de descarga libre para el prefetch del
+// siguiente. Llamada desde el loop principal.
+static int animSwapId = -1;
+static unsigned long animSwapSinceReady = 0;
+static unsigned long animSwapStart = 0;
+static unsigned long animSwapDownloadBegin = 0; // [Diag] time-to-motion
+static bool animSwapStreaming = false;
+
+// Tiles que cambian entre lo que hay en pantalla y el frame a pintar. El
+// primer frame va entero: en pantalla esta la foto, no un frame.
+static uint64_t playDirtyTiles = 0;
+static uint32_t playTilesDrawn = 0; // [Diag] tiles pintados en la primera vuelta
+
+// Ultima vuelta pintada: el video sigue en pantalla hasta finishAnimationPlayback
+static volatile bool playbackEnded = false;
+
+// [Diag] esperas por hueco durante el streaming
+static uint16_t streamHolds = 0;
+static unsigned long streamHoldMs = 0;
+
+static void beginAnimationPlayback() {
+    if (!playBuffer) return; // parada durante el fundido
+    playDirtyTiles = FRAME_ALL_TILES;
+    playTilesDrawn = 0;
+    streamHolds = 0;
+    streamHoldMs = 0;
+    animCurrentFrame = 0;
+    animLoopCount = 0;
+    animLastFrameTime = millis();
+    playbackEnded = false;
+    animPlaying = true;
+    lastPhotoChange = millis(); // el intervalo de foto empieza cuando la animacion se ve
+    LOGF("[Anim] Starting playback id=%d (%s, %lums desde ready, swap+fade %lums)",
+         animSwapId, animSwapStreaming ? "streaming" : "completa",
+         animSwapSinceReady, millis() - animSwapStart);
+    LOGF("[Diag] Time-to-motion: %lums desde la rafaga (%d/%d frames)",
+         millis() - animSwapDownloadBegin, playFramesAvailable, playFrameCount);
+}
 
-    int animId = currentAnimationId; // para el log (el reset lo pone a -1)
-    unsigned long sinceReady = animReadyTime ? millis() - animReadyTime : 0;
-    unsigned long tSwap = millis();
+// Streaming: se puede empezar antes de tener todos los frames si, al ritmo de
+// llegada medido, lo que falta llega antes de que la reproduccion lo necesite
+// (con margen). Un hueco no previsto no rompe nada: se mantiene el ultimo frame.
+static bool animStreamCanStart() {
+    const uint8_t ANIM_STREAM_MIN_FRAMES = 4;
+    const unsigned long ANIM_STREAM_MARGIN_PCT = 80;
 
+    animBufLock();
+    uint8_t prefix = bitsetPrefix(animFramesBitmap);
+    uint8_t received = animFramesReceived;
+    uint8_t count = animFrameCount;
+    bool paletteOk = !animIndexBits || animPaletteReceived;
+    animBufUnlock();
+
+    if (!paletteOk || count == 0 || prefix < min(ANIM_STREAM_MIN_FRAMES, count)) return false;
+    unsigned long elapsed = millis() - animDownloadBegin;
+    unsigned long remainingMs = (unsigned long)(count - received) * elapsed / received;
+    unsigned long playMs = (unsigned long)count * animFrameInterval * ANIM_STREAM_MARGIN_PCT / 100;
+    return remainingMs <= playMs;
+}
+
+// Streaming en curso: refresca el prefijo reproducible y, cuando la descarga
+// acaba, suelta el alias. Si se abandona a medias (timeout, foto nueva) el
+// alias ya lo solto resetAnimationDownloadState y el video da la vuelta con
+// los frames que llegaron.
+static void updateAnimationStream() {
+    animBufLock();
+    if (!animStreaming) {
+        animBufUnlock();
+        return;
+    }
+    // La descarga pudo recortarse por falta de sitio (frame_store.h)
+    if (animFrameCount < playFrameCount) playFrameCount = animFrameCount;
+    playFramesAvailable = bitsetPrefix(animFramesBitmap);
+    playDeltaBitmap = animDeltaBitmap;
+    bool done = animReady;
+    int animId = currentAnimationId;
+    uint8_t frameStep = animFrameStep;
+    if (done) {
+        animBuffer = nullptr;
+        animStreaming = false;
+        resetAnimationDownloadState(false);
+    }
+    animBufUnlock();
+    if (done) {
+        cacheDownloadedAnimation(animId, frameStep);
+        LOGF("[Diag] Streaming completo: %u esperas por hueco (%lums)", streamHolds, streamHoldMs);
+    }
+}
+
+void startAnimationPlaybackIfReady() {
+    if (animStreaming) {
+        updateAnimationStream();
+        return;
+    }
+    if (currentAnimationId <= 0 || !animBuffer) return;
+    // Si hay un video reproduciendose, dejarle terminar sus vueltas antes del swap
+    if (animPlaying && animLoopCount < playMaxLoops) return;
+    if (transitionActive()) return; // otra transicion a medias: primero que acabe
+    bool streaming = !animReady;
+    if (streaming && !animStreamCanStart()) return;
+
+    animSwapId = currentAnimationId; // para el log (el reset lo pone a -1)
+    animSwapSinceReady = animReadyTime ? millis() - animReadyTime : 0;
+    animSwapStart = millis();
+    animSwapDownloadBegin = animDownloadBegin;
+    animSwapStreaming = streaming;
+    animReadyTime = 0;
+
+    animCacheStoreAbort(); // el buffer anterior se libera (si aun se estaba guardando)
+    uint8_t frameStep = animFrameStep;
     animBufLock(); // transferencia del buffer: que la tarea de red no escriba a mitad
-    if (playBuffer) free(playBuffer);
+    frameSlabFree(playBuffer);
     playBuffer = animBuffer;
-    animBuffer = nullptr;
     playFrameCount = animFrameCount;
+    playDeltaBitmap = animDeltaBitmap;
+    playIndexBits = animIndexBits;
+    playSlotSize = animSlotSize;
     playFrameInterval = animFrameInterval;
     unsigned long loopMs = (unsigned long)playFrameCount * playFrameInterval;
     playMaxLoops = loopMs > 0 ? max(3UL, (unsigned long)secsPhotos / loopMs) : 3UL;
 
     animPlaying = false;
-    resetAnimationDownloadState(false);
+    playbackEnded = false; // el fin del video anterior ya no hay que tratarlo
+    if (streaming) {
+        // La tarea de red sigue escribiendo los frames que faltan en el mismo
+        // buffer; el estado de descarga se conserva hasta que termine
+        animStreaming = true;
+        playFramesAvailable = bitsetPrefix(animFramesBitmap);
+    } else {
+        animBuffer = nullptr;
+        playFramesAvailable = playFrameCount;
+        resetAnimationDownloadState(false);
+    }
     animBufUnlock();
+    if (!streaming) cacheDownloadedAnimation(animSwapId, frameStep);
+
+    lastPhotoChange = millis(); // que el loop no pida otra foto durante el fundido
+    displayPhotoWithFade(beginAnimationPlayback);
+}
 
-    displayPhotoWithFade();
-    buildOverlayMask(); // tras pintar el titulo, para que el layout sea el definitivo
+// Aplica el slot sobre el frame en pantalla (el de playBuffer) sin pintar;
+// los frames saltados por catch-up tambien pasan por aqui
+static void applyAnimationFrame(uint8_t frameIndex) {
+    uint8_t* onScreen = frameStoreOnScreen(playBuffer);
+    const uint8_t* slot = frameStoreSlot(playBuffer, frameIndex);
+    if (playIndexBits) {
+        const uint16_t* palette = frameStorePalette(playBuffer);
+        playDirtyTiles |= frameApplyIndexed(onScreen, slot, palette, playIndexBits, animFrameWidth);
+        return;
+    }
+    bool isDelta = bitsetTest(playDeltaBitmap, frameIndex);
+    playDirtyTiles |= frameApply(onScreen, slot, isDelta, animFrameWidth);
+}
+
+// Pinta los tiles pendientes (los de los frames aplicados desde el ultimo volcado)
+static void presentAnimationTiles() {
+    playTilesDrawn += __builtin_popcountll(playDirtyTiles);
+    panelBeginFrame();
+    blitAnimationTiles(frameStoreOnScreen(playBuffer), animFrameWidth, playDirtyTiles);
+    panelPresent(); // con doble buffer: flip en el limite de frame
+    playDirtyTiles = 0;
+}
+
+void drawAnimationFrame(uint8_t frameIndex) {
+    applyAnimationFrame(frameIndex);
+    presentAnimationTiles();
+}
+
+// Frames de una vuelta: en streaming la vuelta es la animacion entera (lo que
+// falta se espera); si la descarga se quedo a medias, solo lo que llego
+static uint8_t animLoopFrames() {
+    return animStreaming ? playFrameCount : playFramesAvailable;
+}
+
+static bool advanceAnimationFrame() {
+    animCurrentFrame++;
+    if (animCurrentFrame < animLoopFrames()) return false;
     animCurrentFrame = 0;
-    animLoopCount = 0;
-    animLastFrameTime = millis();
-    animPlaying = true;
-    lastPhotoChange = millis(); // el intervalo de foto empieza cuando la animacion se ve
-    animReadyTime = 0;
-    LOGF("[Anim] Starting playback id=%d (%lums desde ready, swap+fade %lums)",
-         animId, sinceReady, millis() - tSwap);
+    animLoopCount++;
     return true;
 }
 
-void drawAnimationFrame(uint8_t frameIndex) {
-    uint8_t* frame = playBuffer + frameIndex * animFrameSize;
-
-    if (animFrameWidth == 64) {
-        for (int y = 0; y < 64; y++) {
-            for (int x = 0; x < 64; x++) {
-                if (overlayMaskGet(x, y)) continue; // skip overlay pixels
-                int idx = (y * 64 + x) * 2;
-                uint16_t color = (frame[idx] << 8) | frame[idx + 1];
-                dma_display->drawPixel(x, y, color);
-            }
-        }
-    } else {
-        for (int y = 0; y < 32; y++) {
-            for (int x = 0; x < 32; x++) {
-                int px = x * 2, py = y * 2;
-                int idx = (y * 32 + x) * 2;
-                uint16_t color = (frame[idx] << 8) | frame[idx + 1];
-                // Draw 2x2 block, skipping overlay pixels
-                if (!overlayMaskGet(px, py))     dma_display->drawPixel(px, py, color);
-                if (!overlayMaskGet(px+1, py))   dma_display->drawPixel(px+1, py, color);
-                if (!overlayMaskGet(px, py+1))   dma_display->drawPixel(px, py+1, color);
-                if (!overlayMaskGet(px+1, py+1)) dma_display->drawPixel(px+1, py+1, color);
-            }
-        }
-    }
+bool playbackNextDue(unsigned long* due) {
+    if (!animPlaying || playbackEnded || playFrameCount == 0 || !playBuffer) return false;
+    *due = animLastFrameTime + playFrameInterval;
+    return true;
 }
 
 void updateAnimationPlayback() {
-    if (!animPlaying || playFrameCount == 0 || !playBuffer) return;
+    if (!animPlaying || playbackEnded || playFrameCount == 0 || !playBuffer) return;
 
     unsigned long now = millis();
     if (now - animLastFrameTime < playFrameInterval) return;
@@ -622,20 +766,38 @@ void updateAnimationPlayback() {
             lastSkipReport = now;
         }
     }
-    for (uint16_t i = 1; i < steps; i++) {
-        animCurrentFrame++;
-        if (animCurrentFrame >= playFrameCount) {
-            animCurrentFrame = 0;
-            animLoopCount++;
-        }
+    if (!animStreaming && animCurrentFrame >= playFramesAvailable) {
+        // Streaming abandonado mientras se esperaba un hueco: vuelta a empezar
+        animCurrentFrame = 0;
+        animLoopCount++;
+    }
+    for (uint16_t i = 1; i < steps && animCurrentFrame < playFramesAvailable; i++) {
+        applyAnimationFrame(animCurrentFrame);
+        advanceAnimationFrame();
+    }
+
+    if (animCurrentFrame >= playFramesAvailable) {
+        // Streaming: el siguiente frame aun no ha llegado. Se mantiene el
+        // ultimo (con lo aplicado por catch-up) y el reloj se para, para no
+        // saltar frames cuando llegue.
+        if (playDirtyTiles) presentAnimationTiles();
+        streamHolds++;
+        streamHoldMs += now - animLastFrameTime;
+        animLastFrameTime = now;
+        return;
     }
 
     drawAnimationFrame(animCurrentFrame);
-    animCurrentFrame++;
-    if (animCurrentFrame >= playFrameCount) {
-        animCurrentFrame = 0;
-        animLoopCount++;
+    if (advanceAnimationFrame() && animLoopCount == 1) {
+        FrameStoreStats st = frameStoreStats(playBuffer);
+        LOGF("[Diag] Video: %lu/%d tiles por frame en la primera vuelta (%d deltas); "
+             "%u bytes/frame en memoria, descompresion %luus/frame (max %luus)",
+             (unsigned long)(playTilesDrawn / animLoopFrames()), FRAME_TILE_COUNT, bitsetCount(playDeltaBitmap),
+             (unsigned)(st.storedBytes / max(1, (int)st.frames)),
+             (unsigned long)(st.decodes ? st.decodeUs / st.decodes : 0), (unsigned long)st.decodeMaxUs);
     }
+    // El siguiente se descomprime ya, en el hueco hasta su tick
+    if (animCurrentFrame < playFramesAvailable) frameStorePrefetch(playBuffer, animCurrentFrame);
     animLastFrameTime += (unsigned long)steps * playFrameInterval; // conserva la fase
 
     if (animLoopCount >= playMaxLoops) {
@@ -655,19 +817,26 @@ void updateAnimationPlayback() {
             return;
         }
 
-        if (photoPending) {
-            // Prefetch devolvio una foto estatica: ahora es su turno
-            stopPlayback();
-            photoPending = false;
-            displayPhotoWithFade();
-            lastPhotoChange = millis();
-        } else {
-            LOG("[Anim] Playback finished (loop limit reached)");
-            stopPlayback();
-            // No reseteamos lastPhotoChange: la reproduccion ya consumio el intervalo
-            // (playMaxLoops esta calculado para durar ~secsPhotos), asi que la
-            // siguiente foto sale enseguida en vez de dejar el ultimo frame congelado.
-        }
+        // Liberar el buffer y pasar a la foto siguiente es cosa de la logica
+        // (finishAnimationPlayback): aqui solo se para el reloj del video
+        playbackEnded = true;
+    }
+}
+
+void finishAnimationPlayback() {
+    if (!playbackEnded) return;
+    if (photoPending) {
+        // Prefetch devolvio una foto estatica: ahora es su turno
+        stopPlayback();
+        photoPending = false;
+        displayPhotoWithFade();
+        lastPhotoChange = millis();
+    } else {
+        LOG("[Anim] Playback finished (loop limit reached)");
+        stopPlayback();
+        // No reseteamos lastPhotoChange: la reproduccion ya consumio el intervalo
+        // (playMaxLoops esta calculado para durar ~secsPhotos), asi que la
+        // siguiente foto sale enseguida en vez de dejar el ultimo frame congelado.
     }
 }
 
@@ -684,15 +853,19 @@ bool animPrefetchDue() {
     return remaining <= ANIM_PREFETCH_MS;
 }
 
-// Para la reproduccion y libera su buffer. No toca el estado de descarga.
+// Para la reproduccion y libera su buffer. No toca el estado de descarga,
+// salvo en streaming: la descarga escribe en este mismo buffer y se abandona.
 void stopPlayback() {
+    if (animStreaming) resetAnimationDownloadState(false);
     animPlaying = false;
+    playbackEnded = false;
     animCurrentFrame = 0;
     animLoopCount = 0;
     playFrameCount = 0;
-    overlayMaskClear();
+    playFramesAvailable = 0;
+    animCacheStoreAbort();
     if (playBuffer) {
-        free(playBuffer);
+        frameSlabFree(playBuffer);
         playBuffer = nullptr;
         LOGF("[Anim] Play buffer freed (free heap: %d)", ESP.getFreeHeap());
     }
@@ -701,20 +874,25 @@ void stopPlayback() {
 // Resetea el estado de descarga (y opcionalmente libera su buffer). No toca la
 // reproduccion en curso.
 void resetAnimationDownloadState(bool freeBuffer) {
-    animBufLock(); // llamable desde ambos cores (handlePhotoResponse corre en la tarea de red)
+    animBufLock(); // llamable desde ambos cores (streamPhotoResponse corre en la tarea de red)
     currentAnimationId = -1;
     animReady = false;
     animFrameCount = 0;
     animFramesReceived = 0;
-    animFramesBitmap = 0;
+    bitsetResize(animFramesBitmap, 0);
+    bitsetResize(animDeltaBitmap, 0);
+    animIndexBits = 0;
+    animSlotSize = animFrameSize;
+    animPaletteOffered = false;
+    animRangeOffered = false;
+    animFromCache = false;
+    animPaletteReceived = false;
     animFrameStep = 1;
     animFrameInterval = 200;
     animRetryCount = 0;
     animDownloadStartTime = 0;
-    if (freeBuffer && animBuffer) {
-        free(animBuffer);
-        animBuffer = nullptr;
-    }
+    // Sin descarga no hay streaming: el alias se suelta siempre
+    if (freeBuffer || animStreaming) releaseDownloadBuffer();
     animBufUnlock();
 }
 
@@ -724,55 +902,82 @@ void stopAnimation() {
     photoPending = false;
 }
 
-// Re-requests any frames still missing after a stall window (no frame received
-// for ANIM_DOWNLOAD_TIMEOUT_MS — el cronometro se resetea con cada frame que llega).
-// Called from the main loop; cheap when there's no animation downloading.
-void checkAnimationDownloadTimeout() {
+#define ANIM_DOWNLOAD_GIVEUP_MS 15000
+
+static bool animDownloadStalled(unsigned long now) {
+    if (animReady || currentAnimationId <= 0 || animBuffer == nullptr) return false;
+    return animDownloadStartTime != 0 && now - animDownloadStartTime >= ANIM_DOWNLOAD_GIVEUP_MS;
+}
+
+// Descarga sin llegar nada en ANIM_DOWNLOAD_GIVEUP_MS: se abandona. Desde el
+// loop con el panel tomado (puede parar el video y pintar la foto)
+void giveUpStalledAnimationDownload() {
+    unsigned long now = millis();
+    if (!animDownloadStalled(now)) return;
+    LOGF("[Anim] Giving up after %lums without progress (%d/%d frames, %d perdidos)",
+         now - animDownloadStartTime, animFramesReceived, animFrameCount, animWindowLosses());
+    if (animPlaying) {
+        // Prefetch fallido: el video actual sigue; al terminar sus vueltas el
+        // loop principal pedira otra foto por el camino normal
+        resetAnimationDownloadState(true);
+    } else {
+        stopAnimation();
+        // La foto nueva nunca llego a pintarse (seguia la anterior en pantalla):
+        // mostramos su primer frame como foto estatica
+        displayPhotoWithFade();
+    }
+}
+
+// Mantiene llena la ventana de pedidos de la descarga en curso (anim_window.h):
+// cuenta las llegadas, vuelve a pedir lo que vence su RTO y pide huecos nuevos
+// mientras quepan. Called from the main loop with the panel released (it only
+// publishes); cheap when there's no animation downloading.
+void updateAnimationDownload() {
     if (animReady || currentAnimationId <= 0 || animBuffer == nullptr) return;
     if (animDownloadStartTime == 0) return;
 
-    const unsigned long ANIM_DOWNLOAD_TIMEOUT_MS = 5000;
-    const uint8_t ANIM_MAX_RETRIES = 3;
-
-    if (millis() - animDownloadStartTime < ANIM_DOWNLOAD_TIMEOUT_MS) return;
-
-    if (animRetryCount >= ANIM_MAX_RETRIES) {
-        LOGF("[Anim] Giving up after %d retries (%d/%d frames)",
-             animRetryCount, animFramesReceived, animFrameCount);
-        if (animPlaying) {
-            // Prefetch fallido: el video actual sigue; al terminar sus vueltas el
-            // loop principal pedira otra foto por el camino normal
-            resetAnimationDownloadState(true);
-        } else {
-            stopAnimation();
-            // La foto nueva nunca llego a pintarse (seguia la anterior en pantalla):
-            // mostramos su primer frame como foto estatica
-            displayPhotoWithFade();
-        }
-        return;
-    }
+    const uint8_t ANIM_SENDS_PER_TICK = 4; // la pubQueue es de 16
+
+    unsigned long now = millis();
+    if (animDownloadStalled(now)) return; // giveUpStalledAnimationDownload
 
-    // Copiar el estado bajo lock (bitmap de 64 bits: lectura no atomica) y
+    // Copiar el estado bajo lock (el bitset no se lee de forma atomica) y
     // publicar fuera, para no retener el mutex mientras la cola de red drena
     animBufLock();
-    uint64_t bitmap = animFramesBitmap;
+    FrameBitset bitmap = animFramesBitmap;
     uint8_t frameCount = animFrameCount;
     int animId = currentAnimationId;
+    bool paletteMissing = animIndexBits && !animPaletteReceived;
     animBufUnlock();
 
-    uint8_t missing = 0;
-    for (uint8_t slot = 0; slot < frameCount; slot++) {
-        if (!(bitmap & (1ULL << slot))) {
-            if (!requestFrameBounded(animId, slot * animFrameStep, 3000)) {
-                LOGF("[Anim] Cola de red saturada durante retry (slot %d): se reintentara en la proxima ronda", slot);
-                break;
-            }
-            missing++;
-        }
+    animWindowUpdate(bitmap, now);
+    uint16_t losses = animWindowLosses();
+    animRetryCount = losses > 255 ? 255 : losses;
+
+    if (paletteMissing && (animPaletteSentAt == 0 || now - animPaletteSentAt >= animWindowRto())) {
+        if (requestAnimationPalette(animId)) animPaletteSentAt = now;
+    }
+
+    // Con rangos se espera a que quepa un tramo de varios frames: un mensaje
+    // por frame es justo lo que el rango ahorra
+    uint8_t maxRun = animRangeOffered ? frameCount : 1;
+    uint8_t minRun = animRangeOffered ? 4 : 1;
+    uint8_t first, last;
+    for (uint8_t sends = 0; sends < ANIM_SENDS_PER_TICK; sends++) {
+        if (!animWindowNext(bitmap, maxRun, minRun, &first, &last)) break;
+        bool ok = animRangeOffered
+            ? requestAnimationFrames(animId, first * animFrameStep, last * animFrameStep)
+            : requestAnimationFrame(animId, first * animFrameStep);
+        if (!ok) break; // cola de red llena: en el siguiente tick
+        animWindowSent(first, last, now);
     }
-    animRetryCount++;
-    animDownloadStartTime = millis();
-    LOGF("[Anim] Retry %d: re-requested %d missing frames", animRetryCount, missing);
+}
+
+bool photoInfoNextDue(unsigned long* due) {
+    if (!titleNeedsScroll || currentTitle.length() == 0 || animPlaying) return false;
+    bool paused = titleScrollState == SCROLL_PAUSED_START || titleScrollState == SCROLL_PAUSED_END;
+    *due = paused ? titleScrollPauseStart + titleScrollPauseTime : lastTitleScrollTime + titleScrollSpeed;
+    return true;
 }
 
 void updatePhotoInfo() {
@@ -781,6 +986,8 @@ void updatePhotoInfo() {
     }
 
     unsigned long currentTime = millis();
+    // Desplazamiento maximo: el final del titulo queda en x = PANEL_RES_X - 2
+    int maxOffset = (int)titleStrip.w - (PANEL_RES_X - 2);
 
     switch (titleScrollState) {
         case SCROLL_PAUSED_START:
@@ -793,22 +1000,10 @@ void updatePhotoInfo() {
         case SCROLL_SCROLLING:
             if (currentTime - lastTitleScrollTime >= titleScrollSpeed) {
                 titleScrollOffset++;
+                compositorDamage(titleBox.x, titleBox.y, titleBox.w, titleBox.h);
+                compositorFlush();
 
-                String scrolledTitle = currentTitle.substring(titleScrollOffset);
-
-                dma_display->setFont(&Picopixel);
-                dma_display->setTextSize(1);
-                int16_t x1, y1;
-                uint16_t w, h;
-                dma_display->getTextBounds(scrolledTitle, 1, titleY, &x1, &y1, &w, &h);
-
-                dma_display->fillRect(0, y1 - 1, PANEL_RES_X, h + 2, myBLACK);
-
-                dma_display->setTextColor(myWHITE);
-                dma_display->setCursor(1, titleY);
-                dma_display->print(scrolledTitle);
-
-                if (w <= PANEL_RES_X - 2) {
+                if (titleScrollOffset >= maxOffset) {
                     titleScrollState = SCROLL_PAUSED_END;
                     titleScrollPauseStart = currentTime;
                 }
@@ -828,21 +1023,8 @@ void updatePhotoInfo() {
             if (currentTime - lastTitleScrollTime >= titleScrollSpeed) {
                 if (titleScrollOffset > 0) {
                     titleScrollOffset--;
-
-                    String scrolledTitle = currentTitle.substring(titleScrollOffset);
-
-                    dma_display->setFont(&Picopixel);
-                    dma_display->setTextSize(1);
-                    int16_t x1, y1;
-                    uint16_t w, h;
-                    dma_display->getTextBounds(scrolledTitle, 1, titleY, &x1, &y1, &w, &h);
-
-                    dma_display->fillRect(0, y1 - 1, PANEL_RES_X, h + 2, myBLACK);
-
-                    dma_display->setTextColor(myWHITE);
-                    dma_display->setCursor(1, titleY);
-                    dma_display->print(scrolledTitle);
-
+                    compositorDamage(titleBox.x, titleBox.y, titleBox.w, titleBox.h);
+                    compositorFlush();
                     lastTitleScrollTime = currentTime;
                 } else {
                     titleScrollState = SCROLL_PAUSED_START;
@@ -3,6 +3,9 @@
 
 #include "globals.h"
 
+// Cuerpo de request/photo para selector ("\"index\":N" o "\"id\":N") y el etag
+// de la cache (photo_cache.h)
+String photoRequestPayload(const String &selector, const String &etagField);
 void showPhoto(int index);
 void showPhotoById(int id);
 void showPhotoFromCenterById(int id);
@@ -10,14 +13,20 @@ void showPhotoIndex(int index);
 void showPhotoId(int id);
 void onReceiveNewPic(int id);
 void processPendingPhoto();
-void displayPhotoWithFade();
+void displayPhotoWithFade(void (*onShown)() = nullptr); // no bloquea: avanza con updateTransition()
 void displayPhotoFromCenter();
 void showPhotoInfo(String title, String name);
 void updatePhotoInfo();
+bool photoInfoNextDue(unsigned long* due); // siguiente paso del scroll (tarea de render)
 void startAnimationDownloadIfNeeded();
-bool startAnimationPlaybackIfReady(); // true = hubo swap+fade (iteracion larga esperada)
+void startAnimationPlaybackIfReady();
 void updateAnimationPlayback();
-void checkAnimationDownloadTimeout();
+// Tras la ultima vuelta (la tarea de render solo para el reloj del video):
+// libera el buffer y pinta la foto pendiente. Desde el loop, con el panel tomado
+void finishAnimationPlayback();
+bool playbackNextDue(unsigned long* due); // millis() del siguiente frame; false sin video
+void updateAnimationDownload(); // ventana de pedidos de frames (anim_window.h)
+void giveUpStalledAnimationDownload(); // con el panel tomado: puede pintar
 bool animPrefetchDue();
 void stopPlayback();
 void resetAnimationDownloadState(bool freeBuffer);
@@ -0,0 +1,116 @@
+#include "pixel_kernels.h"
+
+// Las versiones SWAR leen/escriben palabras de 32 bits con memcpy (el origen
+// puede no estar alineado) y asumen little-endian, como el ESP32.
+
+const uint8_t pkBayer4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5}
+};
+
+static inline uint32_t load32(const void* p) {
+    uint32_t w;
+    memcpy(&w, p, 4);
+    return w;
+}
+
+static inline void store32(void* p, uint32_t w) {
+    memcpy(p, &w, 4);
+}
+
+// Intercambia los bytes de cada media palabra: dos pixeles big-endian -> nativos
+static inline uint32_t swapHalves(uint32_t w) {
+    return ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+}
+
+// ---- 888 -> 565 con gamma y dither ----
+
+void pkGbr888ToRow565Scalar(uint16_t* dst, const uint8_t* src, int n, int x, int y, const uint8_t* lut) {
+    for (int i = 0; i < n; i++, src += 3) {
+        dst[i] = pkDither565(lut[src[2]], lut[src[0]], lut[src[1]], x + i, y);
+    }
+}
+
+// Canales en carriles de 10 bits (r | g << 10 | b << 20): el umbral se suma a
+// los tres a la vez y el bit 8 de cada carril marca los que pasan de 255, que
+// se saturan restando (0x100 - 1) en ese carril sin tocar los demas
+#define LANE_OVERFLOW 0x10040100u
+
+void pkGbr888ToRow565Swar(uint16_t* dst, const uint8_t* src, int n, int x, int y, const uint8_t* lut) {
+    uint32_t thresholds[4];
+    for (int i = 0; i < 4; i++) {
+        uint32_t t = pkBayer4[y & 3][i];
+        thresholds[i] = (t >> 1) | ((t >> 2) << 10) | ((t >> 1) << 20);
+    }
+    for (int i = 0; i < n; i++, src += 3) {
+        uint32_t s = lut[src[2]] | ((uint32_t)lut[src[0]] << 10) | ((uint32_t)lut[src[1]] << 20);
+        s += thresholds[(x + i) & 3];
+        uint32_t ov = s & LANE_OVERFLOW;
+        s |= ov - (ov >> 8);
+        dst[i] = ((s & 0xF8) << 8) | ((s >> 7) & 0x7E0) | ((s >> 23) & 0x1F);
+    }
+}
+
+// ---- Copia de filas big-endian ----
+
+void pkBe565ToNativeScalar(uint16_t* dst, const uint8_t* src, int n) {
+    for (int i = 0; i < n; i++, src += 2) {
+        dst[i] = ((uint16_t)src[0] << 8) | src[1];
+    }
+}
+
+void pkBe565ToNativeSwar(uint16_t* dst, const uint8_t* src, int n) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        store32(dst + i, swapHalves(load32(src + i * 2)));
+    }
+    if (i < n) dst[i] = ((uint16_t)src[i * 2] << 8) | src[i * 2 + 1];
+}
+
+// ---- Reduccion 2x2 ----
+
+void pkDownscale2x565Scalar(uint8_t* dst, const uint8_t* src, int srcW, int srcH) {
+    for (int y = 0; y < srcH / 2; y++) {
+        for (int x = 0; x < srcW / 2; x++) {
+            uint16_t rSum = 0, gSum = 0, bSum = 0;
+            for (int dy = 0; dy < 2; dy++) {
+                const uint8_t* p = src + ((y * 2 + dy) * srcW + x * 2) * 2;
+                for (int dx = 0; dx < 2; dx++, p += 2) {
+                    uint16_t c = ((uint16_t)p[0] << 8) | p[1];
+                    rSum += c >> 11;
+                    gSum += (c >> 5) & 0x3F;
+                    bSum += c & 0x1F;
+                }
+            }
+            // Escala 888 en la que v << 3 (R/B) y v << 2 (G) son exactos
+            uint16_t c = pkDither565(rSum << 1, gSum, bSum << 1, x, y);
+            *dst++ = c >> 8;
+            *dst++ = c & 0xFF;
+        }
+    }
+}
+
+// Pixel 565 separado en carriles (g << 21 | r << 11 | b)
+#define SPREAD_MASK 0x07E0F81Fu
+
+// Suma de los dos pixeles de una palabra ya separados en carriles: la suma de
+// cuatro pixeles (max 124/252 por canal) sigue cabiendo en cada carril
+static inline uint32_t spreadPair(uint32_t w) {
+    return (w & SPREAD_MASK) + ((w >> 16) & 0xF81F) + ((w << 16) & 0x07E00000);
+}
+
+void pkDownscale2x565Swar(uint8_t* dst, const uint8_t* src, int srcW, int srcH) {
+    for (int y = 0; y < srcH / 2; y++) {
+        const uint8_t* row0 = src + y * 2 * srcW * 2;
+        const uint8_t* row1 = row0 + srcW * 2;
+        for (int x = 0; x < srcW / 2; x++) {
+            uint32_t s = spreadPair(swapHalves(load32(row0 + x * 4))) +
+                         spreadPair(swapHalves(load32(row1 + x * 4)));
+            uint16_t c = pkDither565(((s >> 11) & 0x3FF) << 1, s >> 21, (s & 0x7FF) << 1, x, y);
+            *dst++ = c >> 8;
+            *dst++ = c & 0xFF;
+        }
+    }
+}
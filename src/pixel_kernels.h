@@ -0,0 +1,67 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include <Arduino.h>
+
+// Kernels de pixel usados en caliente: conversion 888 -> 565 de fotos, copia
+// de filas big-endian del cable y reduccion 64 -> 32 de frames.
+// Cada uno tiene una version escalar de referencia (un canal cada vez) y una
+// SWAR que procesa los tres canales (o dos pixeles) en una palabra de 32 bits,
+// con carriles separados para que no haya acarreos entre ellos. Ambas dan el
+// mismo resultado bit a bit (lo comprueba el env test-kernels).
+//
+// Por defecto v2 usa las SWAR; -DPIXEL_KERNELS_SCALAR fuerza las escalares.
+#if defined(HW_V2) && !defined(PIXEL_KERNELS_SCALAR)
+#define PIXEL_KERNELS_SWAR
+#endif
+
+// Dither ordenado 4x4 (Bayer), umbrales 0..15
+extern const uint8_t pkBayer4[4][4];
+
+// Pixel 888 -> 565 con el umbral de (x, y). El umbral suma menos de un
+// escalon del canal (8 en R/B, 4 en G) antes de truncar, asi que un valor ya
+// representable en 565 sale intacto: las zonas planas no se ensucian.
+static inline uint16_t pkDither565(uint8_t r, uint8_t g, uint8_t b, int x, int y) {
+    uint8_t t = pkBayer4[y & 3][x & 3];
+    uint16_t r8 = r + (t >> 1);
+    uint16_t g8 = g + (t >> 2);
+    uint16_t b8 = b + (t >> 1);
+    if (r8 > 255) r8 = 255;
+    if (g8 > 255) g8 = 255;
+    if (b8 > 255) b8 = 255;
+    return ((r8 & 0xF8) << 8) | ((g8 & 0xFC) << 3) | (b8 >> 3);
+}
+
+// n pixeles GBR888 -> RGB565 nativo con gamma (lut) y dither; el primero cae
+// en (x, y) y el resto le siguen en la misma fila
+void pkGbr888ToRow565Scalar(uint16_t* dst, const uint8_t* src, int n, int x, int y, const uint8_t* lut);
+void pkGbr888ToRow565Swar(uint16_t* dst, const uint8_t* src, int n, int x, int y, const uint8_t* lut);
+
+// n pixeles RGB565 big-endian (covers, frames) -> RGB565 nativo
+void pkBe565ToNativeScalar(uint16_t* dst, const uint8_t* src, int n);
+void pkBe565ToNativeSwar(uint16_t* dst, const uint8_t* src, int n);
+
+// Imagen RGB565 big-endian srcW x srcH -> mitad de tamano, media de cada
+// bloque 2x2 con dither (la suma tiene 2 bits mas que el 565). Salida big-endian.
+void pkDownscale2x565Scalar(uint8_t* dst, const uint8_t* src, int srcW, int srcH);
+void pkDownscale2x565Swar(uint8_t* dst, const uint8_t* src, int srcW, int srcH);
+
+#ifdef PIXEL_KERNELS_SWAR
+#define PK_IMPL(name) name##Swar
+#else
+#define PK_IMPL(name) name##Scalar
+#endif
+
+static inline void pkGbr888ToRow565(uint16_t* dst, const uint8_t* src, int n, int x, int y, const uint8_t* lut) {
+    PK_IMPL(pkGbr888ToRow565)(dst, src, n, x, y, lut);
+}
+
+static inline void pkBe565ToNative(uint16_t* dst, const uint8_t* src, int n) {
+    PK_IMPL(pkBe565ToNative)(dst, src, n);
+}
+
+static inline void pkDownscale2x565(uint8_t* dst, const uint8_t* src, int srcW, int srcH) {
+    PK_IMPL(pkDownscale2x565)(dst, src, srcW, srcH);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include "globals.h"
+#include "render_task.h"
+#include "photos.h"
+#include "transition.h"
+#include <esp_timer.h>
+
+#define RENDER_IDLE_MS 100      // sin vencimientos: revisar igualmente
+#define RENDER_SLACK_US 200     // despertar ya dentro del millis() del vencimiento
+#define RENDER_DIAG_MS 10000
+
+static SemaphoreHandle_t renderMutex = nullptr;
+static TaskHandle_t renderTask = nullptr;
+static esp_timer_handle_t renderTimer = nullptr;
+volatile bool renderTaskRunning = false;
+
+// [Diag] retraso de cada frame de video sobre su hora, en ms:
+// <1, <2, <5, <10, <20, <50, >=50
+static const uint8_t LATE_BUCKET_MS[] = {1, 2, 5, 10, 20, 50};
+static uint32_t lateHist[sizeof(LATE_BUCKET_MS) + 1];
+static unsigned long lateWorstMs = 0;
+static uint32_t lockWaits = 0;          // ticks que esperaron a la logica (>1ms)
+static unsigned long lockWorstMs = 0;
+static unsigned long diagSince = 0;
+
+void renderLock() {
+    if (renderMutex) xSemaphoreTake(renderMutex, portMAX_DELAY);
+}
+
+void renderUnlock() {
+    panelPresent(); // con doble buffer: lo pintado por la logica sale ahora
+    if (renderMutex) xSemaphoreGive(renderMutex);
+}
+
+bool renderLockRelease() {
+    if (!renderMutex || xSemaphoreGetMutexHolder(renderMutex) != xTaskGetCurrentTaskHandle()) return false;
+    panelPresent();
+    xSemaphoreGive(renderMutex);
+    return true;
+}
+
+void renderLockRestore(bool held) {
+    if (held) renderLock();
+}
+
+void renderWake() {
+    if (renderTaskRunning) xTaskNotifyGive(renderTask);
+}
+
+static void renderTimerFired(void*) {
+    xTaskNotifyGive(renderTask);
+}
+
+// Vencimiento mas cercano (millis) de lo que pinta la tarea; false si nada
+static bool renderNextDue(unsigned long now, unsigned long* due) {
+    unsigned long next = now + RENDER_IDLE_MS;
+    bool any = false;
+    unsigned long d;
+    if (transitionNextDue(&d)) {
+        any = true;
+        if ((long)(d - next) < 0) next = d;
+    }
+    if (playbackNextDue(&d)) {
+        any = true;
+        if ((long)(d - next) < 0) next = d;
+    }
+    if (photoInfoNextDue(&d)) {
+        any = true;
+        if ((long)(d - next) < 0) next = d;
+    }
+    *due = next;
+    return any;
+}
+
+static void recordLateness(long lateUs) {
+    unsigned long ms = lateUs > 0 ? lateUs / 1000 : 0;
+    uint8_t b = 0;
+    while (b < sizeof(LATE_BUCKET_MS) && ms >= LATE_BUCKET_MS[b]) b++;
+    lateHist[b]++;
+    if (ms > lateWorstMs) lateWorstMs = ms;
+}
+
+static void reportJitter(unsigned long now) {
+    uint32_t frames = 0;
+    for (uint8_t b = 0; b <= sizeof(LATE_BUCKET_MS); b++) frames += lateHist[b];
+    if (frames > 0) {
+        LOGF("[Diag] Render: %u frames en %lus, retraso <1ms:%u <2:%u <5:%u <10:%u <20:%u <50:%u >=50:%u (peor %lums), %u esperas a la logica (peor %lums)",
+             (unsigned)frames, (now - diagSince) / 1000,
+             (unsigned)lateHist[0], (unsigned)lateHist[1], (unsigned)lateHist[2], (unsigned)lateHist[3],
+             (unsigned)lateHist[4], (unsigned)lateHist[5], (unsigned)lateHist[6],
+             lateWorstMs, (unsigned)lockWaits, lockWorstMs);
+    }
+    memset(lateHist, 0, sizeof(lateHist));
+    lateWorstMs = 0;
+    lockWaits = 0;
+    lockWorstMs = 0;
+    diagSince = now;
+}
+
+// Lo que loop() hacia en cada pasada, con sus mismas condiciones: con la
+// pantalla apagada, en modo dibujo o sin dueno no se pinta nada de esto
+static void renderTick() {
+    if (waitingForOwner || screenOff || drawingMode) return;
+
+    if (!animPlaying) updatePhotoInfo();
+    updateTransition();
+
+    bool playing = animPlaying;
+    unsigned long lastFrame = animLastFrameTime;
+    updateAnimationPlayback();
+    if (playing && animPlaying && animLastFrameTime != lastFrame) {
+        // millis() es esp_timer_get_time()/1000: mismo reloj que el vencimiento
+        recordLateness((long)(esp_timer_get_time() - (int64_t)(lastFrame + playFrameInterval) * 1000));
+    }
+}
+
+static void renderTaskLoop(void*) {
+    bool lastImmediate = false;
+    for (;;) {
+        int64_t nowUs = esp_timer_get_time();
+        unsigned long now = nowUs / 1000;
+        unsigned long due;
+        bool any = renderNextDue(now, &due);
+        long ahead = (long)(due - now);
+
+        if (ahead > 0) {
+            if (any) {
+                esp_timer_start_once(renderTimer, (uint64_t)ahead * 1000 - nowUs % 1000 + RENDER_SLACK_US);
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RENDER_IDLE_MS));
+            esp_timer_stop(renderTimer); // si desperto antes (renderWake)
+            lastImmediate = false;
+        } else if (lastImmediate) {
+            // Dos vencimientos seguidos ya pasados: ceder un tick para que
+            // loop() (menos prioridad, mismo core) no se quede sin CPU
+            ulTaskNotifyTake(pdTRUE, 1);
+            lastImmediate = false;
+        } else {
+            lastImmediate = true;
+        }
+
+        unsigned long t0 = millis();
+        xSemaphoreTake(renderMutex, portMAX_DELAY);
+        unsigned long waited = millis() - t0;
+        if (waited > 1) {
+            lockWaits++;
+            if (waited > lockWorstMs) lockWorstMs = waited;
+        }
+        renderTick();
+        panelPresent(); // el scroll del titulo no abre frame
+        if (millis() - diagSince >= RENDER_DIAG_MS) reportJitter(millis());
+        xSemaphoreGive(renderMutex);
+    }
+}
+
+void startRenderTask() {
+    if (renderTaskRunning) return;
+    renderMutex = xSemaphoreCreateMutex();
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = renderTimerFired;
+    timerArgs.name = "render";
+    if (!renderMutex || esp_timer_create(&timerArgs, &renderTimer) != ESP_OK) {
+        LOG("[Render] ERROR creando mutex/timer - el loop sigue pintando");
+        renderMutex = nullptr;
+        return;
+    }
+    // Prio 2: por encima de loop() (1) en el mismo core, asi un frame vencido
+    // se pinta en cuanto la logica suelta el panel
+    BaseType_t ok = xTaskCreatePinnedToCore(renderTaskLoop, "render", 8192, nullptr, 2, &renderTask, 1);
+    if (ok != pdPASS) {
+        LOG("[Render] ERROR creando la tarea - el loop sigue pintando");
+        renderMutex = nullptr;
+        return;
+    }
+    diagSince = millis();
+    renderTaskRunning = true;
+    LOG("[Render] Tarea de render arrancada en core 1");
+}
@@ -0,0 +1,41 @@
+#ifndef RENDER_TASK_H
+#define RENDER_TASK_H
+
+#include <Arduino.h>
+
+// Tarea de render en core 1, con mas prioridad que loop(): avanza el video, las
+// transiciones y el scroll del titulo a su hora. Un esp_timer de un disparo la
+// despierta en el siguiente vencimiento (frame de video o paso de transicion);
+// sin nada pendiente duerme hasta RENDER_IDLE_MS o hasta renderWake().
+//
+// El panel y el estado de reproduccion tienen un unico dueno cada vez: la
+// tarea de render o la logica. loop() lo toma solo para la parte de su
+// iteracion que pinta o arranca algo (fotos, portadas, overlays, el swap de
+// video) y lo suelta en sus esperas (mqttRequestWait, la carga de un video).
+// Lo que no pinta (pedir frames, guardar en flash, los chequeos de [Diag])
+// corre con el panel suelto, asi el render no espera a la flash ni a la red.
+//
+// El estado de descarga (animBuffer, currentAnimationId, la ventana) es solo
+// de la logica, y de la tarea de red bajo animBufLock: el render nunca lo
+// cambia. Cuando un video acaba sus vueltas el render solo para su reloj y la
+// logica libera el buffer (finishAnimationPlayback).
+//
+// Si la tarea no se puede crear, loop() sigue pintando como antes.
+
+extern volatile bool renderTaskRunning;
+
+void startRenderTask();
+
+// Iteracion de la logica (loop): el render espera hasta renderUnlock()
+void renderLock();
+void renderUnlock();
+
+// Espera bloqueante con el panel tomado: lo suelta mientras tanto si esta
+// tarea lo tenia (devuelve si lo tenia, para renderLockRestore)
+bool renderLockRelease();
+void renderLockRestore(bool held);
+
+// Hay trabajo nuevo (p.ej. una transicion): no esperar al siguiente vencimiento
+void renderWake();
+
+#endif
@@ -0,0 +1,142 @@
+#include <Arduino.h>
+#include "frame_slab.h"
+
+// Estres del slab de buffers de animacion en v2: secuencias aleatorias de
+// reservar (descarga), pasar a reproduccion (swap), abandonar y liberar, desde
+// los dos cores a la vez, comprobando que dos buffers vivos nunca se pisan y
+// que los bloques vuelven todos al final. Cada core tiene a la vez como mucho
+// una descarga y una reproduccion: con ANIM_SLAB_BLOCKS=4 solo fallan los
+// pedidos mayores que un bloque (si falla otro, se ha perdido un bloque).
+// Compara tambien el coste con ps_malloc/free: pio run -e test-slab -t upload
+
+#define TEST_LOG(fmt, ...) Serial.printf("[%lu] " fmt "\n", millis(), ##__VA_ARGS__); Serial.flush()
+
+#define ROUNDS 20000
+#define BENCH_ITERS 1000
+
+struct Owner {
+    uint8_t* buf;
+    size_t bytes;
+    uint8_t tag;
+};
+
+static volatile uint32_t fails = 0;
+static volatile bool otherDone = false;
+static volatile uint32_t oversized = 0; // pedidos que no caben en un bloque: fallan
+static portMUX_TYPE countMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Los contadores los suben los dos cores a la vez: ++ suelto pierde cuentas
+static void count(volatile uint32_t& counter) {
+    portENTER_CRITICAL(&countMux);
+    counter++;
+    portEXIT_CRITICAL(&countMux);
+}
+
+// Marca principio y final del buffer: si otro dueno escribe encima se ve al soltarlo
+static void stamp(Owner& o) {
+    o.buf[0] = o.tag;
+    o.buf[o.bytes - 1] = o.tag ^ 0xFF;
+}
+
+static bool intact(const Owner& o) {
+    return o.buf[0] == o.tag && o.buf[o.bytes - 1] == (uint8_t)(o.tag ^ 0xFF);
+}
+
+static size_t randomSize() {
+    // Casi siempre una animacion que cabe en el bloque; a veces una que no
+    uint32_t r = esp_random();
+    if (r % 50 == 0) {
+        count(oversized);
+        return FRAME_SLAB_BLOCK + 1 + r % 4096;
+    }
+    return 8192 + r % (FRAME_SLAB_BLOCK - 8192 + 1);
+}
+
+static void release(Owner& o) {
+    if (!o.buf) return;
+    if (!intact(o)) count(fails);
+    frameSlabFree(o.buf);
+    o.buf = nullptr;
+}
+
+static bool acquire(Owner& o, uint8_t tag) {
+    o.bytes = randomSize();
+    o.buf = frameSlabAlloc(o.bytes);
+    if (!o.buf) return false;
+    o.tag = tag;
+    stamp(o);
+    return true;
+}
+
+// Un ciclo de vida de animacion: descarga, quizas abandonada, quizas swap
+static void lifecycle(Owner& download, Owner& play, uint8_t tag) {
+    release(download); // la descarga anterior seguia viva: llega otra animacion
+    if (!acquire(download, tag)) return;
+    switch (esp_random() % 4) {
+    case 0: // descarga abandonada (nueva foto, timeout)
+        release(download);
+        break;
+    case 1: // stopPlayback con la descarga viva
+        release(play);
+        break;
+    default: // swap: la reproduccion anterior se libera y el bloque cambia de dueno
+        release(play);
+        if (!intact(download)) count(fails);
+        play = download;
+        download.buf = nullptr;
+        break;
+    }
+}
+
+static void otherCoreTask(void*) {
+    Owner download = {}, play = {};
+    for (int i = 0; i < ROUNDS; i++) lifecycle(download, play, 0x80 | (i & 0x7F));
+    release(download);
+    release(play);
+    otherDone = true;
+    vTaskDelete(nullptr);
+}
+
+static uint32_t benchCycles(uint8_t* (*alloc)(size_t), void (*drop)(uint8_t*)) {
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < BENCH_ITERS; i++) drop(alloc(FRAME_SLAB_BLOCK - 4096));
+    return (ESP.getCycleCount() - start) / BENCH_ITERS;
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(3000);
+
+    TEST_LOG("==== SLAB TEST ====");
+    hasPsram = psramFound();
+    if (!hasPsram) {
+        TEST_LOG("Sin PSRAM: el slab no se usa");
+        return;
+    }
+    frameSlabInit();
+    uint8_t blocks = frameSlabFreeBlocks();
+    TEST_LOG("Bloques: %d de %d bytes", blocks, FRAME_SLAB_BLOCK);
+
+    // Core 0 y core 1 a la vez, como la tarea de red y el loop
+    xTaskCreatePinnedToCore(otherCoreTask, "slabTest", 4096, nullptr, 1, nullptr, 0);
+    Owner download = {}, play = {};
+    for (int i = 0; i < ROUNDS; i++) lifecycle(download, play, i & 0x7F);
+    release(download);
+    release(play);
+    while (!otherDone) delay(10);
+
+    bool allBack = frameSlabFreeBlocks() == blocks;
+    bool noLeaks = frameSlabFailures() == oversized;
+    TEST_LOG("Estres: %s (%u buffers pisados, bloques devueltos: %s, %u prestados, %u fallidos de %u grandes)",
+             fails == 0 && allBack && noLeaks ? "OK" : "FALLO", (unsigned)fails, allBack ? "si" : "NO",
+             (unsigned)frameSlabHandouts(), (unsigned)frameSlabFailures(), (unsigned)oversized);
+
+    uint32_t slab = benchCycles(frameSlabAlloc, frameSlabFree);
+    uint32_t heap = benchCycles([](size_t n) { return (uint8_t*)ps_malloc(n); }, [](uint8_t* p) { free(p); });
+    TEST_LOG("alloc+free: slab %6u ciclos, ps_malloc %6u ciclos", (unsigned)slab, (unsigned)heap);
+    TEST_LOG("==== FIN ====");
+}
+
+void loop() {
+    delay(1000);
+}
@@ -1,8 +1,10 @@
 #include "spotify.h"
 #include "net_task.h"
 #include "display.h"
+#include "transition.h"
 #include "clock.h"
 #include "mqtt_handlers.h"
+#include "mqtt_request.h"
 
 String fetchSongId()
 {
@@ -10,14 +12,14 @@ String fetchSongId()
 
     // Publicar request via MQTT
     String topic = String("frame/") + String(frameId) + "/request/song";
-    armMqttResponseWait();
-    if (!netPublish(topic.c_str(), "{}")) {
+    uint32_t req = mqttRequest(RESP_SONG, topic.c_str(), "{}", 5000);
+    if (!req) {
         LOG("[Spotify:fetchSongId] Error publicando request MQTT");
         return "";
     }
 
     // Esperar respuesta
-    if (waitForMqttResponse(RESP_SONG, 5000)) {
+    if (mqttRequestWait(req)) {
         // Solo log si es una canción diferente
         if (songIdBuffer[0] != '\0' && songShowing != String(songIdBuffer)) {
             LOGF("Nueva canción: %s", songIdBuffer);
@@ -28,9 +30,47 @@ String fetchSongId()
     return "";
 }
 
+// Sondeo sin bloquear (loop): el video y el scroll siguen mientras llega
+static uint32_t songRequest = 0;
+
+bool requestSongId()
+{
+    if (songRequest) return true;
+    songIdBuffer[0] = '\0';
+    String topic = String("frame/") + String(frameId) + "/request/song";
+    songRequest = mqttRequest(RESP_SONG, topic.c_str(), "{}", 5000);
+    return songRequest != 0;
+}
+
+bool pollSongId(String& song)
+{
+    if (!songRequest) return false;
+    uint8_t state = mqttRequestPoll(songRequest);
+    if (state == REQ_PENDING) return false;
+    songRequest = 0;
+    song = state == REQ_OK ? String(songIdBuffer) : String("");
+    if (song != "" && songShowing != song) {
+        LOGF("Nueva canción: %s", songIdBuffer);
+    }
+    return true;
+}
+
+static void coverPushUpDone()
+{
+    LOG("[Spotify] Animation done");
+
+    // Limpiar el texto del título de la foto anterior
+    titleNeedsScroll = false;
+    currentTitle = "";
+    currentName = "";
+    loadingMsg = "";
+    showClockOverlay();
+}
+
 void fetchAndDrawCover()
 {
     lastPhotoChange = millis();
+    transitionCancel(); // el push-up (o showTime) pisa toda la pantalla
 
     LOG("[Spotify] Fetching cover via MQTT...");
     esp_task_wdt_reset();
@@ -38,8 +78,8 @@ void fetchAndDrawCover()
     // Publicar request via MQTT
     String topic = String("frame/") + String(frameId) + "/request/cover";
     String payload = "{\"songId\":\"" + songShowing + "\"}";
-    armMqttResponseWait();
-    if (!netPublish(topic.c_str(), payload.c_str())) {
+    uint32_t req = mqttRequest(RESP_COVER, topic.c_str(), payload.c_str(), 15000);
+    if (!req) {
         LOG("[Spotify] Error publicando request MQTT");
         showTime();
         LOG("[Spotify] Done");
@@ -47,43 +87,14 @@ void fetchAndDrawCover()
     }
 
     // Esperar respuesta
-    if (waitForMqttResponse(RESP_COVER, 15000)) {
+    if (mqttRequestWait(req)) {
         esp_task_wdt_reset();
 
         LOG("[Spotify] Animation start");
-        // Mostrar la imagen con animación push up
-        for (int y = 0; y < 64; y++)
-        {
-            // Mover todas las líneas existentes hacia arriba
-            for (int moveY = 0; moveY < 63; moveY++)
-            {
-                for (int x = 0; x < 64; x++)
-                {
-                    uint16_t color = screenBuffer[moveY + 1][x];
-                    drawPixelWithBuffer(x, moveY, color);
-                    screenBuffer[moveY][x] = color;
-                }
-            }
-
-            // Dibujar la nueva línea en la parte inferior (línea 63)
-            for (int x = 0; x < 64; x++)
-            {
-                int bufferIdx = (y * 64 + x) * 2;
-                uint16_t color = (spotifyCoverBuffer[bufferIdx] << 8) | spotifyCoverBuffer[bufferIdx + 1];
-                drawPixelWithBuffer(x, 63, color);
-                screenBuffer[63][x] = color;
-            }
-
-            wait(15);
-        }
-        LOG("[Spotify] Animation done");
-
-        // Limpiar el texto del título de la foto anterior
+        // Push-up no bloqueante: avanza con updateTransition() (tarea de render).
+        // El scroll del título anterior no debe pintar encima mientras tanto
         titleNeedsScroll = false;
-        currentTitle = "";
-        currentName = "";
-        loadingMsg = "";
-        showClockOverlay();
+        transitionStartPushUp(spotifyCoverBuffer, coverPushUpDone);
     }
     else
     {
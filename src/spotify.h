@@ -4,6 +4,10 @@
 #include "globals.h"
 
 String fetchSongId();
+// Version sin bloquear de fetchSongId: requestSongId publica (si no hay otra
+// en vuelo) y pollSongId devuelve true cuando hay resultado en song
+bool requestSongId();
+bool pollSongId(String& song);
 void fetchAndDrawCover();
 
 #endif
@@ -0,0 +1,34 @@
+#include "text_strip.h"
+#include <Fonts/Picopixel.h>
+
+void textStripRender(TextStrip &strip, const String &text) {
+    GFXcanvas1 &c = strip.canvas;
+    c.fillScreen(0);
+    strip.x1 = strip.y1 = 0;
+    strip.w = strip.h = 0;
+    if (text.length() == 0) return;
+    // El canvas reserva su bitmap en el constructor, en la inicializacion
+    // estatica: si ese malloc fallo la strip se queda vacia (sin texto)
+    if (!c.getBuffer()) {
+        LOG("[Text] Sin memoria para el bitmap de texto: overlay sin texto");
+        return;
+    }
+
+    c.setFont(&Picopixel);
+    c.setTextSize(1);
+    c.setTextWrap(false);
+    c.setTextColor(1);
+    c.getTextBounds(text, 0, 0, &strip.x1, &strip.y1, &strip.w, &strip.h);
+    c.setCursor(-strip.x1, -strip.y1);
+    c.print(text);
+
+    if (strip.w > TEXT_STRIP_MAX_W) strip.w = TEXT_STRIP_MAX_W;
+    if (strip.h > TEXT_STRIP_MAX_H) strip.h = TEXT_STRIP_MAX_H;
+}
+
+bool textStripGet(const TextStrip &strip, int sx, int sy) {
+    if (sx < 0 || sy < 0 || sx >= strip.w || sy >= strip.h) return false;
+    const uint8_t *buf = strip.canvas.getBuffer();
+    const int rowBytes = (TEXT_STRIP_MAX_W + 7) / 8;
+    return buf[sy * rowBytes + (sx >> 3)] & (0x80 >> (sx & 7));
+}
@@ -0,0 +1,31 @@
+#ifndef TEXT_STRIP_H
+#define TEXT_STRIP_H
+
+#include "globals.h"
+#include <Adafruit_GFX.h>
+
+// Texto pre-rasterizado en Picopixel: se pinta una vez en un bitmap de 1 bit
+// (con sus bounds cacheados) y despues el compositor lo lee pixel a pixel, sin
+// recorrer glifos ni reservar memoria. Para titulo/autor de la foto (cuyo
+// scroll pasa a ser una ventana desplazable pixel a pixel), reloj y badge Dev.
+
+// 63 caracteres (photoTitle/photoAuthor) x 6px de avance maximo en Picopixel
+#define TEXT_STRIP_MAX_W 384
+#define TEXT_STRIP_MAX_H 8
+
+struct TextStrip {
+    GFXcanvas1 canvas;
+    int16_t x1, y1;   // esquina sup. izq. de los bounds respecto al cursor
+    uint16_t w, h;    // bounds del texto (0x0 si esta vacio)
+
+    TextStrip() : canvas(TEXT_STRIP_MAX_W, TEXT_STRIP_MAX_H), x1(0), y1(0), w(0), h(0) {}
+};
+
+// Rasteriza text en la strip (bounds en (0,0) del canvas) y cachea sus bounds.
+// Sin bitmap (malloc fallido al construirla) la strip queda vacia, 0x0
+void textStripRender(TextStrip &strip, const String &text);
+
+// Pixel (sx, sy) de la strip, relativo a la esquina de sus bounds
+bool textStripGet(const TextStrip &strip, int sx, int sy);
+
+#endif
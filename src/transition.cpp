@@ -0,0 +1,242 @@
+#include "transition.h"
+#include "display.h"
+#include "blit.h"
+#include "compositor.h"
+#include "pixel_kernels.h"
+#include "render_task.h"
+
+// Maximo de pixeles pintados por tick: acota lo que una transicion roba a la
+// iteracion del loop (un paso de fundido o push-up, 4096 px, se reparte en dos)
+#define TRANSITION_PIXEL_BUDGET 2048
+
+// Fundido: por paso se construyen tablas de escala de 32/64 entradas para los
+// canales de 5/6 bits, asi que por pixel solo quedan tres lookups (cero
+// divisiones). El resultado es identico al del calculo en 888 + color565().
+#define FADE_STEPS 20
+#define FADE_STEP_MS 30
+
+#define PUSH_UP_STEP_MS 15
+
+// Revelado desde el centro: 5 colores x 32 cuadrados (lado 2..64) y despues
+// 65 anillos (radio 0..64) con la foto
+#define REVEAL_COLORS 5
+#define REVEAL_SIZES 32
+#define REVEAL_SQUARE_STEPS (REVEAL_COLORS * REVEAL_SIZES)
+#define REVEAL_RING_STEPS 65
+#define REVEAL_STEP_MS 5
+#define REVEAL_CENTER 32
+
+enum TransitionKind : uint8_t { TRANS_NONE, TRANS_FADE, TRANS_PUSH_UP, TRANS_CENTER_REVEAL };
+
+struct Transition {
+    TransitionKind kind;
+    uint16_t step;           // paso actual del efecto
+    uint16_t stepCount;
+    uint8_t row;             // siguiente fila a pintar del paso actual
+    uint8_t rowEnd;          // ultima fila (exclusiva) del paso actual
+    bool stepOpen;           // paso a medias (se quedo sin presupuesto)
+    uint16_t stepMs;         // pausa entre pasos
+    unsigned long lastStep;
+    bool rising;             // fundido: true = desde negro
+    const uint8_t* src;      // push-up: portada entrante
+    TransitionDoneFn onDone;
+};
+
+static Transition trans = {};
+static uint8_t fadeLut5[32];
+static uint8_t fadeLut6[64];
+
+static void buildFadeLuts(int level) {
+    for (int v = 0; v < 32; v++) {
+        fadeLut5[v] = (((v << 3) * level) / FADE_STEPS) >> 3;
+    }
+    for (int v = 0; v < 64; v++) {
+        fadeLut6[v] = (((v << 2) * level) / FADE_STEPS) >> 2;
+    }
+}
+
+static void beginTransition(TransitionKind kind, uint16_t stepCount, uint16_t stepMs, TransitionDoneFn onDone) {
+    // Repinta toda la pantalla: los overlays se vuelven a poner al acabar
+    compositorReset();
+    trans.kind = kind;
+    trans.step = 0;
+    trans.stepCount = stepCount;
+    trans.stepOpen = false;
+    trans.stepMs = stepMs;
+    trans.lastStep = millis() - stepMs; // el primer paso sale en el siguiente tick
+    trans.onDone = onDone;
+    renderWake();
+}
+
+void transitionStartFade(bool fadeIn, TransitionDoneFn onDone) {
+    uint16_t step = 0;
+    if (trans.kind == TRANS_FADE) {
+        // Relanzar un fundido a medias: seguir desde el nivel actual (invertido
+        // si cambia de sentido) para que no haya salto de brillo
+        step = trans.rising == fadeIn ? trans.step : FADE_STEPS - trans.step;
+    }
+    beginTransition(TRANS_FADE, FADE_STEPS + 1, FADE_STEP_MS, onDone);
+    trans.step = step;
+    trans.rising = fadeIn;
+}
+
+void transitionStartPushUp(const uint8_t* cover, TransitionDoneFn onDone) {
+    beginTransition(TRANS_PUSH_UP, PANEL_RES_Y, PUSH_UP_STEP_MS, onDone);
+    trans.src = cover;
+}
+
+void transitionStartCenterReveal(TransitionDoneFn onDone) {
+    beginTransition(TRANS_CENTER_REVEAL, REVEAL_SQUARE_STEPS + REVEAL_RING_STEPS, REVEAL_STEP_MS, onDone);
+}
+
+void transitionCancel() {
+    trans.kind = TRANS_NONE;
+    trans.onDone = nullptr;
+}
+
+bool transitionActive() {
+    return trans.kind != TRANS_NONE;
+}
+
+// ---- Pasos de cada efecto ----
+
+static void openStep() {
+    trans.row = 0;
+    trans.rowEnd = PANEL_RES_Y;
+    switch (trans.kind) {
+        case TRANS_FADE:
+            buildFadeLuts(trans.rising ? trans.step : FADE_STEPS - trans.step);
+            break;
+        case TRANS_CENTER_REVEAL: {
+            // Solo las filas que toca el anillo de este paso
+            int half = trans.step < REVEAL_SQUARE_STEPS ? 1 + trans.step % REVEAL_SIZES
+                                                        : trans.step - REVEAL_SQUARE_STEPS;
+            trans.row = max(0, REVEAL_CENTER - half);
+            trans.rowEnd = min(PANEL_RES_Y, REVEAL_CENTER + half + 1);
+            break;
+        }
+        default:
+            break;
+    }
+    trans.stepOpen = true;
+}
+
+// Pinta la fila y del paso actual; devuelve los pixeles pintados
+static int drawStepRow(int y) {
+    uint16_t row[PANEL_RES_X];
+
+    switch (trans.kind) {
+        case TRANS_FADE:
+            for (int x = 0; x < PANEL_RES_X; x++) {
+                uint16_t c = screenBuffer[y][x];
+                row[x] = (fadeLut5[c >> 11] << 11) | (fadeLut6[(c >> 5) & 0x3F] << 5) | fadeLut5[c & 0x1F];
+            }
+            blitRow565(y, 0, PANEL_RES_X, row);
+            return PANEL_RES_X;
+
+        case TRANS_PUSH_UP: {
+            // Tras k pasos: arriba la pantalla anterior desplazada k filas y
+            // debajo las k primeras filas de la portada. screenBuffer conserva la
+            // pantalla anterior hasta el final (la version bloqueante la iba
+            // desplazando en el sitio, lo que no se puede partir entre ticks).
+            int shift = trans.step + 1;
+            if (y < PANEL_RES_Y - shift) {
+                blitRow565(y, 0, PANEL_RES_X, screenBuffer[y + shift]);
+            } else {
+                pkBe565ToNative(row, trans.src + (y - (PANEL_RES_Y - shift)) * PANEL_RES_X * 2, PANEL_RES_X);
+                blitRow565(y, 0, PANEL_RES_X, row);
+            }
+            return PANEL_RES_X;
+        }
+
+        case TRANS_CENTER_REVEAL: {
+            bool square = trans.step < REVEAL_SQUARE_STEPS;
+            int half = square ? 1 + trans.step % REVEAL_SIZES : trans.step - REVEAL_SQUARE_STEPS;
+            // Cuadrado de color: el primero de cada color se rellena entero; los
+            // siguientes solo necesitan el anillo nuevo (el interior ya tiene ese color)
+            bool filled = square && trans.step % REVEAL_SIZES == 0;
+            uint16_t colors[REVEAL_COLORS] = {color1, color2, color3, color4, color5};
+            uint16_t color = square ? colors[trans.step / REVEAL_SIZES] : 0;
+
+            int x0 = max(0, REVEAL_CENTER - half);
+            int x1 = min(PANEL_RES_X - 1, REVEAL_CENTER + half);
+            if (filled || abs(y - REVEAL_CENTER) == half) {
+                for (int x = x0; x <= x1; x++) {
+                    screenBuffer[y][x] = square ? color : photo565[y][x];
+                }
+                blitRow565(y, x0, x1 - x0 + 1, screenBuffer[y]);
+                return x1 - x0 + 1;
+            }
+            int painted = 0;
+            if (REVEAL_CENTER - half >= 0) {
+                drawPixelWithBuffer(x0, y, square ? color : photo565[y][x0]);
+                painted++;
+            }
+            if (REVEAL_CENTER + half < PANEL_RES_X) {
+                drawPixelWithBuffer(x1, y, square ? color : photo565[y][x1]);
+                painted++;
+            }
+            return painted;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+static void finishTransition() {
+    if (trans.kind == TRANS_PUSH_UP) {
+        // La pantalla ya muestra la portada entera: dejarla tambien en screenBuffer
+        pkBe565ToNative(&screenBuffer[0][0], trans.src, PANEL_RES_X * PANEL_RES_Y);
+    }
+    TransitionDoneFn done = trans.onDone;
+    transitionCancel();
+    if (done) done(); // puede encadenar otra transicion
+}
+
+static void runTransitionTick(unsigned long now) {
+    int budget = TRANSITION_PIXEL_BUDGET;
+    while (budget > 0) {
+        if (!trans.stepOpen) {
+            if (trans.step >= trans.stepCount) {
+                finishTransition();
+                return;
+            }
+            // Entre pasos se respeta la pausa del efecto: el siguiente sale en
+            // otro tick aunque sobre presupuesto
+            if (trans.step > 0 && budget < TRANSITION_PIXEL_BUDGET) return;
+            openStep();
+        }
+        while (trans.row < trans.rowEnd && budget > 0) {
+            budget -= drawStepRow(trans.row);
+            trans.row++;
+        }
+        if (trans.row >= trans.rowEnd) {
+            trans.stepOpen = false;
+            trans.step++;
+            trans.lastStep = now;
+            if (trans.step >= trans.stepCount) {
+                finishTransition();
+                return;
+            }
+        }
+    }
+}
+
+bool transitionNextDue(unsigned long* due) {
+    if (trans.kind == TRANS_NONE) return false;
+    *due = trans.stepOpen ? millis() : trans.lastStep + trans.stepMs;
+    return true;
+}
+
+void updateTransition() {
+    if (trans.kind == TRANS_NONE) return;
+
+    unsigned long now = millis();
+    if (!trans.stepOpen && now - trans.lastStep < trans.stepMs) return;
+
+    // Con doble buffer, lo pintado en este tick sale de golpe con un flip
+    panelBeginFrame();
+    runTransitionTick(now);
+    panelPresent();
+}
@@ -0,0 +1,28 @@
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include "globals.h"
+
+// Transiciones de pantalla cooperativas: cada efecto es un estado reanudable
+// que la tarea de render (o loop() sin ella) avanza con updateTransition(),
+// con un presupuesto de pixeles por
+// tick, en vez de un bucle con delay() que congela el core 1. Solo hay una
+// transicion activa; empezar otra sustituye a la anterior (sin su onDone).
+// El framebuffer final es el mismo que dejaban las versiones bloqueantes.
+
+typedef void (*TransitionDoneFn)();
+
+// Fundido de screenBuffer a negro (fadeIn=false) o desde negro (true)
+void transitionStartFade(bool fadeIn, TransitionDoneFn onDone);
+// Push-up de la portada (64x64 RGB565 big-endian) sobre lo que hay en pantalla
+void transitionStartPushUp(const uint8_t* cover, TransitionDoneFn onDone);
+// Barridos de colores desde el centro y revelado de photo565 por anillos
+void transitionStartCenterReveal(TransitionDoneFn onDone);
+
+void transitionCancel();
+bool transitionActive();
+void updateTransition();
+// millis() del siguiente paso (ya vencido si el paso quedo a medias); false sin transicion
+bool transitionNextDue(unsigned long* due);
+
+#endif
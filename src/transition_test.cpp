@@ -0,0 +1,229 @@
+#include <Arduino.h>
+#include <rom/crc.h>
+#include "transition.h"
+
+// Comprueba que las transiciones cooperativas (transition.h) pasan por los
+// mismos pasos intermedios que los bucles bloqueantes de antes (push-up de la
+// portada, revelado desde el centro y fundidos) y dejan el mismo screenBuffer,
+// partiendo de contenido aleatorio. El panel no se arranca: una subclase
+// guarda lo que se pinta en una copia en RAM: pio run -e test-transition -t upload
+
+#define TEST_LOG(fmt, ...) Serial.printf("[%lu] " fmt "\n", millis(), ##__VA_ARGS__); Serial.flush()
+
+#define TRIALS 5
+#define MAX_STEPS 256 // el revelado tiene 160 + 65
+
+// Lo que se ve en el panel: cada primitiva que usan blit.cpp y transition.cpp
+static uint16_t panel[PANEL_RES_Y][PANEL_RES_X];
+
+class CapturePanel : public MatrixPanel_I2S_DMA {
+public:
+    CapturePanel(const HUB75_I2S_CFG &cfg) : MatrixPanel_I2S_DMA(cfg) {}
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x >= 0 && x < PANEL_RES_X && y >= 0 && y < PANEL_RES_Y) panel[y][x] = color;
+    }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override {
+        for (int row = y; row < y + h; row++) {
+            for (int col = x; col < x + w; col++) drawPixel(col, row, color);
+        }
+    }
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override { fillRect(x, y, w, 1, color); }
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override { fillRect(x, y, 1, h, color); }
+    void fillScreen(uint16_t color) override { fillRect(0, 0, PANEL_RES_X, PANEL_RES_Y, color); }
+};
+
+// display.cpp, compositor.cpp y render_task.cpp no entran en este env
+void drawPixelWithBuffer(int x, int y, uint16_t color) {
+    dma_display->drawPixel(x, y, color);
+    screenBuffer[y][x] = color;
+}
+void compositorReset() {}
+void renderWake() {}
+
+static uint8_t cover[PANEL_RES_X * PANEL_RES_Y * 2]; // RGB565 big-endian
+static uint16_t startScreen[PANEL_RES_Y][PANEL_RES_X];
+static uint16_t refScreen[PANEL_RES_Y][PANEL_RES_X];
+static uint32_t refSteps[MAX_STEPS]; // CRC del panel al acabar cada paso
+static int refStepCount = 0;
+static bool transitionDone = false;
+
+static uint32_t panelCrc() {
+    return crc32_le(0, (const uint8_t*)panel, sizeof(panel));
+}
+
+// Fin de un paso de la version bloqueante (donde estaba su delay())
+static void stepDone() {
+    if (refStepCount < MAX_STEPS) refSteps[refStepCount] = panelCrc();
+    refStepCount++;
+}
+
+static void onTransitionDone() {
+    transitionDone = true;
+}
+
+// ---- Versiones bloqueantes de antes, con stepDone() en lugar de los delay() ----
+
+static void blockingPushUp() {
+    for (int y = 0; y < 64; y++) {
+        for (int moveY = 0; moveY < 63; moveY++) {
+            for (int x = 0; x < 64; x++) {
+                uint16_t color = screenBuffer[moveY + 1][x];
+                drawPixelWithBuffer(x, moveY, color);
+                screenBuffer[moveY][x] = color;
+            }
+        }
+        for (int x = 0; x < 64; x++) {
+            int bufferIdx = (y * 64 + x) * 2;
+            uint16_t color = (cover[bufferIdx] << 8) | cover[bufferIdx + 1];
+            drawPixelWithBuffer(x, 63, color);
+            screenBuffer[63][x] = color;
+        }
+        stepDone();
+    }
+}
+
+// La foto sale de photo565 (antes de photoBuffer en 888 con color565: la
+// misma conversion que ahora se hace al recibirla)
+static void blockingCenterReveal() {
+    const int width = 64;
+    const int height = 64;
+    int centerX = 32;
+    int centerY = 32;
+    uint16_t colors[] = {color1, color2, color3, color4, color5};
+    int numColors = 5;
+
+    for (int colorIndex = 0; colorIndex < numColors; colorIndex++) {
+        for (int size = 2; size <= max(PANEL_RES_X, PANEL_RES_Y); size += 2) {
+            for (int y = centerY - size / 2; y <= centerY + size / 2; y++) {
+                for (int x = centerX - size / 2; x <= centerX + size / 2; x++) {
+                    if (x >= 0 && x < PANEL_RES_X && y >= 0 && y < PANEL_RES_Y) {
+                        drawPixelWithBuffer(x, y, colors[colorIndex]);
+                    }
+                }
+            }
+            stepDone();
+        }
+    }
+    for (int radius = 0; radius <= max(width, height); radius++) {
+        for (int y = centerY - radius; y <= centerY + radius; y++) {
+            for (int x = centerX - radius; x <= centerX + radius; x++) {
+                if (x >= 0 && x < width && y >= 0 && y < height) {
+                    if (abs(x - centerX) == radius || abs(y - centerY) == radius) {
+                        drawPixelWithBuffer(x, y, photo565[y][x]);
+                    }
+                }
+            }
+        }
+        stepDone();
+    }
+}
+
+// fadeOut()/fadeIn() originales: cada pixel a 888, escalado por n/20 y de
+// vuelta con color565()
+static void blockingFade(bool fadeIn) {
+    const int steps = 20;
+    for (int step = 0; step <= steps; step++) {
+        int level = fadeIn ? step : steps - step;
+        for (int y = 0; y < PANEL_RES_Y; y++) {
+            for (int x = 0; x < PANEL_RES_X; x++) {
+                uint16_t color = screenBuffer[y][x];
+                uint8_t r = ((color >> 11) & 0x1F) << 3;
+                uint8_t g = ((color >> 5) & 0x3F) << 2;
+                uint8_t b = (color & 0x1F) << 3;
+
+                r = r * level / steps;
+                g = g * level / steps;
+                b = b * level / steps;
+
+                dma_display->drawPixel(x, y, dma_display->color565(r, g, b));
+            }
+        }
+        stepDone();
+    }
+}
+
+// ---- Comparacion ----
+
+static void fillRandom(uint8_t* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) buf[i] = esp_random();
+}
+
+// Pantalla de partida: la misma para las dos versiones
+static void restoreStart() {
+    memcpy(screenBuffer, startScreen, sizeof(screenBuffer));
+    memcpy(panel, startScreen, sizeof(panel));
+}
+
+// Corre la version bloqueante y la cooperativa desde la misma pantalla; 0 si
+// la cooperativa muestra, en orden, la pantalla de cada paso de la bloqueante
+// y acaba con el mismo screenBuffer. Un paso que no cabe en un tick deja una
+// pantalla a medias entre dos pasos: esas no cuentan.
+static int compare(const char* name, void (*blocking)(), void (*start)()) {
+    restoreStart();
+    refStepCount = 0;
+    blocking();
+    memcpy(refScreen, screenBuffer, sizeof(screenBuffer));
+    if (refStepCount > MAX_STEPS) {
+        TEST_LOG("%s: FALLO (%d pasos, maximo %d)", name, refStepCount, MAX_STEPS);
+        return 1;
+    }
+
+    restoreStart();
+    transitionDone = false;
+    start();
+    unsigned long t0 = millis();
+    int ticks = 0;
+    int seen = 0; // pasos de la bloqueante ya vistos en el panel
+    while (transitionActive() && millis() - t0 < 10000) {
+        updateTransition();
+        ticks++;
+        uint32_t crc = panelCrc();
+        while (seen < refStepCount && crc == refSteps[seen]) seen++;
+        delay(1);
+    }
+
+    int screenDiff = 0;
+    for (int y = 0; y < PANEL_RES_Y; y++) {
+        for (int x = 0; x < PANEL_RES_X; x++) {
+            if (screenBuffer[y][x] != refScreen[y][x]) screenDiff++;
+        }
+    }
+    bool ok = transitionDone && seen == refStepCount && screenDiff == 0;
+    if (!ok) {
+        TEST_LOG("%s: FALLO (terminada: %s, %d/%d pasos iguales, %d px distintos en screenBuffer)", name,
+                 transitionDone ? "si" : "NO", seen, refStepCount, screenDiff);
+    } else {
+        TEST_LOG("%s: OK, %d pasos en %d ticks, %lums", name, refStepCount, ticks, millis() - t0);
+    }
+    return ok ? 0 : 1;
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(3000);
+
+    TEST_LOG("==== TRANSITION TEST ====");
+    HUB75_I2S_CFG mxconfig(PANEL_RES_X, PANEL_RES_Y, PANEL_CHAIN);
+    dma_display = new CapturePanel(mxconfig);
+
+    int fails = 0;
+    for (int trial = 0; trial < TRIALS; trial++) {
+        fillRandom((uint8_t*)startScreen, sizeof(startScreen));
+        fillRandom((uint8_t*)photo565, sizeof(photo565));
+        fillRandom(cover, sizeof(cover));
+
+        fails += compare("push-up", blockingPushUp, [] { transitionStartPushUp(cover, onTransitionDone); });
+        fails += compare("revelado", blockingCenterReveal, [] { transitionStartCenterReveal(onTransitionDone); });
+        fails += compare("fundido a negro", [] { blockingFade(false); },
+                         [] { transitionStartFade(false, onTransitionDone); });
+        fails += compare("fundido desde negro", [] { blockingFade(true); },
+                         [] { transitionStartFade(true, onTransitionDone); });
+    }
+    TEST_LOG("Pantalla final: %s (%d fallos en %d pruebas)", fails == 0 ? "OK" : "FALLO", fails, TRIALS);
+    TEST_LOG("==== FIN ====");
+}
+
+void loop() {
+    delay(1000);
+}
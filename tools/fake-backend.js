@@ -0,0 +1,337 @@
+#!/usr/bin/env node
+/**
+ * Backend minimo para probar el formato de foto negociado sin el servidor real.
+ *
+ * Escucha frame/+/request/photo y responde en frame/<id>/response/photo con
+ * una imagen local, eligiendo el primer formato del array "enc" del request
+ * cuyo binario quepa en "maxBytes":
+ *
+ *   {"title":"x","author":"y","reqId":N,"enc":"qoi"}\n[binario]
+ *
+ *   raw888: 64x64x3 en orden GBR (12288 bytes)
+ *   rgb565: 64x64x2 big-endian (8192 bytes)
+ *   qoi:    imagen QOI 64x64 RGB (tamano variable)
+ *
+ * Uso:
+ *   node fake-backend.js <imagen> [opciones]
+ *
+ * Opciones:
+ *   -b, --broker <url>       Broker MQTT (default: mqtt://localhost:1883)
+ *   -t, --title <texto>      Título de la imagen
+ *   -u, --username <texto>   Nombre de usuario
+ *   --enc <formato>          Forzar formato (raw888, rgb565, qoi)
+ *   --anim <frames>          Servir la imagen como animacion de N frames (se
+ *                            desplaza en horizontal); frames completos RGB565
+ *   --fps <n>                FPS de la animacion (default: 10)
+ *   --range                  Ofrecer peticiones de rango (request/animation/frames)
+ *   --loss <0..1>            Probabilidad de perder cada respuesta de frame
+ *   --latency <ms>           Retardo de cada respuesta de frame
+ *   --jitter <ms>            Retardo extra aleatorio (0..jitter)
+ *
+ * Las fotos estaticas llevan "etag" (hash de la imagen): si el request trae
+ * el mismo, se responde {"reqId":N,"notModified":true} sin binario.
+ *
+ * Con --loss/--latency se compara la descarga de frames del firmware en
+ * condiciones de red malas ([Diag] Ventana / Descarga en el log serie).
+ */
+
+const sharp = require('sharp');
+const mqtt = require('mqtt');
+const fs = require('fs');
+const crypto = require('crypto');
+
+const QOI_OP_INDEX = 0x00;
+const QOI_OP_DIFF = 0x40;
+const QOI_OP_LUMA = 0x80;
+const QOI_OP_RUN = 0xc0;
+const QOI_OP_RGB = 0xfe;
+
+// Codificador QOI (RGB, 3 canales) segun la especificacion de qoiformat.org
+function encodeQoi(rgb, width, height) {
+    const out = [];
+    const header = Buffer.alloc(14);
+    header.write('qoif', 0, 'ascii');
+    header.writeUInt32BE(width, 4);
+    header.writeUInt32BE(height, 8);
+    header[12] = 3; // canales
+    header[13] = 0; // sRGB
+    out.push(...header);
+
+    const index = new Array(64).fill(null).map(() => [0, 0, 0, 0]);
+    let prev = [0, 0, 0, 255];
+    let run = 0;
+    const pixels = width * height;
+
+    for (let i = 0; i < pixels; i++) {
+        const px = [rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], 255];
+        const same = px[0] === prev[0] && px[1] === prev[1] && px[2] === prev[2];
+
+        if (same) {
+            run++;
+            if (run === 62 || i === pixels - 1) {
+                out.push(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push(QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        const hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        const cached = index[hash];
+        if (cached[0] === px[0] && cached[1] === px[1] && cached[2] === px[2] && cached[3] === px[3]) {
+            out.push(QOI_OP_INDEX | hash);
+        } else {
+            index[hash] = px;
+            const vr = ((px[0] - prev[0] + 384) % 256) - 128;
+            const vg = ((px[1] - prev[1] + 384) % 256) - 128;
+            const vb = ((px[2] - prev[2] + 384) % 256) - 128;
+            const vgr = vr - vg;
+            const vgb = vb - vg;
+
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                out.push(QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+            } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                out.push(QOI_OP_LUMA | (vg + 32), ((vgr + 8) << 4) | (vgb + 8));
+            } else {
+                out.push(QOI_OP_RGB, px[0], px[1], px[2]);
+            }
+        }
+        prev = px;
+    }
+
+    out.push(0, 0, 0, 0, 0, 0, 0, 1);
+    return Buffer.from(out);
+}
+
+function encodeRgb565(rgb) {
+    const out = Buffer.alloc((rgb.length / 3) * 2);
+    for (let i = 0, o = 0; i < rgb.length; i += 3, o += 2) {
+        out.writeUInt16BE(((rgb[i] & 0xf8) << 8) | ((rgb[i + 1] & 0xfc) << 3) | (rgb[i + 2] >> 3), o);
+    }
+    return out;
+}
+
+function encodeRaw888(rgb) {
+    const out = Buffer.alloc(rgb.length);
+    for (let i = 0; i < rgb.length; i += 3) {
+        out[i] = rgb[i + 1];
+        out[i + 1] = rgb[i + 2];
+        out[i + 2] = rgb[i];
+    }
+    return out;
+}
+
+// Frame i de la animacion sintetica: la imagen desplazada i*2 px a la izquierda
+function animationFrame(rgb, i) {
+    const shifted = Buffer.alloc(rgb.length);
+    const dx = (i * 2) % 64;
+    for (let y = 0; y < 64; y++) {
+        for (let x = 0; x < 64; x++) {
+            rgb.copy(shifted, (y * 64 + x) * 3, (y * 64 + ((x + dx) % 64)) * 3, (y * 64 + ((x + dx) % 64)) * 3 + 3);
+        }
+    }
+    return encodeRgb565(shifted);
+}
+
+// Respuesta de un frame: [indice u8][total u8][animationId u16][RGB565 64x64]
+function frameMessage(frames, animationId, index) {
+    const header = Buffer.from([index, frames.length, (animationId >> 8) & 0xff, animationId & 0xff]);
+    return Buffer.concat([header, frames[index]]);
+}
+
+const encoders = { qoi: encodeQoi, rgb565: encodeRgb565, raw888: encodeRaw888 };
+
+// Primer formato aceptado que quepa; sin "enc" en el request = firmware antiguo (raw888)
+function pickEncoding(request, encoded, forced) {
+    if (forced) return forced;
+    const accepted = Array.isArray(request.enc) ? request.enc : ['raw888'];
+    const maxBytes = request.maxBytes || Infinity;
+    for (const enc of accepted) {
+        if (encoded[enc] && encoded[enc].length <= maxBytes) return enc;
+    }
+    return null;
+}
+
+async function loadImage(inputPath) {
+    const image = sharp(fs.readFileSync(inputPath)).rotate();
+    const metadata = await image.metadata();
+    const size = Math.min(metadata.width, metadata.height);
+    return image
+        .extract({
+            left: Math.floor((metadata.width - size) / 2),
+            top: Math.floor((metadata.height - size) / 2),
+            width: size,
+            height: size
+        })
+        .resize(64, 64)
+        .removeAlpha()
+        .raw()
+        .toBuffer();
+}
+
+function parseArgs(args) {
+    const options = {
+        broker: 'mqtt://localhost:1883', title: '', username: '',
+        anim: 0, fps: 10, range: false, loss: 0, latency: 0, jitter: 0
+    };
+    for (let i = 0; i < args.length; i++) {
+        const arg = args[i];
+        if (arg === '-b' || arg === '--broker') {
+            options.broker = args[++i];
+        } else if (arg === '-t' || arg === '--title') {
+            options.title = args[++i];
+        } else if (arg === '-u' || arg === '--username') {
+            options.username = args[++i];
+        } else if (arg === '--enc') {
+            options.enc = args[++i];
+        } else if (arg === '--anim') {
+            options.anim = parseInt(args[++i], 10);
+        } else if (arg === '--fps') {
+            options.fps = parseInt(args[++i], 10);
+        } else if (arg === '--range') {
+            options.range = true;
+        } else if (arg === '--loss') {
+            options.loss = parseFloat(args[++i]);
+        } else if (arg === '--latency') {
+            options.latency = parseInt(args[++i], 10);
+        } else if (arg === '--jitter') {
+            options.jitter = parseInt(args[++i], 10);
+        } else if (!arg.startsWith('-')) {
+            options.inputPath = arg;
+        }
+    }
+    return options;
+}
+
+async function main() {
+    const options = parseArgs(process.argv.slice(2));
+    if (!options.inputPath) {
+        console.error('Uso: node fake-backend.js <imagen> [-b broker] [-t titulo] [-u usuario] [--enc formato] ' +
+                      '[--anim frames] [--fps n] [--range] [--loss p] [--latency ms] [--jitter ms]');
+        process.exit(1);
+    }
+    if (options.enc && !encoders[options.enc]) {
+        console.error(`Error: formato desconocido "${options.enc}"`);
+        process.exit(1);
+    }
+
+    const rgb = await loadImage(options.inputPath);
+    const encoded = {
+        qoi: encodeQoi(rgb, 64, 64),
+        rgb565: encodeRgb565(rgb),
+        raw888: encodeRaw888(rgb)
+    };
+    const etag = crypto.createHash('sha1').update(rgb).update(options.title + '\0' + options.username)
+        .digest('hex').slice(0, 16);
+    for (const [enc, buf] of Object.entries(encoded)) {
+        console.log(`  ${enc}: ${buf.length} bytes`);
+    }
+
+    const animationId = 1;
+    const frames = [];
+    for (let i = 0; i < options.anim; i++) frames.push(animationFrame(rgb, i));
+
+    const client = mqtt.connect(options.broker);
+    client.on('connect', () => {
+        console.log(`Conectado a ${options.broker}, esperando frame/+/request/photo`);
+        client.subscribe(['frame/+/request/photo', 'frame/+/request/animation/frame', 'frame/+/request/animation/frames']);
+    });
+
+    // Red mala simulada: cada respuesta de frame se pierde o se retrasa
+    let sent = 0;
+    let dropped = 0;
+    function publishFrame(topic, payload) {
+        if (Math.random() < options.loss) {
+            dropped++;
+            return;
+        }
+        sent++;
+        setTimeout(() => client.publish(topic, payload), options.latency + Math.random() * options.jitter);
+    }
+
+    function handleFrameRequest(frameId, request) {
+        if (request.animationId !== animationId || !(request.frame < frames.length)) return;
+        // Sin deltas: un frame completo siempre es valido aunque pida deltaFrom
+        publishFrame(`frame/${frameId}/response/animation/frame`, frameMessage(frames, animationId, request.frame));
+    }
+
+    // Rango: paquetes [animationId u16][n u8] n x [tipo u8][len u16][frame] de hasta maxBytes
+    function handleRangeRequest(frameId, request) {
+        if (request.animationId !== animationId) return;
+        const step = request.step || 1;
+        const maxBytes = request.maxBytes || Infinity;
+        let entries = [];
+        let size = 3;
+        const flush = () => {
+            if (!entries.length) return;
+            const header = Buffer.from([(animationId >> 8) & 0xff, animationId & 0xff, entries.length]);
+            publishFrame(`frame/${frameId}/response/animation/frames`, Buffer.concat([header, ...entries]));
+            entries = [];
+            size = 3;
+        };
+        for (let i = request.from; i <= request.to && i < frames.length; i += step) {
+            const msg = frameMessage(frames, animationId, i);
+            const entry = Buffer.concat([Buffer.from([0, (msg.length >> 8) & 0xff, msg.length & 0xff]), msg]);
+            if (size + entry.length > maxBytes) flush();
+            entries.push(entry);
+            size += entry.length;
+        }
+        flush();
+    }
+
+    client.on('message', (topic, message) => {
+        const frameId = topic.split('/')[1];
+        let request = {};
+        try {
+            request = JSON.parse(message.toString());
+        } catch (err) {
+            console.error(`Request invalido de frame ${frameId}: ${message}`);
+            return;
+        }
+
+        if (topic.endsWith('/request/animation/frame')) {
+            handleFrameRequest(frameId, request);
+            return;
+        }
+        if (topic.endsWith('/request/animation/frames')) {
+            handleRangeRequest(frameId, request);
+            console.log(`Frame ${frameId}: rango ${request.from}-${request.to} (enviados ${sent}, perdidos ${dropped})`);
+            return;
+        }
+
+        const enc = pickEncoding(request, encoded, options.enc);
+        if (!enc) {
+            console.error(`Frame ${frameId}: ningun formato de ${JSON.stringify(request.enc)} cabe en ${request.maxBytes} bytes`);
+            return;
+        }
+
+        if (!frames.length && request.etag === etag) {
+            const notModified = { reqId: request.reqId, notModified: true };
+            client.publish(`frame/${frameId}/response/photo`, Buffer.from(JSON.stringify(notModified) + '\n'));
+            console.log(`Frame ${frameId}: reqId=${request.reqId} -> notModified`);
+            return;
+        }
+
+        const header = { title: options.title, author: options.username, reqId: request.reqId };
+        if (!frames.length) header.etag = etag;
+        if (frames.length) {
+            Object.assign(header, { animation: true, animationId, totalFrames: frames.length, fps: options.fps });
+            if (options.range && request.animRange) header.frameRange = true;
+            sent = 0;
+            dropped = 0;
+        }
+        if (enc !== 'raw888' || Array.isArray(request.enc)) header.enc = enc;
+        const payload = Buffer.concat([Buffer.from(JSON.stringify(header) + '\n'), encoded[enc]]);
+        client.publish(`frame/${frameId}/response/photo`, payload);
+        console.log(`Frame ${frameId}: reqId=${request.reqId} -> ${enc}, ${payload.length} bytes`);
+    });
+}
+
+if (require.main === module) {
+    main();
+}
+
+module.exports = { encodeQoi, encodeRgb565, encodeRaw888 };